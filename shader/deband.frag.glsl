@@ -23,13 +23,12 @@
  * SOFTWARE.
  */
 #version 450
+#extension  GL_GOOGLE_include_directive : require
 
 layout(set=0, binding=0) uniform sampler2D img;
 
-layout(constant_id = 0) const float screenWidth = 1920;
-layout(constant_id = 1) const float screenHeight = 1080;
-layout(constant_id = 2) const float reverseScreenWidth = 1.0/1920.0;
-layout(constant_id = 3) const float reverseScreenHeight = 1.0/1080.0;
+#include "screen_size.h"
+
 layout(constant_id = 4) const float debandAvgdiff = 3.4;
 layout(constant_id = 5) const float debandMaxdiff = 6.8;
 layout(constant_id = 6) const float debandMiddiff = 3.3;
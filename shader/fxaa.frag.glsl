@@ -12,8 +12,8 @@ layout(set=0, binding=0) uniform sampler2D img;
 layout (constant_id = 0) const float fxaaQualitySubpix = 0.75;
 layout (constant_id = 1) const float fxaaQualityEdgeThreshold = 0.125;
 layout (constant_id = 2) const float fxaaQualityEdgeThresholdMin = 0.0312;
-layout (constant_id = 3) const float screenWidth = 1920;
-layout (constant_id = 4) const float screenHeight = 1080;
+
+#include "screen_size.h"
 
 layout(location = 0) in vec2 textureCoord;
 layout(location = 0) out vec4 fragColor;
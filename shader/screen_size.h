@@ -0,0 +1,8 @@
+//the size of the swapchain images, pushed when the effect is recorded so the pipelines do not depend on it
+layout(push_constant) uniform ScreenSize
+{
+    float screenWidth;
+    float screenHeight;
+    float reverseScreenWidth;
+    float reverseScreenHeight;
+};
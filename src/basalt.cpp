@@ -32,13 +32,18 @@
 #include "vulkan/vk_dispatch_table_helper.h"
 
 #include <mutex>
-#include <map>
+#include <shared_mutex>
 #include <vector>
-#include <unordered_map>
 #include <iostream>
 #include <string>
 #include <memory>
 #include <cstring>
+#include <array>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <future>
 
 #include "image_view.hpp"
 #include "sampler.hpp"
@@ -51,6 +56,13 @@
 #include "config.hpp"
 #include "fake_swapchain.hpp"
 #include "renderpass.hpp"
+#include "image.hpp"
+#include "handle_map.hpp"
+#include "logical_device.hpp"
+#include "memory_budget.hpp"
+#include "logger.hpp"
+#include "keyboard_input.hpp"
+#include "thread_pool.hpp"
 
 #include "effect.hpp"
 #include "effect_fxaa.hpp"
@@ -67,11 +79,14 @@
         }
 #endif
 
-std::mutex globalLock;
 #ifdef _GCC_
 typedef std::lock_guard<std::mutex> scoped_lock __attribute__((unused)) ;
+typedef std::shared_lock<std::shared_mutex> read_lock __attribute__((unused)) ;
+typedef std::unique_lock<std::shared_mutex> write_lock __attribute__((unused)) ;
 #else
 typedef std::lock_guard<std::mutex> scoped_lock;
+typedef std::shared_lock<std::shared_mutex> read_lock;
+typedef std::unique_lock<std::shared_mutex> write_lock;
 #endif
 
 template<typename DispatchableType>
@@ -82,62 +97,523 @@ void *GetKey(DispatchableType inst)
 
 std::shared_ptr<vkBasalt::Config> pConfig = nullptr;
 
+//switched by the toggle key, presents submit the copy command buffers while it is false
+std::atomic<bool> effectsEnabled{true};
+
 
 
 // layer book-keeping information, to store dispatch tables by key
-std::map<void *, VkLayerInstanceDispatchTable> instance_dispatch;
-std::map<void *, VkLayerDispatchTable> device_dispatch;
+// the handle maps are read without locking, they are only written on create/destroy
+typedef struct {
+    VkLayerInstanceDispatchTable dispatchTable;
+    uint32_t apiVersion;//the version the application requested, VK_API_VERSION_1_0 if it did not say
+} InstanceStruct;
+
+vkBasalt::HandleMap<InstanceStruct> instanceMap;
 
+vkBasalt::HandleMap<std::shared_ptr<vkBasalt::LogicalDevice>> deviceMap;
 
 //for each swapchain, we have the Images and the other stuff we need to execute the compute shader
-typedef struct {
-    VkDevice device;
+//the members QueuePresentKHR reads come first, so a present only touches the start of the record
+typedef struct alignas(64) {
+    vkBasalt::LogicalDevice* pLogicalDevice;
+    bool passthrough;//no effects, the application gets the real images and presents go straight down the chain
+    uint32_t imageCount;
+    bool copyImages;//the surface allows TRANSFER_DST, without it the effects can neither be toggled off nor built in the background
+    std::vector<bool> queueFamilies;//the queue families the command buffers are recorded for, fixed with imageCount
+    std::vector<std::vector<VkCommandBuffer>> commandBufferLists;//indexed by queue family, empty for families without a command pool
+    std::vector<std::vector<VkCommandBuffer>> copyCommandBufferLists;//same layout, copy the application's image into the swapchain image, empty without copyImages
+    std::atomic<bool> effectsReady;//commandBufferLists is recorded, until then presents submit the copy command buffers
+    std::vector<VkSemaphore> semaphoreList;
+    VkSemaphore lastTimelineSemaphore;//the timeline and value of the last frame that ran the effects, VK_NULL_HANDLE without timeline semaphores
+    uint64_t lastFrameValue;
+    std::shared_mutex lock;//taken shared by QueuePresentKHR, exclusive while the images and effects are (re)built
+    std::shared_ptr<vkBasalt::LogicalDevice> pLogicalDeviceRef;//keeps the device context alive as long as the swapchain
     VkSwapchainCreateInfoKHR swapchainCreateInfo;
     VkExtent2D imageExtent;
     VkFormat format;
-    uint32_t imageCount;
+    std::vector<std::string> effectStrings;//after the memory budget planning
+    bool sharedIntermediates;//one image per intermediate set for all swapchain images
+    std::shared_ptr<vkBasalt::Config> pConfig;//the global config, or a copy with the overrides of the memory budget planning
     std::vector<VkImage> imageList;
     std::vector<VkImage> fakeImageList;
-    std::vector<VkCommandBuffer> commandBufferList;
-    std::vector<VkSemaphore> semaphoreList;
     std::vector<std::shared_ptr<vkBasalt::Effect>> effectList;
-    VkDeviceMemory fakeImageMemory;
+    std::vector<std::shared_ptr<vkBasalt::EffectState>> oldEffectStates;//from the effects of the old swapchain, by effect index, null where the effect changed
+    std::vector<vkBasalt::MemoryAllocation> fakeImageMemory;
+    std::vector<uint64_t> resourceOwners;//the fake images first, then one per effect, see ResourceTracker
+    std::shared_future<void> effectBuild;//the background build with asyncEffectBuild, shared since recreations wait for it under the shared lock
 } SwapchainStruct;
 
+vkBasalt::HandleMap<SwapchainStruct> swapchainMap;
+
+//what a destroyed swapchain leaves behind, on a device without timeline semaphores nothing tells when its last frame finished,
+//so it is kept until every queue the device had at that point was idle, see vkDeviceWaitIdle and vkQueueWaitIdle
+typedef struct {
+    vkBasalt::LogicalDevice* pLogicalDevice;
+    uint64_t number;//in the order the swapchains were retired, a wait only covers the ones retired before it started
+    std::vector<VkQueue> busyQueues;//the queues that were not idle since
+    std::vector<std::shared_ptr<vkBasalt::Effect>> effectList;
+    std::vector<std::vector<VkCommandBuffer>> commandBufferLists;
+    std::vector<std::vector<VkCommandBuffer>> copyCommandBufferLists;
+    std::vector<VkImage> fakeImageList;
+    std::vector<vkBasalt::MemoryAllocation> fakeImageMemory;
+    std::vector<uint64_t> resourceOwners;
+    std::vector<VkSemaphore> semaphoreList;
+} RetiredSwapchain;
+
+std::mutex retiredLock;//guards retiredSwapchains and nextRetiredNumber
+std::vector<RetiredSwapchain> retiredSwapchains;
+uint64_t nextRetiredNumber = 0;
+
+//scratch storage for QueuePresentKHR, so a present does not need to allocate
+//the queue is externally synchronized for vkQueuePresentKHR, so the record needs no lock
+//
+//with timeline semaphores every present that runs the effects signals frameValue+1 on timelineSemaphore,
+//reading the counter tells which frames the gpu finished without fences or waiting for the queue
 typedef struct {
-    VkQueue queue;
-    uint32_t queueFamilyIndex;
-    VkPhysicalDevice physicalDevice;
-    VkCommandPool commandPool;
-} DeviceStruct;
+    vkBasalt::LogicalDevice* pLogicalDevice;
+    uint32_t queueFamilyIndex;//VK_QUEUE_FAMILY_IGNORED if the effects can not run on this queue
+    std::vector<SwapchainStruct*> swapchainStructs;//of every swapchain in the present, looked up once
+    std::vector<bool> runEffects;//by swapchain, false submits the copy
+    std::vector<VkCommandBuffer> commandBuffers;
+    std::vector<VkSemaphore> presentSemaphores;//the binary semaphore of each swapchain, followed by timelineSemaphore
+    std::vector<VkPipelineStageFlags> waitStages;
+    std::vector<VkSemaphore> waitSemaphores;
+    std::vector<uint64_t> waitValues;
+    std::vector<uint64_t> signalValues;
+    VkSemaphore timelineSemaphore;
+    uint64_t frameValue;//last value submitted
+    uint64_t completedValue;//last value the gpu was seen to reach
+    std::array<std::chrono::steady_clock::time_point, 16> submitTimes;//indexed by frame value modulo the size
+    std::chrono::steady_clock::duration latencySum;
+    uint32_t latencyCount;
+} QueueStruct;
 
-std::unordered_map<VkDevice, DeviceStruct> deviceMap;
-std::unordered_map<VkSwapchainKHR, SwapchainStruct> swapchainMap;
+vkBasalt::HandleMap<QueueStruct> queueMap;
 
 namespace vkBasalt{
+    QueueStruct& createQueueStruct(LogicalDevice* pLogicalDevice, VkQueue queue, uint32_t queueFamilyIndex)
+    {
+        //most presents carry one swapchain and one or two wait semaphores, more only cost a resize the first time
+        QueueStruct& queueStruct = queueMap.insert(queue);
+        queueStruct.pLogicalDevice = pLogicalDevice;
+        queueStruct.queueFamilyIndex = queueFamilyIndex;
+        queueStruct.swapchainStructs.reserve(4);
+        queueStruct.runEffects.reserve(4);
+        queueStruct.commandBuffers.reserve(4);
+        queueStruct.presentSemaphores.reserve(4);
+        //the effects read the fake image in the fragment shader, but the plain copy reads it in a transfer
+        queueStruct.waitStages.resize(4, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+        queueStruct.waitSemaphores.reserve(4);
+        queueStruct.waitValues.reserve(4);
+        queueStruct.signalValues.reserve(4);
+        queueStruct.timelineSemaphore = pLogicalDevice->timelineSemaphores ? createTimelineSemaphore(pLogicalDevice, 0) : VK_NULL_HANDLE;
+        queueStruct.frameValue = 0;
+        queueStruct.completedValue = 0;
+        queueStruct.latencySum = std::chrono::steady_clock::duration::zero();
+        queueStruct.latencyCount = 0;
+        pLogicalDevice->queues.push_back(queue);
+        return queueStruct;
+    }
+
+    //the time from submitting the effects to seeing them finished, the cpu only looks once per present
+    //so this is an upper bound that includes the time until the next present
+    void accountFinishedFrames(LogicalDevice* pLogicalDevice, QueueStruct& queueStruct)
+    {
+        uint64_t completedValue;
+        if(pLogicalDevice->dispatchTable.GetSemaphoreCounterValue(pLogicalDevice->device, queueStruct.timelineSemaphore, &completedValue) != VK_SUCCESS)
+        {
+            return;
+        }
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        uint64_t ringSize = queueStruct.submitTimes.size();
+        //frames that are older than the ring had their submit time overwritten
+        uint64_t firstValue = queueStruct.completedValue + 1;
+        if(queueStruct.frameValue >= ringSize)
+        {
+            firstValue = std::max(firstValue, queueStruct.frameValue - ringSize + 1);
+        }
+        for(uint64_t value=firstValue;value<=completedValue;value++)
+        {
+            queueStruct.latencySum += now - queueStruct.submitTimes[value % ringSize];
+            queueStruct.latencyCount++;
+        }
+        queueStruct.completedValue = completedValue;
+
+        //the uploads this queue submitted in front of a finished frame are done as well
+        if(pLogicalDevice->uploadsSubmitted.load(std::memory_order_acquire))
+        {
+            freeFinishedUploads(pLogicalDevice, queueStruct.timelineSemaphore, completedValue);
+        }
+
+        if(queueStruct.latencyCount >= 600)
+        {
+            std::chrono::duration<double, std::milli> average = queueStruct.latencySum / queueStruct.latencyCount;
+            vkBasalt::Logger::debug("effects finished ", average.count(), " ms after submit on average");
+            queueStruct.latencySum = std::chrono::steady_clock::duration::zero();
+            queueStruct.latencyCount = 0;
+        }
+    }
+
+    //asks the X server at most every 20 ms, one present at a time does the asking and the others skip it
+    //the time slot alone is not enough, a query that takes longer than 20 ms would overlap with the next one
+    void pollToggleKey()
+    {
+        static uint32_t toggleKey = convertToKeySym(pConfig->getOption("toggleKey", "Home"));
+        static std::atomic<int64_t> nextPoll{0};
+        static std::atomic<bool> polling{false};
+        static bool wasPressed = false;//only touched while holding polling, which orders it between the polls
+        if(toggleKey == 0)
+        {
+            return;
+        }
+
+        int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        if(now < nextPoll.load(std::memory_order_relaxed) || polling.exchange(true, std::memory_order_acquire))
+        {
+            return;
+        }
+        //another present may have polled between the check and taking the flag
+        if(now < nextPoll.load(std::memory_order_relaxed))
+        {
+            polling.store(false, std::memory_order_release);
+            return;
+        }
+        nextPoll.store(now + 20, std::memory_order_relaxed);
+
+        bool pressed = isKeyPressed(toggleKey);
+        if(pressed && !wasPressed)
+        {
+            bool enabled = !effectsEnabled.load(std::memory_order_relaxed);
+            effectsEnabled.store(enabled, std::memory_order_relaxed);
+            Logger::debug("effects ", enabled ? "enabled" : "disabled");
+        }
+        wasPressed = pressed;
+        polling.store(false, std::memory_order_release);
+    }
+}
+
+namespace vkBasalt{
+    void freeRetiredSwapchain(RetiredSwapchain& retired)
+    {
+        vkBasalt::LogicalDevice* pLogicalDevice = retired.pLogicalDevice;
+        VkDevice device = pLogicalDevice->device;
+        VkLayerDispatchTable& dispatchTable = pLogicalDevice->dispatchTable;
+        retired.effectList.clear();
+        {
+            scoped_lock l(pLogicalDevice->lock);
+            //a failed background build may have left the effect command buffers out
+            for(uint32_t i=0;i<retired.commandBufferLists.size();i++)
+            {
+                if(!retired.commandBufferLists[i].empty())
+                {
+                    dispatchTable.FreeCommandBuffers(device,pLogicalDevice->commandPools[i],retired.commandBufferLists[i].size(), retired.commandBufferLists[i].data());
+                }
+            }
+            for(uint32_t i=0;i<retired.copyCommandBufferLists.size();i++)
+            {
+                if(!retired.copyCommandBufferLists[i].empty())
+                {
+                    dispatchTable.FreeCommandBuffers(device,pLogicalDevice->commandPools[i],retired.copyCommandBufferLists[i].size(), retired.copyCommandBufferLists[i].data());
+                }
+            }
+        }
+        vkBasalt::Logger::debug("after free commandbuffer");
+        for(uint32_t i=0;i<retired.fakeImageList.size();i++)
+        {
+            dispatchTable.DestroyImage(device,retired.fakeImageList[i],nullptr);
+        }
+        for(vkBasalt::MemoryAllocation& allocation : retired.fakeImageMemory)
+        {
+            pLogicalDevice->memoryAllocator.free(allocation);
+        }
+        pLogicalDevice->resourceTracker.remove(vkBasalt::ResourceType::Image, retired.fakeImageList);
+        //everything of the swapchain is destroyed now, whatever an owner still has is a leak
+        for(uint64_t owner : retired.resourceOwners)
+        {
+            pLogicalDevice->resourceTracker.destroyOwner(owner);
+        }
+        for(unsigned int i=0;i<retired.semaphoreList.size();i++)
+        {
+            dispatchTable.DestroySemaphore(device,retired.semaphoreList[i],nullptr);
+            vkBasalt::Logger::debug("after DestroySemaphore");
+        }
+    }
+
+    //frees the retired swapchains of the device that were retired before firstBusyNumber and whose queues are all idle now,
+    //idleQueue VK_NULL_HANDLE means the whole device was idle
+    void freeIdleSwapchains(LogicalDevice* pLogicalDevice, VkQueue idleQueue, uint64_t firstBusyNumber)
+    {
+        std::vector<RetiredSwapchain> idleSwapchains;
+        {
+            scoped_lock l(retiredLock);
+            for(auto retired = retiredSwapchains.begin(); retired != retiredSwapchains.end();)
+            {
+                if(retired->pLogicalDevice != pLogicalDevice || retired->number >= firstBusyNumber)
+                {
+                    retired++;
+                    continue;
+                }
+                std::vector<VkQueue>& busyQueues = retired->busyQueues;
+                busyQueues.erase(std::remove_if(busyQueues.begin(), busyQueues.end(), [idleQueue](VkQueue queue)
+                {
+                    return idleQueue == VK_NULL_HANDLE || queue == idleQueue;
+                }), busyQueues.end());
+                if(!busyQueues.empty())
+                {
+                    retired++;
+                    continue;
+                }
+                idleSwapchains.push_back(std::move(*retired));
+                retired = retiredSwapchains.erase(retired);
+            }
+        }
+        //the effects destroy their objects with the device lock and the caches, not under retiredLock
+        for(RetiredSwapchain& retired : idleSwapchains)
+        {
+            freeRetiredSwapchain(retired);
+        }
+    }
+
+    //the number the next retired swapchain gets, a wait that starts now covers everything below it
+    uint64_t getNextRetiredNumber()
+    {
+        scoped_lock l(retiredLock);
+        return nextRetiredNumber;
+    }
+
     void destroySwapchainStruct(SwapchainStruct& swapchainStruct)
     {
-        VkDevice device = swapchainStruct.device;
-        VkLayerDispatchTable& dispatchTable = device_dispatch[GetKey(device)];
+        vkBasalt::LogicalDevice* pLogicalDevice = swapchainStruct.pLogicalDevice;
+        VkDevice device = pLogicalDevice->device;
+        VkLayerDispatchTable& dispatchTable = pLogicalDevice->dispatchTable;
+        if(swapchainStruct.effectBuild.valid())
+        {
+            swapchainStruct.effectBuild.wait();
+        }
         if(swapchainStruct.imageCount>0)
         {
-            swapchainStruct.effectList.clear();
-            dispatchTable.FreeCommandBuffers(device,deviceMap[device].commandPool,swapchainStruct.imageCount, swapchainStruct.commandBufferList.data());
-            std::cout << "after free commandbuffer" << std::endl;
-            dispatchTable.FreeMemory(device,swapchainStruct.fakeImageMemory,nullptr);
-            for(uint32_t i=0;i<swapchainStruct.fakeImageList.size();i++)
+            RetiredSwapchain retired;
+            retired.pLogicalDevice = pLogicalDevice;
+            retired.effectList = std::move(swapchainStruct.effectList);
+            retired.commandBufferLists = std::move(swapchainStruct.commandBufferLists);
+            retired.copyCommandBufferLists = std::move(swapchainStruct.copyCommandBufferLists);
+            retired.fakeImageList = std::move(swapchainStruct.fakeImageList);
+            retired.fakeImageMemory = std::move(swapchainStruct.fakeImageMemory);
+            retired.resourceOwners = std::move(swapchainStruct.resourceOwners);
+            retired.semaphoreList = std::move(swapchainStruct.semaphoreList);
+            //the effects of the last frame may still run, everything before it finished in order
+            if(swapchainStruct.lastTimelineSemaphore != VK_NULL_HANDLE)
             {
-                dispatchTable.DestroyImage(device,swapchainStruct.fakeImageList[i],nullptr);
+                VkSemaphoreWaitInfo waitInfo;
+                waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+                waitInfo.pNext = nullptr;
+                waitInfo.flags = 0;
+                waitInfo.semaphoreCount = 1;
+                waitInfo.pSemaphores = &swapchainStruct.lastTimelineSemaphore;
+                waitInfo.pValues = &swapchainStruct.lastFrameValue;
+                dispatchTable.WaitSemaphores(device, &waitInfo, UINT64_MAX);
             }
-            for(unsigned int i=0;i<swapchainStruct.imageCount;i++)
+            if(pLogicalDevice->timelineSemaphores)
             {
-                dispatchTable.DestroySemaphore(device,swapchainStruct.semaphoreList[i],nullptr);
-                std::cout << "after DestroySemaphore" << std::endl;
+                freeRetiredSwapchain(retired);
+                return;
+            }
+            //without timeline semaphores the layer can not wait without fences or idling a queue the application may use,
+            //so everything waits for the application to idle the queues, at the latest in vkDestroyDevice
+            {
+                scoped_lock deviceLock(pLogicalDevice->lock);
+                retired.busyQueues = pLogicalDevice->queues;
+            }
+            scoped_lock l(retiredLock);
+            retired.number = nextRetiredNumber++;
+            retiredSwapchains.push_back(std::move(retired));
+            static std::atomic<bool> reported{false};
+            if(!reported.exchange(true))
+            {
+                vkBasalt::Logger::info("no timeline semaphores, destroyed swapchains are freed once the application waits for the device or its queues to be idle");
             }
         }
     }
 }
 
+namespace vkBasalt{
+    //returns true if the device will be created with timeline semaphores
+    //if the application did not enable them, they get added to modifiedCreateInfo, extensionNames and timelineFeatures back the new pointers
+    bool enableTimelineSemaphores(InstanceStruct& instanceStruct,
+                                  VkPhysicalDevice physicalDevice,
+                                  VkDeviceCreateInfo& modifiedCreateInfo,
+                                  std::vector<const char*>& extensionNames,
+                                  VkPhysicalDeviceTimelineSemaphoreFeatures& timelineFeatures)
+    {
+        //a feature struct the application chained decides on its own, the same struct may not be chained twice
+        for(const VkBaseInStructure* pNext = (const VkBaseInStructure*) modifiedCreateInfo.pNext; pNext; pNext = pNext->pNext)
+        {
+            if(pNext->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES)
+            {
+                return ((const VkPhysicalDeviceVulkan12Features*) pNext)->timelineSemaphore == VK_TRUE;
+            }
+            if(pNext->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES)
+            {
+                return ((const VkPhysicalDeviceTimelineSemaphoreFeatures*) pNext)->timelineSemaphore == VK_TRUE;
+            }
+        }
+
+        //the feature query needs vkGetPhysicalDeviceFeatures2 from vulkan 1.1
+        VkLayerInstanceDispatchTable& instanceDispatchTable = instanceStruct.dispatchTable;
+        if(instanceStruct.apiVersion < VK_API_VERSION_1_1 || instanceDispatchTable.GetPhysicalDeviceFeatures2 == nullptr)
+        {
+            return false;
+        }
+
+        VkPhysicalDeviceProperties properties;
+        instanceDispatchTable.GetPhysicalDeviceProperties(physicalDevice, &properties);
+        bool core = instanceStruct.apiVersion >= VK_API_VERSION_1_2 && properties.apiVersion >= VK_API_VERSION_1_2;
+        if(!core)
+        {
+            uint32_t extensionCount = 0;
+            instanceDispatchTable.EnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+            std::vector<VkExtensionProperties> extensionProperties(extensionCount);
+            instanceDispatchTable.EnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensionProperties.data());
+            bool supported = false;
+            for(uint32_t i=0;i<extensionCount;i++)
+            {
+                supported |= !std::strcmp(extensionProperties[i].extensionName, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+            }
+            if(!supported)
+            {
+                return false;
+            }
+        }
+
+        timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        timelineFeatures.pNext = nullptr;
+        timelineFeatures.timelineSemaphore = VK_FALSE;
+        VkPhysicalDeviceFeatures2 features;
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &timelineFeatures;
+        instanceDispatchTable.GetPhysicalDeviceFeatures2(physicalDevice, &features);
+        if(timelineFeatures.timelineSemaphore != VK_TRUE)
+        {
+            return false;
+        }
+
+        if(!core)
+        {
+            extensionNames.assign(modifiedCreateInfo.ppEnabledExtensionNames, modifiedCreateInfo.ppEnabledExtensionNames + modifiedCreateInfo.enabledExtensionCount);
+            if(std::none_of(extensionNames.begin(), extensionNames.end(), [](const char* name){return !std::strcmp(name, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);}))
+            {
+                extensionNames.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+            }
+            modifiedCreateInfo.enabledExtensionCount = extensionNames.size();
+            modifiedCreateInfo.ppEnabledExtensionNames = extensionNames.data();
+        }
+
+        timelineFeatures.pNext = (void*) modifiedCreateInfo.pNext;
+        modifiedCreateInfo.pNext = &timelineFeatures;
+        return true;
+    }
+
+    bool isDeviceExtensionSupported(InstanceStruct& instanceStruct, VkPhysicalDevice physicalDevice, const char* extensionName)
+    {
+        VkLayerInstanceDispatchTable& instanceDispatchTable = instanceStruct.dispatchTable;
+        uint32_t extensionCount = 0;
+        instanceDispatchTable.EnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensionProperties(extensionCount);
+        instanceDispatchTable.EnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensionProperties.data());
+        for(uint32_t i=0;i<extensionCount;i++)
+        {
+            if(!std::strcmp(extensionProperties[i].extensionName, extensionName))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //extensionNames keeps the strings alive until vkCreateDevice
+    void addDeviceExtension(VkDeviceCreateInfo& modifiedCreateInfo, std::vector<const char*>& extensionNames, const char* extensionName)
+    {
+        if(extensionNames.empty())
+        {
+            extensionNames.assign(modifiedCreateInfo.ppEnabledExtensionNames, modifiedCreateInfo.ppEnabledExtensionNames + modifiedCreateInfo.enabledExtensionCount);
+        }
+        if(std::none_of(extensionNames.begin(), extensionNames.end(), [extensionName](const char* name){return !std::strcmp(name, extensionName);}))
+        {
+            extensionNames.push_back(extensionName);
+        }
+        modifiedCreateInfo.enabledExtensionCount = extensionNames.size();
+        modifiedCreateInfo.ppEnabledExtensionNames = extensionNames.data();
+    }
+
+    bool enableMemoryBudget(InstanceStruct& instanceStruct,
+                            VkPhysicalDevice physicalDevice,
+                            VkDeviceCreateInfo& modifiedCreateInfo,
+                            std::vector<const char*>& extensionNames)
+    {
+        //the budget is read with vkGetPhysicalDeviceMemoryProperties2 from vulkan 1.1 or VK_KHR_get_physical_device_properties2
+        VkLayerInstanceDispatchTable& instanceDispatchTable = instanceStruct.dispatchTable;
+        if((instanceStruct.apiVersion < VK_API_VERSION_1_1 || instanceDispatchTable.GetPhysicalDeviceMemoryProperties2 == nullptr)
+           && instanceDispatchTable.GetPhysicalDeviceMemoryProperties2KHR == nullptr)
+        {
+            return false;
+        }
+        if(!isDeviceExtensionSupported(instanceStruct, physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME))
+        {
+            return false;
+        }
+        addDeviceExtension(modifiedCreateInfo, extensionNames, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        return true;
+    }
+
+    bool enableDedicatedAllocation(InstanceStruct& instanceStruct,
+                                   VkPhysicalDevice physicalDevice,
+                                   VkDeviceCreateInfo& modifiedCreateInfo,
+                                   std::vector<const char*>& extensionNames)
+    {
+        //both are core in vulkan 1.1, before that they are two device extensions
+        VkPhysicalDeviceProperties properties;
+        instanceStruct.dispatchTable.GetPhysicalDeviceProperties(physicalDevice, &properties);
+        if(instanceStruct.apiVersion >= VK_API_VERSION_1_1 && properties.apiVersion >= VK_API_VERSION_1_1)
+        {
+            return true;
+        }
+        if(!isDeviceExtensionSupported(instanceStruct, physicalDevice, VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME)
+           || !isDeviceExtensionSupported(instanceStruct, physicalDevice, VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME))
+        {
+            return false;
+        }
+        addDeviceExtension(modifiedCreateInfo, extensionNames, VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME);
+        addDeviceExtension(modifiedCreateInfo, extensionNames, VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME);
+        return true;
+    }
+
+    //the effects are graphics pipelines, so they can run on every graphics capable queue
+    //creates the command pool of a graphics capable queue family once, returns false for the other families
+    //the caller holds the device lock
+    bool createCommandPool(LogicalDevice* pLogicalDevice, uint32_t queueFamilyIndex)
+    {
+        const std::vector<VkQueueFamilyProperties>& queueProperties = pLogicalDevice->physicalDeviceInfo.queueFamilyProperties;
+        if(queueFamilyIndex >= queueProperties.size() || (queueProperties[queueFamilyIndex].queueFlags & VK_QUEUE_GRAPHICS_BIT) == 0)
+        {
+            return false;
+        }
+        if(pLogicalDevice->commandPools[queueFamilyIndex] == VK_NULL_HANDLE)
+        {
+            VkCommandPoolCreateInfo commandPoolCreateInfo;
+            commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            commandPoolCreateInfo.pNext = nullptr;
+            commandPoolCreateInfo.flags = 0;
+            commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+
+            vkBasalt::Logger::debug("found graphic capable queue family ", queueFamilyIndex);
+            VkResult result = pLogicalDevice->dispatchTable.CreateCommandPool(pLogicalDevice->device, &commandPoolCreateInfo, nullptr, &pLogicalDevice->commandPools[queueFamilyIndex]);
+            ASSERT_VULKAN(result);
+        }
+        return true;
+    }
+}
+
 VK_LAYER_EXPORT VkResult VKAPI_CALL vkBasalt_CreateInstance(
     const VkInstanceCreateInfo*                 pCreateInfo,
     const VkAllocationCallbacks*                pAllocator,
@@ -151,7 +627,7 @@ VK_LAYER_EXPORT VkResult VKAPI_CALL vkBasalt_CreateInstance(
     {
         layerCreateInfo = (VkLayerInstanceCreateInfo *)layerCreateInfo->pNext;
     }
-    std::cout << "interrupted create instance" << std::endl;
+    vkBasalt::Logger::debug("interrupted create instance");
     if(layerCreateInfo == NULL)
     {
     // No loader instance create info
@@ -166,14 +642,24 @@ VK_LAYER_EXPORT VkResult VKAPI_CALL vkBasalt_CreateInstance(
 
     VkResult ret = createFunc(pCreateInfo, pAllocator, pInstance);
 
+    if(ret != VK_SUCCESS)
+    {
+        return ret;
+    }
+
     // fetch our own dispatch table for the functions we need, into the next layer
-    VkLayerInstanceDispatchTable dispatchTable;
-    layer_init_instance_dispatch_table(*pInstance,&dispatchTable,gpa);
+    // and store the table by key
+    InstanceStruct& instanceStruct = instanceMap.insert(GetKey(*pInstance));
+    layer_init_instance_dispatch_table(*pInstance,&instanceStruct.dispatchTable,gpa);
+    instanceStruct.apiVersion = VK_API_VERSION_1_0;
+    if(pCreateInfo->pApplicationInfo && pCreateInfo->pApplicationInfo->apiVersion != 0)
+    {
+        instanceStruct.apiVersion = pCreateInfo->pApplicationInfo->apiVersion;
+    }
     
-    // store the table by key
     {
-        scoped_lock l(globalLock);
-        instance_dispatch[GetKey(*pInstance)] = dispatchTable;
+        static std::mutex configLock;
+        scoped_lock l(configLock);
         if(pConfig==nullptr)
         {
             pConfig = std::shared_ptr<vkBasalt::Config>(new vkBasalt::Config());
@@ -185,11 +671,10 @@ VK_LAYER_EXPORT VkResult VKAPI_CALL vkBasalt_CreateInstance(
 
 VK_LAYER_EXPORT void VKAPI_CALL vkBasalt_DestroyInstance(VkInstance instance, const VkAllocationCallbacks* pAllocator)
 {
-    scoped_lock l(globalLock);
-    VkLayerInstanceDispatchTable dispatchTable = instance_dispatch[GetKey(instance)];
-    dispatchTable.DestroyInstance(instance, pAllocator);
-    std::cout << "afer destroy instance" << std::endl;
-    instance_dispatch.erase(GetKey(instance));
+    void* key = GetKey(instance);
+    instanceMap.find(key)->dispatchTable.DestroyInstance(instance, pAllocator);
+    vkBasalt::Logger::debug("afer destroy instance");
+    instanceMap.erase(key);
 }
 
 VK_LAYER_EXPORT VkResult VKAPI_CALL vkBasalt_CreateDevice(
@@ -220,150 +705,159 @@ VK_LAYER_EXPORT VkResult VKAPI_CALL vkBasalt_CreateDevice(
 
     PFN_vkCreateDevice createFunc = (PFN_vkCreateDevice)gipa(VK_NULL_HANDLE, "vkCreateDevice");
 
-    VkResult ret = createFunc(physicalDevice, pCreateInfo, pAllocator, pDevice);
+    InstanceStruct& instanceStruct = *instanceMap.find(GetKey(physicalDevice));
+    VkDeviceCreateInfo modifiedCreateInfo = *pCreateInfo;
+    std::vector<const char*> extensionNames;
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures;
+    bool timelineSemaphores = vkBasalt::enableTimelineSemaphores(instanceStruct, physicalDevice, modifiedCreateInfo, extensionNames, timelineFeatures);
+    vkBasalt::Logger::info("timeline semaphores ", (timelineSemaphores ? "enabled" : "not available"));
+    bool memoryBudget = vkBasalt::enableMemoryBudget(instanceStruct, physicalDevice, modifiedCreateInfo, extensionNames);
+    vkBasalt::Logger::info("memory budget ", (memoryBudget ? "enabled" : "not available"));
+    bool dedicatedAllocation = vkBasalt::enableDedicatedAllocation(instanceStruct, physicalDevice, modifiedCreateInfo, extensionNames);
+    vkBasalt::Logger::debug("dedicated allocations ", (dedicatedAllocation ? "enabled" : "not available"));
+
+    VkResult ret = createFunc(physicalDevice, &modifiedCreateInfo, pAllocator, pDevice);
+    if(ret != VK_SUCCESS)
+    {
+        return ret;
+    }
     
     // fetch our own dispatch table for the functions we need, into the next layer
-    VkLayerDispatchTable dispatchTable;
-    layer_init_device_dispatch_table(*pDevice,&dispatchTable,gdpa);
-    
-    DeviceStruct deviceStruct;
-    deviceStruct.queue = VK_NULL_HANDLE;
-    deviceStruct.physicalDevice = physicalDevice;
-    deviceStruct.commandPool = VK_NULL_HANDLE;
-    
-    // store the table by key
+    // the device handle itself is the key, swapchains reach the device context through their own records
+    std::shared_ptr<vkBasalt::LogicalDevice> pLogicalDevice(new vkBasalt::LogicalDevice());
+    layer_init_device_dispatch_table(*pDevice,&pLogicalDevice->dispatchTable,gdpa);
+    //on a vulkan 1.1 device only the functions of VK_KHR_timeline_semaphore exist
+    if(pLogicalDevice->dispatchTable.GetSemaphoreCounterValue == nullptr)
     {
-        scoped_lock l(globalLock);
-        device_dispatch[GetKey(*pDevice)] = dispatchTable;
-        deviceMap[*pDevice] = deviceStruct;
-        
+        pLogicalDevice->dispatchTable.GetSemaphoreCounterValue = pLogicalDevice->dispatchTable.GetSemaphoreCounterValueKHR;
+        pLogicalDevice->dispatchTable.WaitSemaphores = pLogicalDevice->dispatchTable.WaitSemaphoresKHR;
+    }
+    if(pLogicalDevice->dispatchTable.GetImageMemoryRequirements2 == nullptr)
+    {
+        pLogicalDevice->dispatchTable.GetImageMemoryRequirements2 = pLogicalDevice->dispatchTable.GetImageMemoryRequirements2KHR;
     }
+    pLogicalDevice->instanceDispatchTable = instanceStruct.dispatchTable;
+    if(instanceStruct.apiVersion < VK_API_VERSION_1_1 || pLogicalDevice->instanceDispatchTable.GetPhysicalDeviceMemoryProperties2 == nullptr)
+    {
+        pLogicalDevice->instanceDispatchTable.GetPhysicalDeviceMemoryProperties2 = pLogicalDevice->instanceDispatchTable.GetPhysicalDeviceMemoryProperties2KHR;
+    }
+    pLogicalDevice->device = *pDevice;
+    pLogicalDevice->physicalDevice = physicalDevice;
+    vkBasalt::capturePhysicalDeviceInfo(pLogicalDevice->instanceDispatchTable, physicalDevice, pLogicalDevice->physicalDeviceInfo);
+    pLogicalDevice->memoryAllocator.init(pLogicalDevice.get());
+    pLogicalDevice->transientImagePool.init(pLogicalDevice.get());
+    pLogicalDevice->pipelineCache.init(pLogicalDevice.get());
+    pLogicalDevice->objectCache.init(pLogicalDevice.get());
+    pLogicalDevice->queue = VK_NULL_HANDLE;
+    pLogicalDevice->queueFamilyIndex = 0;
+    pLogicalDevice->commandPool = VK_NULL_HANDLE;
+    pLogicalDevice->commandPools.resize(pLogicalDevice->physicalDeviceInfo.queueFamilyProperties.size(), VK_NULL_HANDLE);
+    pLogicalDevice->timelineSemaphores = timelineSemaphores;
+    pLogicalDevice->memoryBudget = memoryBudget;
+    pLogicalDevice->dedicatedAllocation = dedicatedAllocation && pLogicalDevice->dispatchTable.GetImageMemoryRequirements2 != nullptr;
+    pLogicalDevice->uploadsPending = false;
+    pLogicalDevice->uploadsSubmitted = false;
+    pLogicalDevice->lastFrameQueue = VK_NULL_HANDLE;
+    pLogicalDevice->lastFrameSemaphore = VK_NULL_HANDLE;
+    pLogicalDevice->lastFrameValue = 0;
+    deviceMap.insert(*pDevice) = pLogicalDevice;
 
     return ret;
 }
 
 VK_LAYER_EXPORT void VKAPI_CALL vkBasalt_DestroyDevice(VkDevice device, const VkAllocationCallbacks* pAllocator)
 {
-    scoped_lock l(globalLock);
-    DeviceStruct& deviceStruct = deviceMap[device];
-    if(deviceStruct.commandPool != VK_NULL_HANDLE)
+    std::shared_ptr<vkBasalt::LogicalDevice> pLogicalDevice = *deviceMap.find(device);
+    VkLayerDispatchTable& dispatchTable = pLogicalDevice->dispatchTable;
+    //the application has to let all work finish before destroying the device, so every upload and retired swapchain is done
+    vkBasalt::freeIdleSwapchains(pLogicalDevice.get(), VK_NULL_HANDLE, UINT64_MAX);
+    vkBasalt::freeUploads(pLogicalDevice.get());
+    pLogicalDevice->transientImagePool.destroy();
+    pLogicalDevice->pipelineCache.destroy();
+    pLogicalDevice->objectCache.destroy();
+    pLogicalDevice->resourceTracker.destroyOwner(vkBasalt::ResourceTracker::deviceOwner);
+    pLogicalDevice->memoryAllocator.destroy();
+    for(VkQueue queue : pLogicalDevice->queues)
+    {
+        VkSemaphore timelineSemaphore = queueMap.find(queue)->timelineSemaphore;
+        if(timelineSemaphore != VK_NULL_HANDLE)
+        {
+            dispatchTable.DestroySemaphore(device,timelineSemaphore,nullptr);
+        }
+    }
+    for(VkCommandPool commandPool : pLogicalDevice->commandPools)
     {
-        std::cout << "DestroyCommandPool" << std::endl;
-        device_dispatch[GetKey(device)].DestroyCommandPool(device,deviceStruct.commandPool,pAllocator);
+        if(commandPool != VK_NULL_HANDLE)
+        {
+            vkBasalt::Logger::debug("DestroyCommandPool");
+            dispatchTable.DestroyCommandPool(device,commandPool,nullptr);
+        }
     }
     
-    VkLayerDispatchTable dispatchTable = device_dispatch[GetKey(device)];
     dispatchTable.DestroyDevice(device,pAllocator);
     
-    device_dispatch.erase(GetKey(device));
-    
-    std::cout << "after  Destroy Device" << std::endl;
-}
-
-VKAPI_ATTR void VKAPI_CALL vkBasalt_GetDeviceQueue(VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex, VkQueue *pQueue)
-{
-    scoped_lock l(globalLock);
-    device_dispatch[GetKey(device)].GetDeviceQueue(device,queueFamilyIndex,queueIndex,pQueue);
-    DeviceStruct& deviceStruct = deviceMap[device];
-    
-    if(deviceStruct.queue != VK_NULL_HANDLE)
+    for(VkQueue queue : pLogicalDevice->queues)
     {
-        return;//we allready have a queue
+        queueMap.erase(queue);
     }
+    deviceMap.erase(device);
     
-    //Save the first graphic capable in our deviceMap
-    uint32_t count;
-    VkBool32 graphicsCapable = VK_FALSE;
-    //TODO also check if the queue is present capable
-    instance_dispatch[GetKey(deviceStruct.physicalDevice)].GetPhysicalDeviceQueueFamilyProperties(deviceStruct.physicalDevice, &count, nullptr);
-    
-    std::vector<VkQueueFamilyProperties> queueProperties(count);
-    
-    if(count > 0)
+    vkBasalt::Logger::debug("after  Destroy Device");
+}
+
+namespace vkBasalt{
+    //vkGetDeviceQueue and vkGetDeviceQueue2 both register the queue with its family, so every queue a present can use is known
+    void registerQueue(LogicalDevice* pLogicalDevice, VkQueue queue, uint32_t queueFamilyIndex)
     {
-        instance_dispatch[GetKey(deviceStruct.physicalDevice)].GetPhysicalDeviceQueueFamilyProperties(deviceStruct.physicalDevice, &count, queueProperties.data());
-        if((queueProperties[queueFamilyIndex].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0)
+        scoped_lock l(pLogicalDevice->lock);
+        if(queueMap.find(queue) != nullptr)
         {
-            graphicsCapable = VK_TRUE;
+            return;//we allready know this queue
+        }
+
+        //TODO also check if the queue is present capable
+        bool graphicsCapable = createCommandPool(pLogicalDevice, queueFamilyIndex);
+        createQueueStruct(pLogicalDevice, queue, graphicsCapable ? queueFamilyIndex : VK_QUEUE_FAMILY_IGNORED);
+
+        //Save the first graphic capable queue in the device
+        if(graphicsCapable && pLogicalDevice->queue == VK_NULL_HANDLE)
+        {
+            pLogicalDevice->queue = queue;
+            pLogicalDevice->queueFamilyIndex = queueFamilyIndex;
+            pLogicalDevice->commandPool = pLogicalDevice->commandPools[queueFamilyIndex];
         }
-    }
-    else
-    {
-        //TODO
-        graphicsCapable = VK_TRUE;
-    }
-    
-    if(graphicsCapable)
-    {   
-        VkCommandPoolCreateInfo commandPoolCreateInfo;
-        commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        commandPoolCreateInfo.pNext = nullptr;
-        commandPoolCreateInfo.flags = 0;
-        commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
-        
-        std::cout << "found graphic capable queue" << std::endl;
-        device_dispatch[GetKey(device)].CreateCommandPool(device,&commandPoolCreateInfo,nullptr,&deviceStruct.commandPool);
-        deviceStruct.queue = *pQueue;
-        deviceStruct.queueFamilyIndex = queueFamilyIndex;
     }
 }
 
-VKAPI_ATTR VkResult VKAPI_CALL vkBasalt_CreateSwapchainKHR(VkDevice device, const VkSwapchainCreateInfoKHR* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSwapchainKHR* pSwapchain)
+VKAPI_ATTR void VKAPI_CALL vkBasalt_GetDeviceQueue(VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex, VkQueue *pQueue)
 {
-    VkSwapchainCreateInfoKHR modifiedCreateInfo = *pCreateInfo;
-    modifiedCreateInfo.imageUsage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;//we want to use the swapchain images as output of the graphics pipeline
-    scoped_lock l(globalLock);
-    
-    if(modifiedCreateInfo.oldSwapchain != VK_NULL_HANDLE)
-    {
-        //we need to delete the infos of the oldswapchain
-        // TODO do we really? it seems as if afer recreating a swapchain the old one is destroyed with vkDestroySwapchain 
-        /*std::cout << "oldswapchain != VK_NULL_HANDLE  swapchain " << modifiedCreateInfo.oldSwapchain << std::endl;
-        SwapchainStruct& oldStruct = swapchainMap[modifiedCreateInfo.oldSwapchain];
-        vkBasalt::destroySwapchainStruct(oldStruct);*/
-    }
-    std::cout << "queue " << deviceMap[device].queue << std::endl;
-    std::cout << "format " << modifiedCreateInfo.imageFormat << std::endl;
-    SwapchainStruct swapchainStruct;
-    swapchainStruct.device = device;
-    swapchainStruct.swapchainCreateInfo = *pCreateInfo;
-    swapchainStruct.imageExtent = modifiedCreateInfo.imageExtent;
-    swapchainStruct.format = modifiedCreateInfo.imageFormat;
-    swapchainStruct.imageCount = 0;
-    std::cout << "device " << swapchainStruct.device << std::endl;
-    
-    VkResult result = device_dispatch[GetKey(device)].CreateSwapchainKHR(device, &modifiedCreateInfo, pAllocator, pSwapchain);
-    
-    swapchainMap[*pSwapchain] = swapchainStruct;
-    std::cout << "swapchain " << *pSwapchain << std::endl;
-    
-    std::cout << "Interrupted create swapchain" << std::endl;
-    
-    return result;
-}       
+    vkBasalt::LogicalDevice* pLogicalDevice = deviceMap.find(device)->get();
+    pLogicalDevice->dispatchTable.GetDeviceQueue(device,queueFamilyIndex,queueIndex,pQueue);
+    vkBasalt::registerQueue(pLogicalDevice, *pQueue, queueFamilyIndex);
+}
 
-VKAPI_ATTR VkResult VKAPI_CALL vkBasalt_GetSwapchainImagesKHR(VkDevice device, VkSwapchainKHR swapchain, uint32_t *pCount, VkImage *pSwapchainImages) 
+VKAPI_ATTR void VKAPI_CALL vkBasalt_GetDeviceQueue2(VkDevice device, const VkDeviceQueueInfo2* pQueueInfo, VkQueue* pQueue)
 {
-    scoped_lock l(globalLock);
-    std::cout << "Interrupted get swapchain images " << *pCount << std::endl;
-    if(pSwapchainImages==nullptr)
+    vkBasalt::LogicalDevice* pLogicalDevice = deviceMap.find(device)->get();
+    pLogicalDevice->dispatchTable.GetDeviceQueue2(device, pQueueInfo, pQueue);
+    //protected queues are not returned by vkGetDeviceQueue, they get no VkQueue if the flags do not match
+    if(*pQueue != VK_NULL_HANDLE)
     {
-        return device_dispatch[GetKey(device)].GetSwapchainImagesKHR(device, swapchain, pCount, pSwapchainImages);
+        vkBasalt::registerQueue(pLogicalDevice, *pQueue, pQueueInfo->queueFamilyIndex);
     }
-    
-    
-    DeviceStruct& deviceStruct = deviceMap[device];
-    SwapchainStruct& swapchainStruct = swapchainMap[swapchain];
-    swapchainStruct.imageCount = *pCount;
-    swapchainStruct.imageList.reserve(*pCount);
-    swapchainStruct.commandBufferList.reserve(*pCount);
-    
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBasalt_CreateSwapchainKHR(VkDevice device, const VkSwapchainCreateInfoKHR* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSwapchainKHR* pSwapchain)
+{
     std::string effectOption = pConfig->getOption("effects", "cas");
     std::vector<std::string> effectStrings;
     while(effectOption!=std::string(""))
     {
         size_t colon = effectOption.find(":");
-        effectStrings.push_back(effectOption.substr(0,colon));
+        if(colon!=0)
+        {
+            effectStrings.push_back(effectOption.substr(0,colon));
+        }
         if(colon==std::string::npos)
         {
             effectOption = std::string("");
@@ -373,202 +867,719 @@ VKAPI_ATTR VkResult VKAPI_CALL vkBasalt_GetSwapchainImagesKHR(VkDevice device, V
             effectOption = effectOption.substr(colon+1);
         }
     }
+
+    std::shared_ptr<vkBasalt::LogicalDevice> pLogicalDevice = *deviceMap.find(device);
+    VkLayerDispatchTable& dispatchTable = pLogicalDevice->dispatchTable;
+
+    VkSwapchainCreateInfoKHR modifiedCreateInfo = *pCreateInfo;
+    bool copyImages = false;
+    if(!effectStrings.empty())
+    {
+        modifiedCreateInfo.imageUsage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;//we want to use the swapchain images as output of the graphics pipeline
+        //and as target of the copy while the effects are toggled off, if the surface allows it
+        VkSurfaceCapabilitiesKHR surfaceCapabilities;
+        VkResult result = pLogicalDevice->instanceDispatchTable.GetPhysicalDeviceSurfaceCapabilitiesKHR(pLogicalDevice->physicalDevice, pCreateInfo->surface, &surfaceCapabilities);
+        copyImages = result == VK_SUCCESS && (surfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+        if(copyImages)
+        {
+            modifiedCreateInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        }
+        else
+        {
+            vkBasalt::Logger::warn("the surface does not support TRANSFER_DST, the effects can not be toggled off or built in the background");
+        }
+    }
     
-    swapchainStruct.fakeImageList = vkBasalt::createFakeSwapchainImages(instance_dispatch[GetKey(deviceStruct.physicalDevice)],
-                                                                        deviceStruct.physicalDevice,
-                                                                        device,
-                                                                        device_dispatch[GetKey(device)],
-                                                                        swapchainStruct.swapchainCreateInfo,
-                                                                        *pCount * effectStrings.size(),
-                                                                        swapchainStruct.fakeImageMemory);
-    std::cout << "after createFakeSwapchainImages " << std::endl;
-    
+    vkBasalt::Logger::debug("format ", modifiedCreateInfo.imageFormat);
+    vkBasalt::Logger::debug("device ", device);
     
-    VkResult result = device_dispatch[GetKey(device)].GetSwapchainImagesKHR(device, swapchain, pCount, pSwapchainImages);
-    for(unsigned int i=0;i<*pCount;i++)
+    VkResult result = dispatchTable.CreateSwapchainKHR(device, &modifiedCreateInfo, pAllocator, pSwapchain);
+    if(result != VK_SUCCESS)
     {
-        swapchainStruct.imageList.push_back(pSwapchainImages[i]);
-        pSwapchainImages[i] = swapchainStruct.fakeImageList[i];
+        return result;
     }
     
-    std::cout << swapchainStruct.imageList.size() << "swapchain images" << std::endl;
-    
+    SwapchainStruct& swapchainStruct = swapchainMap.insert(*pSwapchain);
+    swapchainStruct.pLogicalDevice = pLogicalDevice.get();
+    swapchainStruct.pLogicalDeviceRef = pLogicalDevice;
+    swapchainStruct.swapchainCreateInfo = *pCreateInfo;
+    swapchainStruct.imageExtent = modifiedCreateInfo.imageExtent;
+    swapchainStruct.format = modifiedCreateInfo.imageFormat;
+    swapchainStruct.passthrough = effectStrings.empty();
+    swapchainStruct.copyImages = copyImages;
+    swapchainStruct.effectStrings = effectStrings;
+    swapchainStruct.sharedIntermediates = false;
+    swapchainStruct.pConfig = pConfig;
+    if(!swapchainStruct.passthrough)
+    {
+        //the driver may create more images than requested, the plan needs the real count
+        uint32_t imageCount = 0;
+        dispatchTable.GetSwapchainImagesKHR(device, *pSwapchain, &imageCount, nullptr);
+        SwapchainStruct* pOldStruct = modifiedCreateInfo.oldSwapchain != VK_NULL_HANDLE ? swapchainMap.find(modifiedCreateInfo.oldSwapchain) : nullptr;
+        //the fake images of the old swapchain go away with it, so the new ones may use their memory
+        VkDeviceSize oldSwapchainSize = 0;
+        if(pOldStruct != nullptr)
+        {
+            read_lock oldLock(pOldStruct->lock);
+            for(const vkBasalt::MemoryAllocation& allocation : pOldStruct->fakeImageMemory)
+            {
+                oldSwapchainSize += allocation.size;
+            }
+        }
+        vkBasalt::SwapchainMemoryPlan plan = vkBasalt::planSwapchainMemory(pLogicalDevice.get(),
+                                                                           effectStrings,
+                                                                           modifiedCreateInfo.imageExtent,
+                                                                           modifiedCreateInfo.imageFormat,
+                                                                           imageCount,
+                                                                           oldSwapchainSize);
+        swapchainStruct.effectStrings = plan.effectStrings;
+        swapchainStruct.sharedIntermediates = plan.sharedIntermediates;
+        if(pOldStruct != nullptr)
+        {
+            //the effects of the old swapchain are still alive until the application destroys it,
+            //the new effects take over everything of them that does not depend on the extent
+            read_lock oldLock(pOldStruct->lock);
+            //effects that are still built in the background are only worth taking over once they are done
+            //every waiter works on its own copy of the future, several swapchains may be created from the same old one
+            std::shared_future<void> oldEffectBuild = pOldStruct->effectBuild;
+            if(oldEffectBuild.valid())
+            {
+                oldEffectBuild.wait();
+            }
+            if(plan.compactSmaaEdges && pOldStruct->pConfig != pConfig)
+            {
+                //the old swapchain already has the compact copy, a new copy would not match the old states
+                swapchainStruct.pConfig = pOldStruct->pConfig;
+            }
+            swapchainStruct.oldEffectStates.resize(swapchainStruct.effectStrings.size());
+            for(uint32_t i=0;i<swapchainStruct.effectStrings.size() && i<pOldStruct->effectList.size();i++)
+            {
+                if(pOldStruct->effectStrings[i] == swapchainStruct.effectStrings[i] && pOldStruct->effectList[i] != nullptr)
+                {
+                    swapchainStruct.oldEffectStates[i] = pOldStruct->effectList[i]->getState();
+                }
+            }
+        }
+        if(plan.compactSmaaEdges && swapchainStruct.pConfig == pConfig)
+        {
+            swapchainStruct.pConfig = std::shared_ptr<vkBasalt::Config>(new vkBasalt::Config(*pConfig));
+            swapchainStruct.pConfig->setOption("smaaCompactEdges", "true");
+        }
+    }
+    swapchainStruct.imageCount = 0;
+    swapchainStruct.effectsReady = false;
+    swapchainStruct.lastTimelineSemaphore = VK_NULL_HANDLE;
+    swapchainStruct.lastFrameValue = 0;
+    vkBasalt::Logger::debug("swapchain ", *pSwapchain);
     
+    vkBasalt::Logger::debug("Interrupted create swapchain");
     
-    for(uint32_t i=0;i<effectStrings.size();i++)
+    return result;
+}       
+
+namespace vkBasalt{
+    std::shared_ptr<Effect> createEffect(const std::string& effectString,
+                                         std::shared_ptr<LogicalDevice> pLogicalDevice,
+                                         VkFormat format,
+                                         VkExtent2D imageExtent,
+                                         std::vector<VkImage> firstImages,
+                                         std::vector<VkImage> secondImages,
+                                         std::shared_ptr<Config> pConfig,
+                                         std::shared_ptr<EffectState> pOldState)
     {
-        std::cout << "current effectString " << effectStrings[i] << std::endl;
-        std::vector<VkImage> firstImages(swapchainStruct.fakeImageList.begin() + swapchainStruct.imageCount * i,
-                                         swapchainStruct.fakeImageList.begin() + swapchainStruct.imageCount * (i+1));
-        std::cout << firstImages.size() << " images in firstImages" << std::endl;
-        std::vector<VkImage> secondImages;
-        if(i==effectStrings.size()-1)
+        if(effectString == std::string("fxaa"))
         {
-            secondImages = swapchainStruct.imageList;
-            std::cout << "using swapchain images as second images" << std::endl;
+            return std::shared_ptr<Effect>(new FxaaEffect(pLogicalDevice, format, imageExtent, firstImages, secondImages, pConfig, pOldState));
         }
-        else
+        else if(effectString == std::string("cas"))
         {
-            secondImages = std::vector<VkImage>(swapchainStruct.fakeImageList.begin() + swapchainStruct.imageCount * (i+1),
-                                                swapchainStruct.fakeImageList.begin() + swapchainStruct.imageCount * (i+2));
-            std::cout << "not using swapchain images as second images" << std::endl;
-        }
-        std::cout << secondImages.size() << " images in secondImages" << std::endl;
-        if(effectStrings[i] == std::string("fxaa"))
-        {
-            swapchainStruct.effectList.push_back(std::shared_ptr<vkBasalt::Effect>(new vkBasalt::FxaaEffect(deviceStruct.physicalDevice,
-                                                         instance_dispatch[GetKey(deviceStruct.physicalDevice)],
-                                                         device,
-                                                         device_dispatch[GetKey(device)],
-                                                         swapchainStruct.format,
-                                                         swapchainStruct.imageExtent,
-                                                         firstImages,
-                                                         secondImages,
-                                                         pConfig)));
-            std::cout << "after creating FxaaEffect " << std::endl;
-        }
-        else if(effectStrings[i] == std::string("cas"))
-        {
-            swapchainStruct.effectList.push_back(std::shared_ptr<vkBasalt::Effect>(new vkBasalt::CasEffect(deviceStruct.physicalDevice,
-                                                         instance_dispatch[GetKey(deviceStruct.physicalDevice)],
-                                                         device,
-                                                         device_dispatch[GetKey(device)],
-                                                         swapchainStruct.format,
-                                                         swapchainStruct.imageExtent,
-                                                         firstImages,
-                                                         secondImages,
-                                                         pConfig)));
-            std::cout << "after creating CasEffect " << std::endl;
-        }
-        else if(effectStrings[i] == std::string("deband"))
-        {
-            swapchainStruct.effectList.push_back(std::shared_ptr<vkBasalt::Effect>(new vkBasalt::DebandEffect(deviceStruct.physicalDevice,
-                                                         instance_dispatch[GetKey(deviceStruct.physicalDevice)],
-                                                         device,
-                                                         device_dispatch[GetKey(device)],
-                                                         swapchainStruct.format,
-                                                         swapchainStruct.imageExtent,
-                                                         firstImages,
-                                                         secondImages,
-                                                         pConfig)));
-            std::cout << "after creating DebandEffect " << std::endl;
-        }
-        else if(effectStrings[i] == std::string("smaa"))
-        {
-            swapchainStruct.effectList.push_back(std::shared_ptr<vkBasalt::Effect>(new vkBasalt::SmaaEffect(deviceStruct.physicalDevice,
-                                                         instance_dispatch[GetKey(deviceStruct.physicalDevice)],
-                                                         device,
-                                                         device_dispatch[GetKey(device)],
-                                                         swapchainStruct.format,
-                                                         swapchainStruct.imageExtent,
-                                                         firstImages,
-                                                         secondImages,
-                                                         pConfig,
-                                                         deviceStruct.queue,
-                                                         deviceStruct.commandPool)));
-        }
-        else if(effectStrings[i] == std::string("lut"))
-        {
-            swapchainStruct.effectList.push_back(std::shared_ptr<vkBasalt::Effect>(new vkBasalt::LutEffect(deviceStruct.physicalDevice,
-                                                         instance_dispatch[GetKey(deviceStruct.physicalDevice)],
-                                                         device,
-                                                         device_dispatch[GetKey(device)],
-                                                         swapchainStruct.format,
-                                                         swapchainStruct.imageExtent,
-                                                         firstImages,
-                                                         secondImages,
-                                                         pConfig,
-                                                         deviceStruct.queue,
-                                                         deviceStruct.commandPool)));
+            return std::shared_ptr<Effect>(new CasEffect(pLogicalDevice, format, imageExtent, firstImages, secondImages, pConfig, pOldState));
         }
-        else
+        else if(effectString == std::string("deband"))
+        {
+            return std::shared_ptr<Effect>(new DebandEffect(pLogicalDevice, format, imageExtent, firstImages, secondImages, pConfig, pOldState));
+        }
+        else if(effectString == std::string("smaa"))
         {
-            throw std::runtime_error("unknown effect" + effectStrings[i]);
-        }    
+            return std::shared_ptr<Effect>(new SmaaEffect(pLogicalDevice, format, imageExtent, firstImages, secondImages, pConfig, pOldState));
+        }
+        else if(effectString == std::string("lut"))
+        {
+            return std::shared_ptr<Effect>(new LutEffect(pLogicalDevice, format, imageExtent, firstImages, secondImages, pConfig, pOldState));
+        }
+        throw std::runtime_error("unknown effect" + effectString);
+    }
+
+    //set 0 are the images the application renders to, 1 and 2 the intermediate sets the effects write alternately
+    std::vector<VkImage> getFakeImageSet(const SwapchainStruct& swapchainStruct, uint32_t set)
+    {
+        if(set == 0)
+        {
+            return std::vector<VkImage>(swapchainStruct.fakeImageList.begin(), swapchainStruct.fakeImageList.begin() + swapchainStruct.imageCount);
+        }
+        uint32_t intermediateSetSize = swapchainStruct.sharedIntermediates ? 1 : swapchainStruct.imageCount;
+        auto first = swapchainStruct.fakeImageList.begin() + swapchainStruct.imageCount + intermediateSetSize * (set-1);
+        if(intermediateSetSize == 1)
+        {
+            return std::vector<VkImage>(swapchainStruct.imageCount, *first);
+        }
+        return std::vector<VkImage>(first, first + intermediateSetSize);
+    }
+
+    //creates the effects and records their command buffers, then sets effectsReady
+    //this may run without the swapchain lock, so it only writes what the presents do not read before effectsReady
+    void buildSwapchainEffects(SwapchainStruct& swapchainStruct, const std::string& ownerName)
+    {
+        std::shared_ptr<vkBasalt::LogicalDevice> pLogicalDevice = swapchainStruct.pLogicalDeviceRef;
+        const std::vector<std::string>& effectStrings = swapchainStruct.effectStrings;
+
+        //the effects do not depend on each other, so they are built at the same time on the layer thread pool,
+        //each one writes its own entry of effectList, so the chain keeps its order
+        swapchainStruct.effectList.resize(effectStrings.size());
+        std::vector<std::future<void>> effectBuilds;
+        for(uint32_t i=0;i<effectStrings.size();i++)
+        {
+            vkBasalt::Logger::debug("current effectString ", effectStrings[i]);
+            std::vector<VkImage> firstImages = getFakeImageSet(swapchainStruct, i == 0 ? 0 : 1 + (i-1) % 2);
+            vkBasalt::Logger::debug(firstImages.size(), " images in firstImages");
+            std::vector<VkImage> secondImages;
+            if(i==effectStrings.size()-1)
+            {
+                secondImages = swapchainStruct.imageList;
+                vkBasalt::Logger::debug("using swapchain images as second images");
+            }
+            else
+            {
+                secondImages = getFakeImageSet(swapchainStruct, 1 + i % 2);
+                vkBasalt::Logger::debug("not using swapchain images as second images");
+            }
+            vkBasalt::Logger::debug(secondImages.size(), " images in secondImages");
+            uint64_t resourceOwner = pLogicalDevice->resourceTracker.createOwner(ownerName + " " + effectStrings[i] + " " + std::to_string(i));
+            swapchainStruct.resourceOwners.push_back(resourceOwner);
+            std::shared_ptr<vkBasalt::EffectState> pOldState = i < swapchainStruct.oldEffectStates.size() ? swapchainStruct.oldEffectStates[i] : nullptr;
+            std::shared_ptr<vkBasalt::Effect>& pEffect = swapchainStruct.effectList[i];
+            std::string effectString = effectStrings[i];
+            //the owner of the fake images is the first one of the swapchain and tells it apart from the others
+            uint64_t transientGroup = swapchainStruct.resourceOwners[0];
+            effectBuilds.push_back(vkBasalt::getThreadPool().submit([&swapchainStruct, &pEffect, pLogicalDevice, effectString, firstImages, secondImages, resourceOwner, transientGroup, pOldState]()
+            {
+                vkBasalt::ResourceScope resourceScope(resourceOwner);
+                vkBasalt::TransientGroupScope transientGroupScope(transientGroup);
+                pEffect = vkBasalt::createEffect(effectString,
+                                                 pLogicalDevice,
+                                                 swapchainStruct.format,
+                                                 swapchainStruct.imageExtent,
+                                                 firstImages,
+                                                 secondImages,
+                                                 swapchainStruct.pConfig,
+                                                 pOldState);
+                vkBasalt::Logger::debug("after creating ", effectString);
+            }));
+        }
+        //every build has to be finished before the first error leaves this function, they all write into effectList
+        for(std::future<void>& effectBuild : effectBuilds)
+        {
+            effectBuild.wait();
+        }
+        for(std::future<void>& effectBuild : effectBuilds)
+        {
+            effectBuild.get();
+        }
+        //the new effects hold the states they took over, the rest goes away with the old swapchain
+        swapchainStruct.oldEffectStates.clear();
+        vkBasalt::Logger::debug("effect string count: ", effectStrings.size());
+        vkBasalt::Logger::debug("effect count: ", swapchainStruct.effectList.size());
+        {
+            //like the intermediates only the first swapchain reports at info level
+            static std::atomic<bool> reported{false};
+            pLogicalDevice->resourceTracker.logStats(!reported.exchange(true));
+        }
+    
+        //the command pools need external synchronization
+        scoped_lock deviceLock(pLogicalDevice->lock);
+        //record the effects once for every queue family the application got a graphics queue from,
+        //so a present can run them on the presenting queue itself
+        swapchainStruct.commandBufferLists.resize(swapchainStruct.queueFamilies.size());
+        for(uint32_t i=0;i<swapchainStruct.queueFamilies.size();i++)
+        {
+            if(!swapchainStruct.queueFamilies[i])
+            {
+                continue;
+            }
+            swapchainStruct.commandBufferLists[i] = vkBasalt::allocateCommandBuffer(pLogicalDevice.get(), pLogicalDevice->commandPools[i], swapchainStruct.imageCount);
+            vkBasalt::Logger::debug("after allocateCommandBuffer for queue family ", i);
         
+            vkBasalt::writeCommandBuffers(pLogicalDevice.get(), swapchainStruct.effectList,  swapchainStruct.commandBufferLists[i]);
+            vkBasalt::Logger::debug("after write CommandBuffer");
+        }
+        swapchainStruct.effectsReady.store(true, std::memory_order_release);
     }
-    std::cout << "effect string count: " << effectStrings.size() << std::endl;
-    std::cout << "effect count: " << swapchainStruct.effectList.size() << std::endl;
+
+    //creates the fake images, copy command buffers and semaphores of the swapchain and builds the effects,
+    //with asyncEffectBuild the effects are built in the background and the presents copy until they are ready
+    //the caller holds the swapchain lock exclusively
+    //this only happens once per swapchain, no matter how often the application asks for the images
+    VkResult createSwapchainEffects(VkDevice device, VkSwapchainKHR swapchain, SwapchainStruct& swapchainStruct)
+    {
+        std::shared_ptr<vkBasalt::LogicalDevice> pLogicalDevice = swapchainStruct.pLogicalDeviceRef;
+        VkLayerDispatchTable& dispatchTable = pLogicalDevice->dispatchTable;
+
+        //the application may ask for fewer images than there are, the layer always needs all of them
+        uint32_t imageCount = 0;
+        VkResult result = dispatchTable.GetSwapchainImagesKHR(device, swapchain, &imageCount, nullptr);
+        if(result != VK_SUCCESS)
+        {
+            return result;
+        }
+        swapchainStruct.imageList.resize(imageCount);
+        result = dispatchTable.GetSwapchainImagesKHR(device, swapchain, &imageCount, swapchainStruct.imageList.data());
+        if(result != VK_SUCCESS)
+        {
+            swapchainStruct.imageList.clear();
+            return result;
+        }
+
+        swapchainStruct.imageCount = imageCount;
+        const std::vector<std::string>& effectStrings = swapchainStruct.effectStrings;
     
-    swapchainStruct.commandBufferList = vkBasalt::allocateCommandBuffer(device, device_dispatch[GetKey(device)], deviceStruct.commandPool, swapchainStruct.imageCount);
-    std::cout << "after allocateCommandBuffer " << std::endl;
+        //the first set of fake images is what the application renders to, the effects in between
+        //write alternately into two intermediate sets, so a long chain needs no more than three sets
+        //every swapchain image has its own sets, since the command buffers of different images may run at the same time,
+        //unless the memory budget planning decided to share them, which is only done when the frames run one after another
+        uint32_t intermediateSetCount = std::min<uint32_t>(effectStrings.size() - 1, 2);
+        uint32_t intermediateSetSize = swapchainStruct.sharedIntermediates ? 1 : imageCount;
+        std::stringstream ownerName;
+        ownerName << "swapchain " << swapchain;
+        swapchainStruct.resourceOwners.push_back(pLogicalDevice->resourceTracker.createOwner(ownerName.str()));
+        {
+            vkBasalt::ResourceScope resourceScope(swapchainStruct.resourceOwners.back());
+            swapchainStruct.fakeImageList = vkBasalt::createFakeSwapchainImages(pLogicalDevice.get(),
+                                                                                swapchainStruct.swapchainCreateInfo,
+                                                                                imageCount + intermediateSetSize * intermediateSetCount,
+                                                                                swapchainStruct.fakeImageMemory);
+        }
+        vkBasalt::Logger::debug("after createFakeSwapchainImages ");
+
+        uint32_t savedSetCount = effectStrings.size() - 1 - intermediateSetCount;
+        if(savedSetCount > 0)
+        {
+            VkMemoryRequirements memoryRequirements;
+            dispatchTable.GetImageMemoryRequirements(device, swapchainStruct.fakeImageList[0], &memoryRequirements);
+            VkDeviceSize savedSize = memoryRequirements.size * intermediateSetSize * savedSetCount;
+            //only the first swapchain reports it at info level, so recreating swapchains stays quiet
+            static std::atomic<bool> reported{false};
+            if(!reported.exchange(true))
+            {
+                vkBasalt::Logger::info("ping-pong intermediates save ", savedSize / (1024*1024), " MiB of images");
+            }
+            else
+            {
+                vkBasalt::Logger::debug("ping-pong intermediates save ", savedSize / (1024*1024), " MiB of images");
+            }
+        }
     
-    vkBasalt::writeCommandBuffers(device, device_dispatch[GetKey(device)], swapchainStruct.effectList,  swapchainStruct.commandBufferList);
-    std::cout << "after write CommandBuffer" << std::endl;
     
-    swapchainStruct.semaphoreList = vkBasalt::createSemaphores(device, device_dispatch[GetKey(device)], swapchainStruct.imageCount);
-    std::cout << "after create semaphores" << std::endl;
-    for(unsigned int i=0;i<swapchainStruct.imageCount;i++)
+        vkBasalt::Logger::debug(swapchainStruct.imageList.size(), "swapchain images");
+
+        {
+            //the command pools need external synchronization
+            scoped_lock deviceLock(pLogicalDevice->lock);
+            //the effects are recorded for every graphics capable family, also the ones the application gets a queue from later
+            //or the images are fetched before any queue, so only a queue without graphics has to fall back to another queue
+            for(uint32_t i=0;i<pLogicalDevice->commandPools.size();i++)
+            {
+                createCommandPool(pLogicalDevice.get(), i);
+            }
+            //the copy is recorded for the same queue families as the effects, the presents pick the family by them
+            swapchainStruct.queueFamilies.resize(pLogicalDevice->commandPools.size());
+            swapchainStruct.copyCommandBufferLists.resize(pLogicalDevice->commandPools.size());
+            std::vector<VkImage> applicationImages = getFakeImageSet(swapchainStruct, 0);
+            for(uint32_t i=0;i<pLogicalDevice->commandPools.size();i++)
+            {
+                swapchainStruct.queueFamilies[i] = pLogicalDevice->commandPools[i] != VK_NULL_HANDLE;
+                if(!swapchainStruct.queueFamilies[i] || !swapchainStruct.copyImages)
+                {
+                    continue;
+                }
+                swapchainStruct.copyCommandBufferLists[i] = vkBasalt::allocateCommandBuffer(pLogicalDevice.get(), pLogicalDevice->commandPools[i], swapchainStruct.imageCount);
+                vkBasalt::writeCopyCommandBuffers(pLogicalDevice.get(), applicationImages, swapchainStruct.imageList, swapchainStruct.imageExtent, swapchainStruct.copyCommandBufferLists[i]);
+            }
+        }
+    
+        swapchainStruct.semaphoreList = vkBasalt::createSemaphores(pLogicalDevice.get(), swapchainStruct.imageCount);
+        vkBasalt::Logger::debug("after create semaphores");
+
+        //without the copy the presents would have nothing to submit until the effects are ready
+        if(!swapchainStruct.copyImages || swapchainStruct.pConfig->getOption("asyncEffectBuild", "false") != "true")
+        {
+            buildSwapchainEffects(swapchainStruct, ownerName.str());
+            return VK_SUCCESS;
+        }
+
+        //not on the thread pool, the build waits for the effects it submits there
+        //a failed build is only logged, the swapchain keeps presenting the copy
+        swapchainStruct.effectBuild = std::async(std::launch::async, [&swapchainStruct, name = ownerName.str()]()
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            try
+            {
+                buildSwapchainEffects(swapchainStruct, name);
+            }
+            catch(const std::exception& e)
+            {
+                vkBasalt::Logger::err("building the effects of ", name, " failed: ", e.what());
+                return;
+            }
+            std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+            vkBasalt::Logger::debug("effects of ", name, " ready after ", duration.count(), " ms");
+        }).share();
+    
+        return VK_SUCCESS;
+    }
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBasalt_GetSwapchainImagesKHR(VkDevice device, VkSwapchainKHR swapchain, uint32_t *pCount, VkImage *pSwapchainImages) 
+{
+    vkBasalt::Logger::debug("Interrupted get swapchain images ", *pCount);
+    SwapchainStruct& swapchainStruct = *swapchainMap.find(swapchain);
+    VkLayerDispatchTable& dispatchTable = swapchainStruct.pLogicalDevice->dispatchTable;
+    //there is one fake image for every real one, so the count comes straight from the driver
+    if(pSwapchainImages==nullptr || swapchainStruct.passthrough)
     {
-        std::cout << i << "writen commandbuffer" << swapchainStruct.commandBufferList[i] << std::endl;
+        return dispatchTable.GetSwapchainImagesKHR(device, swapchain, pCount, pSwapchainImages);
     }
-    std::cout << "after getswapchainimages " << std::endl;
     
-    return result;
+    write_lock swapchainLock(swapchainStruct.lock);
+    if(swapchainStruct.imageCount == 0)
+    {
+        VkResult result = vkBasalt::createSwapchainEffects(device, swapchain, swapchainStruct);
+        if(result != VK_SUCCESS)
+        {
+            return result;
+        }
+    }
+    
+    //repeated queries get the same fake images
+    uint32_t count = std::min(*pCount, swapchainStruct.imageCount);
+    std::copy(swapchainStruct.fakeImageList.begin(), swapchainStruct.fakeImageList.begin() + count, pSwapchainImages);
+    *pCount = count;
+    vkBasalt::Logger::debug("after getswapchainimages ");
+    
+    return count < swapchainStruct.imageCount ? VK_INCOMPLETE : VK_SUCCESS;
 }
 
 VKAPI_ATTR VkResult VKAPI_CALL vkBasalt_QueuePresentKHR(VkQueue queue,const VkPresentInfoKHR* pPresentInfo)
 {
-    scoped_lock l(globalLock);
-    
-    std::vector<VkSemaphore> presentSemaphores;
-    presentSemaphores.reserve(pPresentInfo->swapchainCount);
+    //all swapchains of one present belong to the device that owns the queue
+    SwapchainStruct* pFirstStruct = swapchainMap.find(pPresentInfo->pSwapchains[0]);
+    vkBasalt::LogicalDevice* pLogicalDevice = pFirstStruct->pLogicalDevice;
 
-    std::vector<VkPipelineStageFlags> waitStages;
+    //vkGetDeviceQueue and vkGetDeviceQueue2 registered every queue of the device
+    QueueStruct* pQueueStruct = queueMap.find(queue);
 
-    for(unsigned int i=0;i<(*pPresentInfo).swapchainCount;i++)
+    //the vectors only grow, so in steady state they are reused without allocating
+    uint32_t swapchainCount = pPresentInfo->swapchainCount;
+    std::vector<SwapchainStruct*>& swapchainStructs = pQueueStruct->swapchainStructs;
+    std::vector<bool>& runEffects = pQueueStruct->runEffects;
+    std::vector<VkCommandBuffer>& commandBuffers = pQueueStruct->commandBuffers;
+    std::vector<VkSemaphore>& presentSemaphores = pQueueStruct->presentSemaphores;
+    swapchainStructs.clear();
+    runEffects.clear();
+    commandBuffers.clear();
+    presentSemaphores.clear();
+    if(presentSemaphores.capacity() < swapchainCount + 1)
     {
-        uint32_t index = (*pPresentInfo).pImageIndices[i];
-        VkSwapchainKHR swapchain = (*pPresentInfo).pSwapchains[i];
-        SwapchainStruct& swapchainStruct = swapchainMap[swapchain];
-        VkDevice device = swapchainStruct.device;
-        DeviceStruct& deviceStruct = deviceMap[device];
+        swapchainStructs.reserve(swapchainCount);
+        runEffects.reserve(swapchainCount);
+        commandBuffers.reserve(swapchainCount);
+        presentSemaphores.reserve(swapchainCount + 1);
+    }
+
+    //every swapchain is looked up once, the rest of the present works on the records
+    //passthrough is fixed when the swapchain is created, so it can be read without the swapchain lock
+    uint32_t passthroughCount = 0;
+    for(uint32_t i=0;i<swapchainCount;i++)
+    {
+        SwapchainStruct* pSwapchainStruct = i == 0 ? pFirstStruct : swapchainMap.find(pPresentInfo->pSwapchains[i]);
+        swapchainStructs.push_back(pSwapchainStruct);
+        passthroughCount += pSwapchainStruct->passthrough ? 1 : 0;
+    }
+    if(passthroughCount == swapchainCount)
+    {
+        return pLogicalDevice->dispatchTable.QueuePresentKHR(queue, pPresentInfo);
+    }
+
+    //toggling only changes which of the prerecorded command buffers get submitted
+    vkBasalt::pollToggleKey();
+    bool enabled = effectsEnabled.load(std::memory_order_relaxed);
+
+    bool timeline = pQueueStruct->timelineSemaphore != VK_NULL_HANDLE;
+    if(timeline)
+    {
+        vkBasalt::accountFinishedFrames(pLogicalDevice, *pQueueStruct);
+    }
+
+    //run the effects on the presenting queue, every swapchain has command buffers for each graphics capable family
+    //a queue without graphics falls back to the graphics queue from vkGetDeviceQueue, the semaphores order the two queues
+    uint32_t queueFamilyIndex = pQueueStruct->queueFamilyIndex;
+    VkQueue submitQueue = queue;
 
-        waitStages.resize(pPresentInfo->waitSemaphoreCount, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    //the swapchains stay locked until the submit, so their command buffers can not be rebuilt in between
+    //a passthrough swapchain in the same present just waits for the semaphores of the others
+    for(unsigned int i=0;i<swapchainCount;i++)
+    {
+        SwapchainStruct* pSwapchainStruct = swapchainStructs[i];
+        if(pSwapchainStruct->passthrough)
+        {
+            runEffects.push_back(false);
+            continue;
+        }
+        pSwapchainStruct->lock.lock_shared();
+        if(pSwapchainStruct->imageCount == 0)
+        {
+            //the application never asked for the images, the effects are built before the first present instead
+            pSwapchainStruct->lock.unlock_shared();
+            {
+                write_lock swapchainLock(pSwapchainStruct->lock);
+                VkResult result = pSwapchainStruct->imageCount == 0 ? vkBasalt::createSwapchainEffects(pLogicalDevice->device, (*pPresentInfo).pSwapchains[i], *pSwapchainStruct) : VK_SUCCESS;
+                if(result != VK_SUCCESS)
+                {
+                    for(unsigned int j=0;j<i;j++)
+                    {
+                        if(!swapchainStructs[j]->passthrough)
+                        {
+                            swapchainStructs[j]->lock.unlock_shared();
+                        }
+                    }
+                    return result;
+                }
+            }
+            pSwapchainStruct->lock.lock_shared();
+        }
+        //effects that are still built in the background are skipped, the frame just gets copied
+        //a swapchain that can not copy always has its effects ready and can not toggle them off
+        bool ready = pSwapchainStruct->effectsReady.load(std::memory_order_acquire);
+        runEffects.push_back(ready && (enabled || !pSwapchainStruct->copyImages));
+        if(queueFamilyIndex >= pSwapchainStruct->queueFamilies.size() || !pSwapchainStruct->queueFamilies[queueFamilyIndex])
+        {
+            queueFamilyIndex = pLogicalDevice->queueFamilyIndex;
+            submitQueue = pLogicalDevice->queue;
+        }
+    }
 
-        VkSubmitInfo submitInfo;
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.pNext = nullptr;
-        submitInfo.waitSemaphoreCount = 0;
-        submitInfo.pWaitSemaphores = nullptr;
-        submitInfo.pWaitDstStageMask = nullptr;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &(swapchainStruct.commandBufferList[index]);
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores = &(swapchainStruct.semaphoreList[index]);
+    //the uploads the builds recorded go in front of the frame, the ready flags are read before,
+    //so every upload of an effect that runs now is in the list
+    //they are recorded for every graphics capable family, so they run on the queue of the frame
+    //the lock is held until the uploads are submitted, so discardUpload can not miss them in between
+    //without timeline semaphores a frame on another queue is not ordered after this one,
+    //so effects presented from several queues at once may sample a texture before its upload ran
+    uint64_t frameValue = pQueueStruct->frameValue + 1;
+    std::unique_lock<std::mutex> uploadLock(pLogicalDevice->uploadLock, std::defer_lock);
+    vkBasalt::SubmittedUploads submittedUploads = {pQueueStruct->timelineSemaphore, frameValue, {}};
+    if(pLogicalDevice->uploadsPending.load(std::memory_order_acquire))
+    {
+        uploadLock.lock();
+        submittedUploads.uploads.swap(pLogicalDevice->pendingUploads);
+        pLogicalDevice->uploadsPending.store(false, std::memory_order_relaxed);
+    }
+    for(const vkBasalt::PendingUpload& upload : submittedUploads.uploads)
+    {
+        commandBuffers.push_back(upload.commandBuffers[queueFamilyIndex]);
+    }
 
-        presentSemaphores.push_back(swapchainStruct.semaphoreList[index]);
+    for(unsigned int i=0;i<swapchainCount;i++)
+    {
+        if(swapchainStructs[i]->passthrough)
+        {
+            continue;
+        }
+        uint32_t index = (*pPresentInfo).pImageIndices[i];
+        std::vector<std::vector<VkCommandBuffer>>& commandBufferLists = runEffects[i] ? swapchainStructs[i]->commandBufferLists : swapchainStructs[i]->copyCommandBufferLists;
+        commandBuffers.push_back(commandBufferLists[queueFamilyIndex][index]);
+        presentSemaphores.push_back(swapchainStructs[i]->semaphoreList[index]);
+    }
+    uint32_t effectSemaphoreCount = presentSemaphores.size();
 
-        if (i == 0)
+    std::vector<VkSemaphore>& waitSemaphores = pQueueStruct->waitSemaphores;
+    std::vector<uint64_t>& waitValues = pQueueStruct->waitValues;
+    std::vector<uint64_t>& signalValues = pQueueStruct->signalValues;
+    VkTimelineSemaphoreSubmitInfo timelineInfo;
+    if(timeline)
+    {
+        //binary semaphores ignore their value
+        waitSemaphores.assign(pPresentInfo->pWaitSemaphores, pPresentInfo->pWaitSemaphores + pPresentInfo->waitSemaphoreCount);
+        waitValues.assign(pPresentInfo->waitSemaphoreCount, 0);
+        //a frame on the fallback queue may not signal the timeline before the previous frame on this queue did
+        if(submitQueue != queue && pQueueStruct->frameValue != 0)
+        {
+            waitSemaphores.push_back(pQueueStruct->timelineSemaphore);
+            waitValues.push_back(pQueueStruct->frameValue);
+        }
+        presentSemaphores.push_back(pQueueStruct->timelineSemaphore);
+        signalValues.assign(effectSemaphoreCount, 0);
+        signalValues.push_back(frameValue);
+    }
+
+    //the transient images are shared by every swapchain of the device, so the frames of the layer
+    //have to run in the order they were submitted, even if they are on different queues
+    //a timeline wait may be submitted before its signal, so the lock only covers the bookkeeping and not the submit
+    //a frame on the same queue is ordered by the queue, which the application already synchronizes for the present,
+    //the fallback queue is shared with the presents of other queues, so the device lock covers its bookkeeping and submit
+    //a present on its own queue submits without any lock
+    std::unique_lock<std::mutex> deviceLock(pLogicalDevice->lock, std::defer_lock);
+    if(submitQueue != queue)
+    {
+        deviceLock.lock();
+    }
+    if(timeline)
+    {
+        scoped_lock lastFrameLock(pLogicalDevice->lastFrameLock);
+        if(pLogicalDevice->lastFrameQueue != submitQueue && pLogicalDevice->lastFrameSemaphore != VK_NULL_HANDLE)
         {
-            submitInfo.waitSemaphoreCount = pPresentInfo->waitSemaphoreCount;
-            submitInfo.pWaitSemaphores = pPresentInfo->pWaitSemaphores;
-            submitInfo.pWaitDstStageMask = waitStages.data();
+            waitSemaphores.push_back(pLogicalDevice->lastFrameSemaphore);
+            waitValues.push_back(pLogicalDevice->lastFrameValue);
         }
+        //if the submit fails the device is lost, nothing waits for the value then
+        pLogicalDevice->lastFrameQueue = submitQueue;
+        pLogicalDevice->lastFrameSemaphore = pQueueStruct->timelineSemaphore;
+        pLogicalDevice->lastFrameValue = frameValue;
+    }
+    if(timeline)
+    {
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.pNext = nullptr;
+        timelineInfo.waitSemaphoreValueCount = waitValues.size();
+        timelineInfo.pWaitSemaphoreValues = waitValues.data();
+        timelineInfo.signalSemaphoreValueCount = signalValues.size();
+        timelineInfo.pSignalSemaphoreValues = signalValues.data();
+    }
+    uint32_t waitSemaphoreCount = timeline ? waitSemaphores.size() : pPresentInfo->waitSemaphoreCount;
+    std::vector<VkPipelineStageFlags>& waitStages = pQueueStruct->waitStages;
+    if(waitStages.size() < waitSemaphoreCount)
+    {
+        waitStages.resize(waitSemaphoreCount, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    }
+
+    //one submit for all swapchains, every effect waits for the application and signals the semaphore of its swapchain
+    VkSubmitInfo submitInfo;
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = timeline ? &timelineInfo : nullptr;
+    submitInfo.waitSemaphoreCount = waitSemaphoreCount;
+    submitInfo.pWaitSemaphores = timeline ? waitSemaphores.data() : pPresentInfo->pWaitSemaphores;
+    submitInfo.pWaitDstStageMask = waitStages.data();
+    submitInfo.commandBufferCount = commandBuffers.size();
+    submitInfo.pCommandBuffers = commandBuffers.data();
+    submitInfo.signalSemaphoreCount = presentSemaphores.size();
+    submitInfo.pSignalSemaphores = presentSemaphores.data();
 
-        VkResult vr = device_dispatch[GetKey(device)].QueueSubmit(deviceStruct.queue, 1, &submitInfo, VK_NULL_HANDLE);
+    VkResult vr = pLogicalDevice->dispatchTable.QueueSubmit(submitQueue, 1, &submitInfo, VK_NULL_HANDLE);
+    if(deviceLock.owns_lock())
+    {
+        deviceLock.unlock();
+    }
+    if(!submittedUploads.uploads.empty())
+    {
+        //the queue frees them once its timeline reached the frame,
+        //if the submit failed the device is lost, the uploads are freed with the device
+        pLogicalDevice->submittedUploads.push_back(std::move(submittedUploads));
+        pLogicalDevice->uploadsSubmitted.store(true, std::memory_order_release);
+        uploadLock.unlock();
+    }
+    else if(uploadLock.owns_lock())
+    {
+        uploadLock.unlock();
+    }
 
-        if (vr != VK_SUCCESS)
+    if(vr == VK_SUCCESS && timeline)
+    {
+        pQueueStruct->frameValue = frameValue;
+        pQueueStruct->submitTimes[frameValue % pQueueStruct->submitTimes.size()] = std::chrono::steady_clock::now();
+        for(SwapchainStruct* pSwapchainStruct : swapchainStructs)
         {
-            return vr;
+            if(pSwapchainStruct->passthrough)
+            {
+                continue;
+            }
+            pSwapchainStruct->lastTimelineSemaphore = pQueueStruct->timelineSemaphore;
+            pSwapchainStruct->lastFrameValue = frameValue;
         }
     }
+
+    for(SwapchainStruct* pSwapchainStruct : swapchainStructs)
+    {
+        if(!pSwapchainStruct->passthrough)
+        {
+            pSwapchainStruct->lock.unlock_shared();
+        }
+    }
+
+    if (vr != VK_SUCCESS)
+    {
+        return vr;
+    }
+
+    //the timeline semaphore at the end of presentSemaphores is not waited on by the present
     VkPresentInfoKHR presentInfo = *pPresentInfo;
-    presentInfo.waitSemaphoreCount = presentSemaphores.size();
+    presentInfo.waitSemaphoreCount = effectSemaphoreCount;
     presentInfo.pWaitSemaphores = presentSemaphores.data();
 
-    return device_dispatch[GetKey(queue)].QueuePresentKHR(queue, &presentInfo);
+    return pLogicalDevice->dispatchTable.QueuePresentKHR(queue, &presentInfo);
+}
+
+//without timeline semaphores the waits of the application are the points where the retired swapchains are known to be done
+VKAPI_ATTR VkResult VKAPI_CALL vkBasalt_DeviceWaitIdle(VkDevice device)
+{
+    vkBasalt::LogicalDevice* pLogicalDevice = deviceMap.find(device)->get();
+    if(pLogicalDevice->timelineSemaphores)
+    {
+        return pLogicalDevice->dispatchTable.DeviceWaitIdle(device);
+    }
+    uint64_t firstBusyNumber = vkBasalt::getNextRetiredNumber();
+    VkResult result = pLogicalDevice->dispatchTable.DeviceWaitIdle(device);
+    if(result == VK_SUCCESS)
+    {
+        vkBasalt::freeIdleSwapchains(pLogicalDevice, VK_NULL_HANDLE, firstBusyNumber);
+        //every queue is externally synchronized for the wait, so no present submitted uploads since
+        vkBasalt::freeFinishedUploads(pLogicalDevice, VK_NULL_HANDLE, UINT64_MAX);
+    }
+    return result;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBasalt_QueueWaitIdle(VkQueue queue)
+{
+    //vkGetDeviceQueue and vkGetDeviceQueue2 registered every queue of the device
+    vkBasalt::LogicalDevice* pLogicalDevice = queueMap.find(queue)->pLogicalDevice;
+    if(pLogicalDevice->timelineSemaphores)
+    {
+        return pLogicalDevice->dispatchTable.QueueWaitIdle(queue);
+    }
+    uint64_t firstBusyNumber = vkBasalt::getNextRetiredNumber();
+    VkResult result = pLogicalDevice->dispatchTable.QueueWaitIdle(queue);
+    if(result == VK_SUCCESS)
+    {
+        vkBasalt::freeIdleSwapchains(pLogicalDevice, queue, firstBusyNumber);
+    }
+    return result;
 }
 
 VKAPI_ATTR void VKAPI_CALL vkBasalt_DestroySwapchainKHR(VkDevice device, VkSwapchainKHR swapchain,const VkAllocationCallbacks* pAllocator)
 {
-    scoped_lock l(globalLock);
+    if(swapchain == VK_NULL_HANDLE)
+    {
+        return;
+    }
     //we need to delete the infos of the oldswapchain 
-    SwapchainStruct& oldStruct = swapchainMap[swapchain];
-    std::cout << "destroying swapchain " << swapchain << std::endl;
-    vkBasalt::destroySwapchainStruct(oldStruct);
+    SwapchainStruct& oldStruct = *swapchainMap.find(swapchain);
+    vkBasalt::Logger::debug("destroying swapchain ", swapchain);
+    VkLayerDispatchTable& dispatchTable = oldStruct.pLogicalDevice->dispatchTable;
+    {
+        write_lock l(oldStruct.lock);
+        vkBasalt::destroySwapchainStruct(oldStruct);
+    }
+    
+    dispatchTable.DestroySwapchainKHR(device, swapchain,pAllocator);
     
-    device_dispatch[GetKey(device)].DestroySwapchainKHR(device, swapchain,pAllocator);
+    swapchainMap.erase(swapchain);
 }
 ///////////////////////////////////////////////////////////////////////////////////////////
 // Enumeration function
@@ -627,8 +1638,7 @@ VK_LAYER_EXPORT VkResult VKAPI_CALL vkBasalt_EnumerateDeviceExtensionProperties(
             return VK_SUCCESS;
         }
 
-        scoped_lock l(globalLock);
-        return instance_dispatch[GetKey(physicalDevice)].EnumerateDeviceExtensionProperties(physicalDevice, pLayerName, pPropertyCount, pProperties);
+        return instanceMap.find(GetKey(physicalDevice))->dispatchTable.EnumerateDeviceExtensionProperties(physicalDevice, pLayerName, pPropertyCount, pProperties);
     }
 
     // don't expose any extensions
@@ -639,6 +1649,22 @@ VK_LAYER_EXPORT VkResult VKAPI_CALL vkBasalt_EnumerateDeviceExtensionProperties(
     return VK_SUCCESS;
 }
 
+//not a vulkan function, tools get it through vkGetDeviceProcAddr to see what the layer holds, one entry per owner
+VK_LAYER_EXPORT VkResult VKAPI_CALL vkBasalt_GetResourceStatsVKBASALT(VkDevice device, uint32_t* pStatCount, vkBasalt::ResourceStats* pStats)
+{
+    std::shared_ptr<vkBasalt::LogicalDevice> pLogicalDevice = *deviceMap.find(device);
+    std::vector<vkBasalt::ResourceStats> stats = pLogicalDevice->resourceTracker.getStats();
+    if(pStats == nullptr)
+    {
+        *pStatCount = stats.size();
+        return VK_SUCCESS;
+    }
+    uint32_t count = std::min<uint32_t>(*pStatCount, stats.size());
+    std::copy(stats.begin(), stats.begin() + count, pStats);
+    *pStatCount = count;
+    return count < stats.size() ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
 extern "C"{// these are the entry points for the layer, so they need to be c-linkeable
 
 #define GETPROCADDR(func) if(!std::strcmp(pName, "vk" #func)) return (PFN_vkVoidFunction)&vkBasalt_##func;
@@ -655,14 +1681,15 @@ VK_LAYER_EXPORT PFN_vkVoidFunction VKAPI_CALL vkBasalt_GetDeviceProcAddr(VkDevic
     GETPROCADDR(CreateDevice);
     GETPROCADDR(DestroyDevice);
     GETPROCADDR(GetDeviceQueue);
+    GETPROCADDR(GetDeviceQueue2);
     GETPROCADDR(CreateSwapchainKHR);
     GETPROCADDR(GetSwapchainImagesKHR);
     GETPROCADDR(QueuePresentKHR);
     GETPROCADDR(DestroySwapchainKHR);
-    {
-        scoped_lock l(globalLock);
-        return device_dispatch[GetKey(device)].GetDeviceProcAddr(device, pName);
-    }
+    GETPROCADDR(DeviceWaitIdle);
+    GETPROCADDR(QueueWaitIdle);
+    GETPROCADDR(GetResourceStatsVKBASALT);
+    return (*deviceMap.find(device))->dispatchTable.GetDeviceProcAddr(device, pName);
 }
 
 VK_LAYER_EXPORT PFN_vkVoidFunction VKAPI_CALL vkBasalt_GetInstanceProcAddr(VkInstance instance, const char *pName)
@@ -681,14 +1708,14 @@ VK_LAYER_EXPORT PFN_vkVoidFunction VKAPI_CALL vkBasalt_GetInstanceProcAddr(VkIns
     GETPROCADDR(CreateDevice);
     GETPROCADDR(DestroyDevice);
     GETPROCADDR(GetDeviceQueue);
+    GETPROCADDR(GetDeviceQueue2);
     GETPROCADDR(CreateSwapchainKHR);
     GETPROCADDR(GetSwapchainImagesKHR);
     GETPROCADDR(QueuePresentKHR);
     GETPROCADDR(DestroySwapchainKHR);
-    {
-        scoped_lock l(globalLock);
-        return instance_dispatch[GetKey(instance)].GetInstanceProcAddr(instance, pName);
-    }
+    GETPROCADDR(DeviceWaitIdle);
+    GETPROCADDR(QueueWaitIdle);
+    return instanceMap.find(GetKey(instance))->dispatchTable.GetInstanceProcAddr(instance, pName);
 }
 
 }//extern "C"
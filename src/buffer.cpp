@@ -1,5 +1,4 @@
 #include "buffer.hpp"
-#include "memory.hpp"
 
 #ifndef ASSERT_VULKAN
 #define ASSERT_VULKAN(val)\
@@ -11,7 +10,7 @@
 
 namespace vkBasalt
 {
-    void createBuffer(VkLayerInstanceDispatchTable instanceDispatchTable, VkDevice device, VkLayerDispatchTable dispatchTable, VkPhysicalDevice physicalDevice, VkDeviceSize size,  VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+    void createBuffer(LogicalDevice* pLogicalDevice, VkDeviceSize size,  VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocation& bufferMemory)
     {
         VkBufferCreateInfo bufferInfo = {};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -19,23 +18,17 @@ namespace vkBasalt
         bufferInfo.usage = usage;
         bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        if (dispatchTable.CreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+        if (pLogicalDevice->dispatchTable.CreateBuffer(pLogicalDevice->device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
             throw std::runtime_error("failed to create buffer!");
         }
 
         VkMemoryRequirements memRequirements;
-        dispatchTable.GetBufferMemoryRequirements(device, buffer, &memRequirements);
+        pLogicalDevice->dispatchTable.GetBufferMemoryRequirements(pLogicalDevice->device, buffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo = {};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryTypeIndex(instanceDispatchTable,physicalDevice,memRequirements.memoryTypeBits, properties);
+        bufferMemory = pLogicalDevice->memoryAllocator.allocate(memRequirements, properties, true);
 
-        if (dispatchTable.AllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate buffer memory!");
-        }
-
-        dispatchTable.BindBufferMemory(device, buffer, bufferMemory, 0);
+        pLogicalDevice->dispatchTable.BindBufferMemory(pLogicalDevice->device, buffer, bufferMemory.memory, bufferMemory.offset);
+        pLogicalDevice->resourceTracker.add(ResourceType::Buffer, buffer, memRequirements.size);
     }
 
 }
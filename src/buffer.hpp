@@ -9,9 +9,11 @@
 #include "vulkan/vulkan.h"
 #include "vulkan/vk_layer.h"
 #include "vulkan/vk_layer_dispatch_table.h"
+
+#include "logical_device.hpp"
 namespace vkBasalt
 {
-    void createBuffer(VkLayerInstanceDispatchTable instanceDispatchTable, VkDevice device, VkLayerDispatchTable dispatchTable, VkPhysicalDevice physicalDevice, VkDeviceSize size,  VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+    void createBuffer(LogicalDevice* pLogicalDevice, VkDeviceSize size,  VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocation& bufferMemory);
 }
 
 
@@ -1,4 +1,5 @@
 #include "command_buffer.hpp"
+#include "logger.hpp"
 
 
 #ifndef ASSERT_VULKAN
@@ -11,7 +12,7 @@
 
 namespace vkBasalt
 {
-    std::vector<VkCommandBuffer> allocateCommandBuffer(VkDevice device, VkLayerDispatchTable dispatchTable, VkCommandPool commandPool, uint32_t count)
+    std::vector<VkCommandBuffer> allocateCommandBuffer(LogicalDevice* pLogicalDevice, VkCommandPool commandPool, uint32_t count)
     {
         std::vector<VkCommandBuffer> commandBuffers(count);
         
@@ -22,18 +23,18 @@ namespace vkBasalt
         allocInfo.commandPool = commandPool;
         allocInfo.commandBufferCount = count;
         
-        VkResult result = dispatchTable.AllocateCommandBuffers(device,&allocInfo,commandBuffers.data());
+        VkResult result = pLogicalDevice->dispatchTable.AllocateCommandBuffers(pLogicalDevice->device,&allocInfo,commandBuffers.data());
         ASSERT_VULKAN(result);
         for(unsigned int i=0;i<count;i++)
         {
             //initialize dispatch tables for commandBuffers since the are dispatchable objects
-            *reinterpret_cast<void**>(commandBuffers[i]) = *reinterpret_cast<void**>(device);
+            *reinterpret_cast<void**>(commandBuffers[i]) = *reinterpret_cast<void**>(pLogicalDevice->device);
         }
         
         return commandBuffers;
     
     }
-    void writeCommandBuffers(VkDevice device, VkLayerDispatchTable dispatchTable, std::vector<std::shared_ptr<vkBasalt::Effect>> effects, std::vector<VkCommandBuffer> commandBuffers)
+    void writeCommandBuffers(LogicalDevice* pLogicalDevice, const std::vector<std::shared_ptr<vkBasalt::Effect>>& effects, const std::vector<VkCommandBuffer>& commandBuffers)
     {
         VkCommandBufferBeginInfo beginInfo = {};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -44,22 +45,96 @@ namespace vkBasalt
         for(unsigned int i=0;i<commandBuffers.size();i++)
         {
             
-            VkResult result = dispatchTable.BeginCommandBuffer(commandBuffers[i],&beginInfo);
+            VkResult result = pLogicalDevice->dispatchTable.BeginCommandBuffer(commandBuffers[i],&beginInfo);
             ASSERT_VULKAN(result);
+
+            //shared intermediates may still be sampled by the last effect of the previous frame
+            recordTransientBarrier(pLogicalDevice, commandBuffers[i]);
             
             for(uint32_t j=0;j<effects.size();j++)
             {
-                std::cout << "before applying effect " << effects[j] << std::endl; 
+                Logger::trace("before applying effect ", effects[j]);
                 effects[j]->applyEffect(i,commandBuffers[i]);
             }
 
-            result = dispatchTable.EndCommandBuffer(commandBuffers[i]);
+            result = pLogicalDevice->dispatchTable.EndCommandBuffer(commandBuffers[i]);
             ASSERT_VULKAN(result);
         }
     }
 
+    void writeCopyCommandBuffers(LogicalDevice* pLogicalDevice, const std::vector<VkImage>& srcImages, const std::vector<VkImage>& dstImages, VkExtent2D extent, const std::vector<VkCommandBuffer>& commandBuffers)
+    {
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.pNext = nullptr;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+        beginInfo.pInheritanceInfo = nullptr;
+
+        VkImageMemoryBarrier barriers[2];
+        for(VkImageMemoryBarrier& barrier : barriers)
+        {
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.pNext = nullptr;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            barrier.subresourceRange.baseMipLevel = 0;
+            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.baseArrayLayer = 0;
+            barrier.subresourceRange.layerCount = 1;
+        }
+
+        VkImageCopy region;
+        region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.srcSubresource.mipLevel = 0;
+        region.srcSubresource.baseArrayLayer = 0;
+        region.srcSubresource.layerCount = 1;
+        region.srcOffset = {0,0,0};
+        region.dstSubresource = region.srcSubresource;
+        region.dstOffset = {0,0,0};
+        region.extent = {extent.width, extent.height, 1};
+
+        for(unsigned int i=0;i<commandBuffers.size();i++)
+        {
+            VkResult result = pLogicalDevice->dispatchTable.BeginCommandBuffer(commandBuffers[i],&beginInfo);
+            ASSERT_VULKAN(result);
+
+            barriers[0].srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+            barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            barriers[0].oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barriers[0].image = srcImages[i];
+            //the old content of the swapchain image gets overwritten anyway
+            barriers[1].srcAccessMask = 0;
+            barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barriers[1].image = dstImages[i];
+            //the present semaphores are waited at ALL_COMMANDS, the barrier has to chain to that wait
+            //so the copy does not start before the application is done writing the fake image
+            pLogicalDevice->dispatchTable.CmdPipelineBarrier(commandBuffers[i],VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,0,0, nullptr,0, nullptr,2, barriers);
 
-    std::vector<VkSemaphore> createSemaphores(VkDevice device, VkLayerDispatchTable dispatchTable, uint32_t count)
+            pLogicalDevice->dispatchTable.CmdCopyImage(commandBuffers[i],
+                                                        srcImages[i], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                                        dstImages[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                        1, &region);
+
+            barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            barriers[0].dstAccessMask = 0;
+            barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barriers[0].newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barriers[1].dstAccessMask = 0;
+            barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barriers[1].newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            pLogicalDevice->dispatchTable.CmdPipelineBarrier(commandBuffers[i],VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,0,0, nullptr,0, nullptr,2, barriers);
+
+            result = pLogicalDevice->dispatchTable.EndCommandBuffer(commandBuffers[i]);
+            ASSERT_VULKAN(result);
+        }
+    }
+
+    std::vector<VkSemaphore> createSemaphores(LogicalDevice* pLogicalDevice, uint32_t count)
     {
         std::vector<VkSemaphore> semaphores(count);
         VkSemaphoreCreateInfo info;
@@ -69,9 +144,28 @@ namespace vkBasalt
 
         for (uint32_t i = 0; i < count; i++)
         {
-            dispatchTable.CreateSemaphore(device, &info, nullptr, &semaphores[i]);
+            pLogicalDevice->dispatchTable.CreateSemaphore(pLogicalDevice->device, &info, nullptr, &semaphores[i]);
         }
         return semaphores;
     }
 
+    VkSemaphore createTimelineSemaphore(LogicalDevice* pLogicalDevice, uint64_t initialValue)
+    {
+        VkSemaphoreTypeCreateInfo typeInfo;
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.pNext = nullptr;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = initialValue;
+
+        VkSemaphoreCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        info.pNext = &typeInfo;
+        info.flags = 0;
+
+        VkSemaphore semaphore;
+        VkResult result = pLogicalDevice->dispatchTable.CreateSemaphore(pLogicalDevice->device, &info, nullptr, &semaphore);
+        ASSERT_VULKAN(result);
+        return semaphore;
+    }
+
 }
@@ -11,13 +11,19 @@
 #include "vulkan/vk_layer.h"
 #include "vulkan/vk_layer_dispatch_table.h"
 
+#include "logical_device.hpp"
+
 #include "effect.hpp"
 namespace vkBasalt
 {
     
-    std::vector<VkCommandBuffer> allocateCommandBuffer(VkDevice device, VkLayerDispatchTable dispatchTable, VkCommandPool commandPool, uint32_t count);
-    void writeCommandBuffers(VkDevice device, VkLayerDispatchTable dispatchTable, std::vector<std::shared_ptr<vkBasalt::Effect>> effects, std::vector<VkCommandBuffer> commandBuffers);
-    std::vector<VkSemaphore> createSemaphores(VkDevice device, VkLayerDispatchTable dispatchTable, uint32_t count);
+    std::vector<VkCommandBuffer> allocateCommandBuffer(LogicalDevice* pLogicalDevice, VkCommandPool commandPool, uint32_t count);
+    void writeCommandBuffers(LogicalDevice* pLogicalDevice, const std::vector<std::shared_ptr<vkBasalt::Effect>>& effects, const std::vector<VkCommandBuffer>& commandBuffers);
+    //copies srcImages[i] into dstImages[i], the images need to be in VK_IMAGE_LAYOUT_PRESENT_SRC_KHR and stay in it
+    void writeCopyCommandBuffers(LogicalDevice* pLogicalDevice, const std::vector<VkImage>& srcImages, const std::vector<VkImage>& dstImages, VkExtent2D extent, const std::vector<VkCommandBuffer>& commandBuffers);
+    std::vector<VkSemaphore> createSemaphores(LogicalDevice* pLogicalDevice, uint32_t count);
+    //needs a device with timeline semaphores enabled
+    VkSemaphore createTimelineSemaphore(LogicalDevice* pLogicalDevice, uint64_t initialValue);
 }
 
 #endif // COMMAND_BUFFER_HPP_INCLUDED
@@ -1,4 +1,7 @@
 #include "config.hpp"
+#include "logger.hpp"
+
+#include <array>
 
 namespace vkBasalt
 {
@@ -27,17 +30,21 @@ namespace vkBasalt
             std::ifstream configFile(cFile);
             if (!configFile.good()) continue;
 
-            std::cout << cFile << std::endl;
+            Logger::info("config file: ", cFile);
             readConfigFile(configFile);
             return;
         }
 
-        std::cout << "no good config file" << std::endl;
+        Logger::warn("no good config file");
     }
     Config::Config(const Config& other)
     {
         this->options = other.options;
     }
+    void Config::setOption(const std::string& option, const std::string& value)
+    {
+        options[option] = value;
+    }
     void Config::readConfigFile(std::ifstream& stream)
     {
         std::string line;
@@ -71,7 +78,7 @@ namespace vkBasalt
         {
             return;
         }
-        std::cout  << "set option " << line.substr(0,equal) << " equal to " << line.substr(equal+1) << std::endl;
+        Logger::debug("set option ", line.substr(0,equal), " equal to ", line.substr(equal+1));
         options[line.substr(0,equal)] = line.substr(equal+1);
     }
     std::string Config::getOption(const std::string& option, const std::string& defaultValue) {
@@ -19,6 +19,7 @@ namespace vkBasalt{
         Config();
         Config(const Config& other);
         std::string getOption(const std::string& option, const std::string& defaultValue = "");
+        void setOption(const std::string& option, const std::string& value);
     private:
         std::unordered_map<std::string,std::string> options;
         void readConfigLine(std::string line);
@@ -1,4 +1,5 @@
 #include "descriptor_set.hpp"
+#include "logger.hpp"
 
 #ifndef ASSERT_VULKAN
 #define ASSERT_VULKAN(val)\
@@ -15,7 +16,7 @@ typedef struct {
 namespace vkBasalt
 {
         
-    VkDescriptorPool createDescriptorPool(VkDevice device, VkLayerDispatchTable dispatchTable, const std::vector<VkDescriptorPoolSize>& poolSizes)
+    VkDescriptorPool createDescriptorPool(LogicalDevice* pLogicalDevice, const std::vector<VkDescriptorPoolSize>& poolSizes)
     {
         uint32_t setCount = 0;
         VkDescriptorPool descriptorPool;
@@ -31,14 +32,15 @@ namespace vkBasalt
         descriptorPoolCreateInfo.poolSizeCount = poolSizes.size();
         descriptorPoolCreateInfo.pPoolSizes = poolSizes.data();
 
-        VkResult result =  dispatchTable.CreateDescriptorPool(device,&descriptorPoolCreateInfo,nullptr,&descriptorPool);
+        VkResult result =  pLogicalDevice->dispatchTable.CreateDescriptorPool(pLogicalDevice->device,&descriptorPoolCreateInfo,nullptr,&descriptorPool);
         ASSERT_VULKAN(result);
+        pLogicalDevice->resourceTracker.add(ResourceType::DescriptorPool, descriptorPool);
         return descriptorPool;
     }
     
     
     
-    VkDescriptorSetLayout createUniformBufferDescriptorSetLayout(VkDevice device, VkLayerDispatchTable dispatchTable)
+    VkDescriptorSetLayout createUniformBufferDescriptorSetLayout(LogicalDevice* pLogicalDevice)
     {
         VkDescriptorSetLayout descriptorSetLayout;
         
@@ -57,19 +59,19 @@ namespace vkBasalt
         descriptorSetCreateInfo.pBindings = &descriptorSetLayoutBinding;
 
         
-        VkResult result = dispatchTable.CreateDescriptorSetLayout(device,&descriptorSetCreateInfo,nullptr,&descriptorSetLayout);
+        VkResult result = pLogicalDevice->dispatchTable.CreateDescriptorSetLayout(pLogicalDevice->device,&descriptorSetCreateInfo,nullptr,&descriptorSetLayout);
         ASSERT_VULKAN(result)
         
         return descriptorSetLayout;
     }
-    VkDescriptorPool createUniformBufferDescriptorPool(VkDevice device, VkLayerDispatchTable dispatchTable, uint32_t setCount)
+    VkDescriptorPool createUniformBufferDescriptorPool(LogicalDevice* pLogicalDevice, uint32_t setCount)
     {
         VkDescriptorPool descriptorPool;
         VkDescriptorPoolSize poolSize;
         poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         poolSize.descriptorCount = setCount;
         
-        std::cout << "set count " << setCount << std::endl;
+        Logger::debug("set count ", setCount);
 
         VkDescriptorPoolCreateInfo descriptorPoolCreateInfo;
         descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -79,11 +81,12 @@ namespace vkBasalt
         descriptorPoolCreateInfo.poolSizeCount = 1;
         descriptorPoolCreateInfo.pPoolSizes = &poolSize;
 
-        VkResult result =  dispatchTable.CreateDescriptorPool(device,&descriptorPoolCreateInfo,nullptr,&descriptorPool);
+        VkResult result =  pLogicalDevice->dispatchTable.CreateDescriptorPool(pLogicalDevice->device,&descriptorPoolCreateInfo,nullptr,&descriptorPool);
         ASSERT_VULKAN(result);
+        pLogicalDevice->resourceTracker.add(ResourceType::DescriptorPool, descriptorPool);
         return descriptorPool;
     }
-    VkDescriptorSet writeCasBufferDescriptorSet(VkDevice device, VkLayerDispatchTable dispatchTable, VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorSetLayout, VkBuffer buffer)
+    VkDescriptorSet writeCasBufferDescriptorSet(LogicalDevice* pLogicalDevice, VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorSetLayout, VkBuffer buffer)
     {
         VkDescriptorSet descriptorSet;
         
@@ -94,7 +97,7 @@ namespace vkBasalt
         descriptorSetAllocateInfo.descriptorSetCount = 1;
         descriptorSetAllocateInfo.pSetLayouts = &descriptorSetLayout;
         
-        VkResult result =  dispatchTable.AllocateDescriptorSets(device,&descriptorSetAllocateInfo,&descriptorSet);
+        VkResult result =  pLogicalDevice->dispatchTable.AllocateDescriptorSets(pLogicalDevice->device,&descriptorSetAllocateInfo,&descriptorSet);
         ASSERT_VULKAN(result);
         
         VkDescriptorBufferInfo bufferInfo;
@@ -114,16 +117,14 @@ namespace vkBasalt
         writeDescriptorSet.pBufferInfo = &bufferInfo;
         writeDescriptorSet.pTexelBufferView = nullptr;
         
-        std::cout << "before writing buffer descriptor Sets " << std::endl;
-        dispatchTable.UpdateDescriptorSets(device,1,&writeDescriptorSet,0,nullptr);
+        Logger::debug("before writing buffer descriptor Sets ");
+        pLogicalDevice->dispatchTable.UpdateDescriptorSets(pLogicalDevice->device,1,&writeDescriptorSet,0,nullptr);
         
         return descriptorSet;
     }
     
-    VkDescriptorSetLayout createImageSamplerDescriptorSetLayout(VkDevice device, VkLayerDispatchTable dispatchTable, uint32_t count)
+    VkDescriptorSetLayout createImageSamplerDescriptorSetLayout(LogicalDevice* pLogicalDevice, uint32_t count)
     {
-        VkDescriptorSetLayout descriptorSetLayout;
-        
         std::vector<VkDescriptorSetLayoutBinding> bindigs(count);
         for(uint32_t i=0;i<count;i++)
         {
@@ -143,14 +144,25 @@ namespace vkBasalt
         descriptorSetCreateInfo.bindingCount = count;
         descriptorSetCreateInfo.pBindings = bindigs.data();
 
-        
-        VkResult result = dispatchTable.CreateDescriptorSetLayout(device,&descriptorSetCreateInfo,nullptr,&descriptorSetLayout);
-        ASSERT_VULKAN(result)
-        return descriptorSetLayout;
-        
+        std::string key;
+        for(const VkDescriptorSetLayoutBinding& binding : bindigs)
+        {
+            appendKey(key, binding.binding);
+            appendKey(key, binding.descriptorType);
+            appendKey(key, binding.descriptorCount);
+            appendKey(key, binding.stageFlags);
+        }
+
+        return pLogicalDevice->objectCache.acquire<VkDescriptorSetLayout>(CachedType::DescriptorSetLayout, key, [&]()
+        {
+            VkDescriptorSetLayout descriptorSetLayout;
+            VkResult result = pLogicalDevice->dispatchTable.CreateDescriptorSetLayout(pLogicalDevice->device,&descriptorSetCreateInfo,nullptr,&descriptorSetLayout);
+            ASSERT_VULKAN(result)
+            return descriptorSetLayout;
+        });
     }
     
-    VkDescriptorPool createImageSamplerDescriptorPool(VkDevice device, VkLayerDispatchTable dispatchTable, uint32_t setCount)
+    VkDescriptorPool createImageSamplerDescriptorPool(LogicalDevice* pLogicalDevice, uint32_t setCount)
     {
         VkDescriptorPool descriptorPool;
         
@@ -158,7 +170,7 @@ namespace vkBasalt
         poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         poolSize.descriptorCount = setCount;
         
-        std::cout << "set count " << setCount << std::endl;
+        Logger::debug("set count ", setCount);
 
         VkDescriptorPoolCreateInfo descriptorPoolCreateInfo;
         descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -168,13 +180,14 @@ namespace vkBasalt
         descriptorPoolCreateInfo.poolSizeCount = 1;
         descriptorPoolCreateInfo.pPoolSizes = &poolSize;
 
-        VkResult result = dispatchTable.CreateDescriptorPool(device,&descriptorPoolCreateInfo,nullptr,&descriptorPool);
+        VkResult result = pLogicalDevice->dispatchTable.CreateDescriptorPool(pLogicalDevice->device,&descriptorPoolCreateInfo,nullptr,&descriptorPool);
         ASSERT_VULKAN(result);
+        pLogicalDevice->resourceTracker.add(ResourceType::DescriptorPool, descriptorPool);
         
         return descriptorPool;
     }
     
-    std::vector<VkDescriptorSet> allocateAndWriteImageSamplerDescriptorSets(VkDevice device, VkLayerDispatchTable dispatchTable, VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorSetLayout, VkSampler sampler, std::vector<std::vector<VkImageView>> imageViewsVectors)
+    std::vector<VkDescriptorSet> allocateAndWriteImageSamplerDescriptorSets(LogicalDevice* pLogicalDevice, VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorSetLayout, VkSampler sampler, std::vector<std::vector<VkImageView>> imageViewsVectors)
     {
         std::vector<VkDescriptorSet> descriptorSets(imageViewsVectors[0].size());
         
@@ -186,8 +199,8 @@ namespace vkBasalt
         descriptorSetAllocateInfo.descriptorSetCount = descriptorSets.size();
         descriptorSetAllocateInfo.pSetLayouts = layouts.data();
         
-        std::cout << "before allocating descriptor Sets " << 1 << std::endl;
-        VkResult result =  dispatchTable.AllocateDescriptorSets(device,&descriptorSetAllocateInfo,descriptorSets.data());
+        Logger::debug("before allocating descriptor Sets ", 1);
+        VkResult result =  pLogicalDevice->dispatchTable.AllocateDescriptorSets(pLogicalDevice->device,&descriptorSetAllocateInfo,descriptorSets.data());
         ASSERT_VULKAN(result);
 
         VkDescriptorImageInfo imageInfo;
@@ -219,8 +232,8 @@ namespace vkBasalt
                 writeDescriptorSets[j].pImageInfo = &imageInfos[j];
                 writeDescriptorSets[j].dstSet = descriptorSets[i];
             }
-            std::cout << "before writing descriptor Sets " << std::endl;
-            dispatchTable.UpdateDescriptorSets(device,writeDescriptorSets.size(),writeDescriptorSets.data(),0,nullptr);
+            Logger::debug("before writing descriptor Sets ");
+            pLogicalDevice->dispatchTable.UpdateDescriptorSets(pLogicalDevice->device,writeDescriptorSets.size(),writeDescriptorSets.data(),0,nullptr);
             
         }
         return descriptorSets;
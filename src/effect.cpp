@@ -1,5 +1,15 @@
 #include "effect.hpp"
 
 namespace vkBasalt{
-
+    EffectState::EffectState(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format, std::shared_ptr<vkBasalt::Config> pConfig, const std::string& name)
+    {
+        this->pLogicalDevice = pLogicalDevice;
+        this->format = format;
+        this->pConfig = pConfig;
+        resourceOwner = pLogicalDevice->resourceTracker.createOwner(name + " state");
+    }
+    EffectState::~EffectState()
+    {
+        pLogicalDevice->resourceTracker.destroyOwner(resourceOwner);
+    }
 }
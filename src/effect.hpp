@@ -6,19 +6,61 @@
 #include <iostream>
 #include <vector>
 #include <unordered_map>
+#include <memory>
 
 #include "vulkan/vulkan.h"
 #include "vulkan/vk_layer.h"
 #include "vulkan/vk_layer_dispatch_table.h"
 
+#include "logical_device.hpp"
+#include "config.hpp"
+
 namespace vkBasalt{
+    /*
+       the objects of an effect that do not depend on the swapchain images, like shader modules, render passes and pipelines
+
+       a recreated swapchain hands the state of its old effects to the new ones,
+       so a resize only rebuilds the image views, framebuffers and descriptor sets
+       the objects of a state belong to its own resource owner, since they outlive the swapchain that created them
+    */
+    class EffectState
+    {
+    public:
+        EffectState(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format, std::shared_ptr<vkBasalt::Config> pConfig, const std::string& name);
+        EffectState(const EffectState&) = delete;
+        EffectState& operator=(const EffectState&) = delete;
+        virtual ~EffectState();
+
+        std::shared_ptr<LogicalDevice> pLogicalDevice;
+        VkFormat format;
+        std::shared_ptr<vkBasalt::Config> pConfig;
+        uint64_t resourceOwner;
+    };
+
     class Effect
     {
     public:
         void virtual applyEffect(uint32_t imageIndex, VkCommandBuffer commandBuffer) = 0;
+        virtual std::shared_ptr<EffectState> getState() = 0;
         virtual ~Effect(){};
     private:
     };
+
+    //pOldState if it is a T that was built for the same device, format and config, otherwise a new empty T
+    template<typename T>
+    std::shared_ptr<T> reuseEffectState(std::shared_ptr<EffectState> pOldState,
+                                        std::shared_ptr<LogicalDevice> pLogicalDevice,
+                                        VkFormat format,
+                                        std::shared_ptr<vkBasalt::Config> pConfig,
+                                        const std::string& name)
+    {
+        std::shared_ptr<T> pState = std::dynamic_pointer_cast<T>(pOldState);
+        if(pState && pState->pLogicalDevice == pLogicalDevice && pState->format == format && pState->pConfig == pConfig)
+        {
+            return pState;
+        }
+        return std::make_shared<T>(pLogicalDevice, format, pConfig, name);
+    }
 }
 
 
@@ -21,32 +21,38 @@
 
 namespace vkBasalt
 {
-    CasEffect::CasEffect(VkPhysicalDevice physicalDevice, VkLayerInstanceDispatchTable instanceDispatchTable, VkDevice device, VkLayerDispatchTable dispatchTable, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig)
+    CasEffect::CasEffect(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig, std::shared_ptr<EffectState> pOldState)
     {
-        std::string fullScreenRectFile = "full_screen_triangle.vert.spv";
-        std::string casFragmentFile = "cas.frag.spv";
+        pState = reuseEffectState<SimpleEffectState>(pOldState, pLogicalDevice, format, pConfig, "cas");
+        if(!pState->isBuilt())
+        {
+            std::string fullScreenRectFile = "full_screen_triangle.vert.spv";
+            std::string casFragmentFile = "cas.frag.spv";
 
-        float sharpness = std::stod(pConfig->getOption("casSharpness", "0.4"));
+            float sharpness = std::stod(pConfig->getOption("casSharpness", "0.4"));
 
-        vertexCode = readFile(fullScreenRectFile);
-        fragmentCode = readFile(casFragmentFile);
+            vertexCode = getShaderCode(fullScreenRectFile);
+            fragmentCode = getShaderCode(casFragmentFile);
 
 
-        VkSpecializationMapEntry sharpnessMapEntry;
-        sharpnessMapEntry.constantID = 0;
-        sharpnessMapEntry.offset = 0;
-        sharpnessMapEntry.size = sizeof(float);
+            VkSpecializationMapEntry sharpnessMapEntry;
+            sharpnessMapEntry.constantID = 0;
+            sharpnessMapEntry.offset = 0;
+            sharpnessMapEntry.size = sizeof(float);
 
-        VkSpecializationInfo fragmentSpecializationInfo;
-        fragmentSpecializationInfo.mapEntryCount = 1;
-        fragmentSpecializationInfo.pMapEntries = &sharpnessMapEntry;
-        fragmentSpecializationInfo.dataSize = sizeof(float);
-        fragmentSpecializationInfo.pData = &sharpness;
+            VkSpecializationInfo fragmentSpecializationInfo;
+            fragmentSpecializationInfo.mapEntryCount = 1;
+            fragmentSpecializationInfo.pMapEntries = &sharpnessMapEntry;
+            fragmentSpecializationInfo.dataSize = sizeof(float);
+            fragmentSpecializationInfo.pData = &sharpness;
 
-        pVertexSpecInfo = nullptr;
-        pFragmentSpecInfo = &fragmentSpecializationInfo;
+            pVertexSpecInfo = nullptr;
+            pFragmentSpecInfo = &fragmentSpecializationInfo;
 
-        init(physicalDevice, instanceDispatchTable, device, dispatchTable, format,  imageExtent, inputImages, outputImages, pConfig);
+            buildState();
+        }
+
+        init(pLogicalDevice, format,  imageExtent, inputImages, outputImages, pConfig);
     }
     CasEffect::~CasEffect()
     {
@@ -21,56 +21,54 @@
 
 namespace vkBasalt
 {
-    DebandEffect::DebandEffect(VkPhysicalDevice physicalDevice, VkLayerInstanceDispatchTable instanceDispatchTable, VkDevice device, VkLayerDispatchTable dispatchTable, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig)
+    DebandEffect::DebandEffect(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig, std::shared_ptr<EffectState> pOldState)
     {
-        std::string fullScreenRectFile = "full_screen_triangle.vert.spv";
-        std::string debandFragmentFile = "deband.frag.spv";
+        pState = reuseEffectState<SimpleEffectState>(pOldState, pLogicalDevice, format, pConfig, "deband");
+        if(!pState->isBuilt())
+        {
+            std::string fullScreenRectFile = "full_screen_triangle.vert.spv";
+            std::string debandFragmentFile = "deband.frag.spv";
 
-        vertexCode = readFile(fullScreenRectFile);
-        fragmentCode = readFile(debandFragmentFile);
+            vertexCode = getShaderCode(fullScreenRectFile);
+            fragmentCode = getShaderCode(debandFragmentFile);
 
-        struct{
-            float     screenWidth;
-            float     screenHeight;
-            float     reverseScreenWidth;
-            float     reverseScreenHeight;
-            float     debandAvgdiff;
-            float     debandMaxdiff;
-            float     debandMiddiff;
-            float     range;
-            int32_t   iterations;
-        } debandOptions {};
+            //the screen size is a push constant, the options start at constant_id 4
+            struct{
+                float     debandAvgdiff;
+                float     debandMaxdiff;
+                float     debandMiddiff;
+                float     range;
+                int32_t   iterations;
+            } debandOptions {};
 
-        debandOptions.screenWidth = (float) imageExtent.width;
-        debandOptions.screenHeight = (float) imageExtent.height;
-        debandOptions.reverseScreenWidth = 1.0f / imageExtent.width;
-        debandOptions.reverseScreenHeight = 1.0f / imageExtent.height;
+            //get Options
+            debandOptions.debandAvgdiff = std::stod(pConfig->getOption("debandAvgdiff", "3.4"));
+            debandOptions.debandMaxdiff = std::stod(pConfig->getOption("debandMaxdiff", "6.8"));
+            debandOptions.debandMiddiff = std::stod(pConfig->getOption("debandMiddiff", "3.3"));
+            debandOptions.range         = std::stod(pConfig->getOption("debandRange", "16.0"));
+            debandOptions.iterations    = std::stoi(pConfig->getOption("debandIterations", "4"));
 
-        //get Options
-        debandOptions.debandAvgdiff = std::stod(pConfig->getOption("debandAvgdiff", "3.4"));
-        debandOptions.debandMaxdiff = std::stod(pConfig->getOption("debandMaxdiff", "6.8"));
-        debandOptions.debandMiddiff = std::stod(pConfig->getOption("debandMiddiff", "3.3"));
-        debandOptions.range         = std::stod(pConfig->getOption("debandRange", "16.0"));
-        debandOptions.iterations    = std::stoi(pConfig->getOption("debandIterations", "4"));
+            std::vector<VkSpecializationMapEntry> specMapEntrys(5);
+            for(uint32_t i=0;i<specMapEntrys.size();i++)
+            {
+                specMapEntrys[i].constantID = i + 4;
+                specMapEntrys[i].offset = sizeof(float) * i;//TODO not clean to assume that sizeof(int32_t) == sizeof(float)
+                specMapEntrys[i].size = sizeof(float);
+            }
 
-        std::vector<VkSpecializationMapEntry> specMapEntrys(9);
-        for(uint32_t i=0;i<specMapEntrys.size();i++)
-        {
-            specMapEntrys[i].constantID = i;
-            specMapEntrys[i].offset = sizeof(float) * i;//TODO not clean to assume that sizeof(int32_t) == sizeof(float)
-            specMapEntrys[i].size = sizeof(float);
-        }
+            VkSpecializationInfo specializationInfo;
+            specializationInfo.mapEntryCount = specMapEntrys.size();
+            specializationInfo.pMapEntries = specMapEntrys.data();
+            specializationInfo.dataSize = sizeof(debandOptions);
+            specializationInfo.pData = &debandOptions;
 
-        VkSpecializationInfo specializationInfo;
-        specializationInfo.mapEntryCount = specMapEntrys.size();
-        specializationInfo.pMapEntries = specMapEntrys.data();
-        specializationInfo.dataSize = sizeof(debandOptions);
-        specializationInfo.pData = &debandOptions;
+            pVertexSpecInfo = nullptr;
+            pFragmentSpecInfo = &specializationInfo;
 
-        pVertexSpecInfo = nullptr;
-        pFragmentSpecInfo = &specializationInfo;
+            buildState();
+        }
 
-        init(physicalDevice, instanceDispatchTable, device, dispatchTable, format,  imageExtent, inputImages, outputImages, pConfig);
+        init(pLogicalDevice, format,  imageExtent, inputImages, outputImages, pConfig);
     }
     DebandEffect::~DebandEffect()
     {
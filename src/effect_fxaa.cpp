@@ -21,43 +21,48 @@
 
 namespace vkBasalt
 {
-    FxaaEffect::FxaaEffect(VkPhysicalDevice physicalDevice, VkLayerInstanceDispatchTable instanceDispatchTable, VkDevice device, VkLayerDispatchTable dispatchTable, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig)
+    FxaaEffect::FxaaEffect(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig, std::shared_ptr<EffectState> pOldState)
     {
-        std::string fullScreenRectFile = "full_screen_triangle.vert.spv";
-        std::string fxaaFragmentFile = "fxaa.frag.spv";
+        pState = reuseEffectState<SimpleEffectState>(pOldState, pLogicalDevice, format, pConfig, "fxaa");
+        if(!pState->isBuilt())
+        {
+            std::string fullScreenRectFile = "full_screen_triangle.vert.spv";
+            std::string fxaaFragmentFile = "fxaa.frag.spv";
 
-        float fxaaQualitySubpix = std::stod(pConfig->getOption("fxaaQualitySubpix", "0.75"));
-        float fxaaQualityEdgeThreshold = std::stod(pConfig->getOption("fxaaQualityEdgeThreshold", "0.125"));
-        float fxaaQualityEdgeThresholdMin = std::stod(pConfig->getOption("fxaaQualityEdgeThresholdMin", "0.0312"));
+            float fxaaQualitySubpix = std::stod(pConfig->getOption("fxaaQualitySubpix", "0.75"));
+            float fxaaQualityEdgeThreshold = std::stod(pConfig->getOption("fxaaQualityEdgeThreshold", "0.125"));
+            float fxaaQualityEdgeThresholdMin = std::stod(pConfig->getOption("fxaaQualityEdgeThresholdMin", "0.0312"));
 
-        vertexCode   = readFile(fullScreenRectFile);
-        fragmentCode = readFile(fxaaFragmentFile);
+            vertexCode   = getShaderCode(fullScreenRectFile);
+            fragmentCode = getShaderCode(fxaaFragmentFile);
 
-        std::vector<VkSpecializationMapEntry> specMapEntrys(5);
+            //the screen size is a push constant, so the pipeline does not depend on the extent
+            std::vector<VkSpecializationMapEntry> specMapEntrys(3);
 
-        for(uint32_t i=0;i<specMapEntrys.size();i++)
-        {
-            specMapEntrys[i].constantID = i;
-            specMapEntrys[i].offset = sizeof(float) * i;
-            specMapEntrys[i].size = sizeof(float);
-        }
-        std::vector<float> specData = {fxaaQualitySubpix,
-                                       fxaaQualityEdgeThreshold,
-                                       fxaaQualityEdgeThresholdMin,
-                                       (float) imageExtent.width,
-                                       (float) imageExtent.height
-                                      };
+            for(uint32_t i=0;i<specMapEntrys.size();i++)
+            {
+                specMapEntrys[i].constantID = i;
+                specMapEntrys[i].offset = sizeof(float) * i;
+                specMapEntrys[i].size = sizeof(float);
+            }
+            std::vector<float> specData = {fxaaQualitySubpix,
+                                           fxaaQualityEdgeThreshold,
+                                           fxaaQualityEdgeThresholdMin
+                                          };
 
-        VkSpecializationInfo fragmentSpecializationInfo;
-        fragmentSpecializationInfo.mapEntryCount = specMapEntrys.size();
-        fragmentSpecializationInfo.pMapEntries = specMapEntrys.data();
-        fragmentSpecializationInfo.dataSize = sizeof(float)*specData.size();
-        fragmentSpecializationInfo.pData = specData.data();
+            VkSpecializationInfo fragmentSpecializationInfo;
+            fragmentSpecializationInfo.mapEntryCount = specMapEntrys.size();
+            fragmentSpecializationInfo.pMapEntries = specMapEntrys.data();
+            fragmentSpecializationInfo.dataSize = sizeof(float)*specData.size();
+            fragmentSpecializationInfo.pData = specData.data();
 
-        pVertexSpecInfo = nullptr;
-        pFragmentSpecInfo = &fragmentSpecializationInfo;
+            pVertexSpecInfo = nullptr;
+            pFragmentSpecInfo = &fragmentSpecializationInfo;
+
+            buildState();
+        }
 
-        init(physicalDevice, instanceDispatchTable, device, dispatchTable, format,  imageExtent, inputImages, outputImages, pConfig);
+        init(pLogicalDevice, format,  imageExtent, inputImages, outputImages, pConfig);
     }
     FxaaEffect::~FxaaEffect()
     {
@@ -25,109 +25,132 @@
 
 namespace vkBasalt
 {
-    LutEffect::LutEffect(VkPhysicalDevice physicalDevice, VkLayerInstanceDispatchTable instanceDispatchTable, VkDevice device, VkLayerDispatchTable dispatchTable, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig, VkQueue queue, VkCommandPool commandPool)
+    LutEffectState::LutEffectState(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format, std::shared_ptr<vkBasalt::Config> pConfig, const std::string& name)
+        : SimpleEffectState(pLogicalDevice, format, pConfig, name)
     {
-        std::string fullScreenRectFile = "full_screen_triangle.vert.spv";
-        std::string lutFragmentFile = "lut.frag.spv";
+        lutImage = VK_NULL_HANDLE;
+        lutImageView = VK_NULL_HANDLE;
+        lutDescriptorSetLayout = VK_NULL_HANDLE;
+        lutDescriptorPool = VK_NULL_HANDLE;
+        lutDescriptorSet = VK_NULL_HANDLE;
+    }
+    LutEffectState::~LutEffectState()
+    {
+        discardUpload(pLogicalDevice.get(), lutImage);
+        pLogicalDevice->dispatchTable.DestroyImageView(pLogicalDevice->device,lutImageView,nullptr);
+        pLogicalDevice->dispatchTable.DestroyImage(pLogicalDevice->device,lutImage,nullptr);
+        pLogicalDevice->objectCache.release(CachedType::DescriptorSetLayout, lutDescriptorSetLayout);
+        pLogicalDevice->dispatchTable.DestroyDescriptorPool(pLogicalDevice->device,lutDescriptorPool,nullptr);
+        pLogicalDevice->memoryAllocator.free(lutMemory);
+        pLogicalDevice->resourceTracker.remove(ResourceType::ImageView, lutImageView);
+        pLogicalDevice->resourceTracker.remove(ResourceType::Image, lutImage);
+        pLogicalDevice->resourceTracker.remove(ResourceType::DescriptorPool, lutDescriptorPool);
+    }
 
-        vertexCode = readFile(fullScreenRectFile);
-        fragmentCode = readFile(lutFragmentFile);
-        
-        int height;
-        LutCube lutCube;
-        stbi_uc* pixels;
-        int32_t usingPNG = (pConfig->getOption("lutFile").find(".cube") != std::string::npos || pConfig->getOption("lutFile").find(".CUBE") != std::string::npos) ? 0 : 1;  
-        if(!usingPNG)
-        {
-            lutCube = LutCube(pConfig->getOption("lutFile"));
-            pixels = lutCube.colorCube.data();
-            height = lutCube.size;
-        }
-        else
+    LutEffect::LutEffect(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig, std::shared_ptr<EffectState> pOldState)
+    {
+        pLutState = reuseEffectState<LutEffectState>(pOldState, pLogicalDevice, format, pConfig, "lut");
+        pState = pLutState;
+        if(!pLutState->isBuilt())
         {
-            int channels, width;
-            pixels = stbi_load(pConfig->getOption("lutFile").c_str(), &width, &height, &channels, STBI_rgb_alpha);
-            if(width != height * height)
+            ResourceScope resourceScope(pLutState->resourceOwner);
+
+            std::string fullScreenRectFile = "full_screen_triangle.vert.spv";
+            std::string lutFragmentFile = "lut.frag.spv";
+
+            vertexCode = getShaderCode(fullScreenRectFile);
+            fragmentCode = getShaderCode(lutFragmentFile);
+            
+            int height;
+            LutCube lutCube;
+            stbi_uc* pixels;
+            int32_t usingPNG = (pConfig->getOption("lutFile").find(".cube") != std::string::npos || pConfig->getOption("lutFile").find(".CUBE") != std::string::npos) ? 0 : 1;  
+            if(!usingPNG)
             {
-                throw std::runtime_error("bad lut");
+                lutCube = LutCube(pConfig->getOption("lutFile"));
+                pixels = lutCube.colorCube.data();
+                height = lutCube.size;
             }
-        }
-        
-        std::vector<VkSpecializationMapEntry> specMapEntrys(2);
-        for(uint32_t i=0;i<specMapEntrys.size();i++)
-        {
-            specMapEntrys[i].constantID = i;
-            specMapEntrys[i].offset = sizeof(int32_t) * i;
-            specMapEntrys[i].size = sizeof(int32_t);
-        }
-        std::vector<int32_t> specData = {height, usingPNG};
+            else
+            {
+                int channels, width;
+                pixels = stbi_load(pConfig->getOption("lutFile").c_str(), &width, &height, &channels, STBI_rgb_alpha);
+                if(width != height * height)
+                {
+                    throw std::runtime_error("bad lut");
+                }
+            }
+            
+            std::vector<VkSpecializationMapEntry> specMapEntrys(2);
+            for(uint32_t i=0;i<specMapEntrys.size();i++)
+            {
+                specMapEntrys[i].constantID = i;
+                specMapEntrys[i].offset = sizeof(int32_t) * i;
+                specMapEntrys[i].size = sizeof(int32_t);
+            }
+            std::vector<int32_t> specData = {height, usingPNG};
+
+            VkSpecializationInfo fragmentSpecializationInfo;
+            fragmentSpecializationInfo.mapEntryCount = specMapEntrys.size();
+            fragmentSpecializationInfo.pMapEntries = specMapEntrys.data();
+            fragmentSpecializationInfo.dataSize = specMapEntrys.size() * sizeof(int32_t);
+            fragmentSpecializationInfo.pData = specData.data();
 
-        VkSpecializationInfo fragmentSpecializationInfo;
-        fragmentSpecializationInfo.mapEntryCount = specMapEntrys.size();
-        fragmentSpecializationInfo.pMapEntries = specMapEntrys.data();
-        fragmentSpecializationInfo.dataSize = specMapEntrys.size() * sizeof(int32_t);
-        fragmentSpecializationInfo.pData = specData.data();
+            pVertexSpecInfo = nullptr;
+            pFragmentSpecInfo = &fragmentSpecializationInfo;
+            
+            //the lut data is always rgba8, make sure the device can sample it linear
+            if(pLogicalDevice->physicalDeviceInfo.findSupportedFormat({VK_FORMAT_R8G8B8A8_UNORM}, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) == VK_FORMAT_UNDEFINED)
+            {
+                throw std::runtime_error("R8G8B8A8_UNORM can not be sampled linear, needed for the lut");
+            }
 
-        pVertexSpecInfo = nullptr;
-        pFragmentSpecInfo = &fragmentSpecializationInfo;
-        
-        VkExtent3D lutImageExtent = {(uint32_t) height, (uint32_t) height, (uint32_t) height};
-        lutImage = createImages(instanceDispatchTable,
-                                 device,
-                                 dispatchTable,
-                                 physicalDevice,
-                                 1,
-                                 lutImageExtent,
-                                 VK_FORMAT_R8G8B8A8_UNORM,//TODO search for format and save it
-                                 VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                 lutMemory)[0];
-        
-        uploadToImage(instanceDispatchTable,
-                       device,
-                       dispatchTable,
-                       physicalDevice,
-                       lutImage,
-                       lutImageExtent,
-                       height*height*height*4,
-                       queue,
-                       commandPool,
-                       pixels);
-                       
-        lutImageView = createImageViews(device, dispatchTable, VK_FORMAT_R8G8B8A8_UNORM, std::vector<VkImage>(1,lutImage), VK_IMAGE_VIEW_TYPE_3D)[0];
-        
-        lutDescriptorSetLayout = createImageSamplerDescriptorSetLayout(device, dispatchTable, 1);
-        descriptorSetLayouts.push_back(lutDescriptorSetLayout);
-        
-        VkDescriptorPoolSize imagePoolSize;
-        imagePoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        imagePoolSize.descriptorCount = 1;
+            VkExtent3D lutImageExtent = {(uint32_t) height, (uint32_t) height, (uint32_t) height};
+            pLutState->lutImage = createImages(pLogicalDevice.get(),
+                                               1,
+                                               lutImageExtent,
+                                               VK_FORMAT_R8G8B8A8_UNORM,
+                                               VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                               pLutState->lutMemory)[0];
+            
+            uploadToImage(pLogicalDevice.get(),
+                           pLutState->lutImage,
+                           lutImageExtent,
+                           height*height*height*4,
+                           pixels);
+                           
+            pLutState->lutImageView = createImageViews(pLogicalDevice.get(), VK_FORMAT_R8G8B8A8_UNORM, std::vector<VkImage>(1,pLutState->lutImage), VK_IMAGE_VIEW_TYPE_3D)[0];
+            
+            pLutState->lutDescriptorSetLayout = createImageSamplerDescriptorSetLayout(pLogicalDevice.get(), 1);
+            descriptorSetLayouts.push_back(pLutState->lutDescriptorSetLayout);
+            
+            VkDescriptorPoolSize imagePoolSize;
+            imagePoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            imagePoolSize.descriptorCount = 1;
 
-        std::vector<VkDescriptorPoolSize> poolSizes = {imagePoolSize};
-        
-        lutDescriptorPool = createDescriptorPool(device, dispatchTable, poolSizes);
+            std::vector<VkDescriptorPoolSize> poolSizes = {imagePoolSize};
+            
+            pLutState->lutDescriptorPool = createDescriptorPool(pLogicalDevice.get(), poolSizes);
 
-        init(physicalDevice, instanceDispatchTable, device, dispatchTable, format,  imageExtent, inputImages, outputImages, pConfig);
-        
-        lutDescriptorSet = allocateAndWriteImageSamplerDescriptorSets(device,
-                                                                         dispatchTable,
-                                                                         lutDescriptorPool,
-                                                                         lutDescriptorSetLayout,
-                                                                         sampler,
-                                                                         std::vector<std::vector<VkImageView>>(1,std::vector<VkImageView>(1,lutImageView)))[0];
+            buildState();
+            
+            pLutState->lutDescriptorSet = allocateAndWriteImageSamplerDescriptorSets(pLogicalDevice.get(),
+                                                                                     pLutState->lutDescriptorPool,
+                                                                                     pLutState->lutDescriptorSetLayout,
+                                                                                     pLutState->sampler,
+                                                                                     std::vector<std::vector<VkImageView>>(1,std::vector<VkImageView>(1,pLutState->lutImageView)))[0];
+        }
+
+        init(pLogicalDevice, format,  imageExtent, inputImages, outputImages, pConfig);
     }
     LutEffect::~LutEffect()
     {
-        dispatchTable.DestroyImageView(device,lutImageView,nullptr);
-        dispatchTable.DestroyImage(device,lutImage,nullptr);
-        dispatchTable.DestroyDescriptorSetLayout(device,lutDescriptorSetLayout,nullptr);
-        dispatchTable.DestroyDescriptorPool(device,lutDescriptorPool,nullptr);
-        dispatchTable.FreeMemory(device,lutMemory,nullptr);
-        
+
     }
     void LutEffect::applyEffect(uint32_t imageIndex, VkCommandBuffer commandBuffer)
     {
-        dispatchTable.CmdBindDescriptorSets(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,pipelineLayout,1,1,&(lutDescriptorSet),0,nullptr);
+        pLogicalDevice->dispatchTable.CmdBindDescriptorSets(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,pLutState->pipelineLayout,1,1,&(pLutState->lutDescriptorSet),0,nullptr);
         SimpleEffect::applyEffect(imageIndex, commandBuffer);
     }
 }
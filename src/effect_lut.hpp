@@ -16,20 +16,30 @@
 #include "config.hpp"
 
 namespace vkBasalt{
-    class LutEffect : public SimpleEffect
+    //the lut texture does not depend on the extent either, so it is uploaded once
+    class LutEffectState : public SimpleEffectState
     {
     public:
-        LutEffect(VkPhysicalDevice physicalDevice, VkLayerInstanceDispatchTable instanceDispatchTable, VkDevice device, VkLayerDispatchTable dispatchTable, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig, VkQueue queue, VkCommandPool commandPool);
-        ~LutEffect();
-        void applyEffect(uint32_t imageIndex, VkCommandBuffer commandBuffer) override;
-    private:
+        LutEffectState(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format, std::shared_ptr<vkBasalt::Config> pConfig, const std::string& name);
+        ~LutEffectState();
+
         VkImage lutImage;
-        VkDeviceMemory lutMemory;
+        MemoryAllocation lutMemory;
         VkImageView lutImageView;
         VkDescriptorSetLayout lutDescriptorSetLayout;
         VkDescriptorPool lutDescriptorPool;
         VkDescriptorSet lutDescriptorSet;
     };
+
+    class LutEffect : public SimpleEffect
+    {
+    public:
+        LutEffect(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig, std::shared_ptr<EffectState> pOldState);
+        ~LutEffect();
+        void applyEffect(uint32_t imageIndex, VkCommandBuffer commandBuffer) override;
+    private:
+        std::shared_ptr<LutEffectState> pLutState;
+    };
 }
 
 
@@ -1,4 +1,5 @@
 #include "effect_simple.hpp"
+#include "logger.hpp"
 
 #include <cstring>
 
@@ -21,33 +22,81 @@
 
 namespace vkBasalt
 {
+    SimpleEffectState::SimpleEffectState(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format, std::shared_ptr<vkBasalt::Config> pConfig, const std::string& name)
+        : EffectState(pLogicalDevice, format, pConfig, name)
+    {
+        imageSamplerDescriptorSetLayout = VK_NULL_HANDLE;
+        vertexModule = VK_NULL_HANDLE;
+        fragmentModule = VK_NULL_HANDLE;
+        renderPass = VK_NULL_HANDLE;
+        pipelineLayout = VK_NULL_HANDLE;
+        graphicsPipeline = VK_NULL_HANDLE;
+        sampler = VK_NULL_HANDLE;
+    }
+    bool SimpleEffectState::isBuilt()
+    {
+        return graphicsPipeline != VK_NULL_HANDLE;
+    }
+    SimpleEffectState::~SimpleEffectState()
+    {
+        Logger::debug("destroying SimpleEffectState", this);
+        pLogicalDevice->dispatchTable.DestroyPipeline(pLogicalDevice->device, graphicsPipeline, nullptr);
+        pLogicalDevice->resourceTracker.remove(ResourceType::Pipeline, graphicsPipeline);
+        pLogicalDevice->dispatchTable.DestroyPipelineLayout(pLogicalDevice->device,pipelineLayout,nullptr);
+        pLogicalDevice->objectCache.release(CachedType::RenderPass, renderPass);
+        pLogicalDevice->objectCache.release(CachedType::DescriptorSetLayout, imageSamplerDescriptorSetLayout);
+        pLogicalDevice->objectCache.release(CachedType::ShaderModule, vertexModule);
+        pLogicalDevice->objectCache.release(CachedType::ShaderModule, fragmentModule);
+        pLogicalDevice->objectCache.release(CachedType::Sampler, sampler);
+    }
+
     SimpleEffect::SimpleEffect()
     {
     
     }
-    void SimpleEffect::init(VkPhysicalDevice physicalDevice, VkLayerInstanceDispatchTable instanceDispatchTable, VkDevice device, VkLayerDispatchTable dispatchTable, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig)
+    void SimpleEffect::buildState()
+    {
+        Logger::debug("in building SimpleEffectState ");
+        LogicalDevice* pStateDevice = pState->pLogicalDevice.get();
+        ResourceScope resourceScope(pState->resourceOwner);
+
+        pState->sampler = createSampler(pStateDevice);
+        Logger::debug("after creating sampler");
+        
+        pState->imageSamplerDescriptorSetLayout = createImageSamplerDescriptorSetLayout(pStateDevice, 1);
+        Logger::debug("after creating descriptorSetLayouts");
+        
+        createShaderModule(pStateDevice, vertexCode, &pState->vertexModule);
+        createShaderModule(pStateDevice, fragmentCode, &pState->fragmentModule);
+        
+        pState->renderPass = createRenderPass(pStateDevice, pState->format);
+        
+        descriptorSetLayouts.insert(descriptorSetLayouts.begin(),pState->imageSamplerDescriptorSetLayout);
+        pState->pipelineLayout = createGraphicsPipelineLayout(pStateDevice, descriptorSetLayouts);
+        
+        pState->graphicsPipeline = createGraphicsPipeline(pStateDevice,
+                                                          pState->vertexModule,
+                                                          pVertexSpecInfo,
+                                                          pState->fragmentModule,
+                                                          pFragmentSpecInfo,
+                                                          pState->renderPass,
+                                                          pState->pipelineLayout);
+    }
+    void SimpleEffect::init(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig)
     {
-        std::cout << "in creating SimpleEffect " << std::endl;
+        Logger::debug("in creating SimpleEffect ");
         
-        this->physicalDevice = physicalDevice;
-        this->instanceDispatchTable = instanceDispatchTable;
-        this->device = device;
-        this->dispatchTable = dispatchTable;
+        this->pLogicalDevice = pLogicalDevice;
         this->format = format;
         this->imageExtent = imageExtent;
         this->inputImages = inputImages;
         this->outputImages = outputImages;
         this->pConfig = pConfig;
         
-        inputImageViews = createImageViews(device, dispatchTable, format, inputImages);
-        std::cout << "after creating input ImageViews" << std::endl;
-        outputImageViews = createImageViews(device, dispatchTable, format, outputImages);
-        std::cout << "after creating ImageViews" << std::endl;
-        sampler = createSampler(device, dispatchTable);
-        std::cout << "after creating sampler" << std::endl;
-        
-        imageSamplerDescriptorSetLayout = createImageSamplerDescriptorSetLayout(device, dispatchTable, 1);
-        std::cout << "after creating descriptorSetLayouts" << std::endl;
+        inputImageViews = createImageViews(pLogicalDevice.get(), format, inputImages);
+        Logger::debug("after creating input ImageViews");
+        outputImageViews = createImageViews(pLogicalDevice.get(), format, outputImages);
+        Logger::debug("after creating ImageViews");
         
         VkDescriptorPoolSize imagePoolSize;
         imagePoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -56,32 +105,20 @@ namespace vkBasalt
         
         std::vector<VkDescriptorPoolSize> poolSizes = {imagePoolSize};
         
-        descriptorPool = createDescriptorPool(device, dispatchTable, poolSizes);
-        std::cout << "after creating descriptorPool" << std::endl;
-        
-        createShaderModule(device, dispatchTable, vertexCode, &vertexModule);
-        createShaderModule(device, dispatchTable, fragmentCode, &fragmentModule);
-        
-        renderPass = createRenderPass(device, dispatchTable, format);
+        descriptorPool = createDescriptorPool(pLogicalDevice.get(), poolSizes);
+        Logger::debug("after creating descriptorPool");
         
-        descriptorSetLayouts.insert(descriptorSetLayouts.begin(),imageSamplerDescriptorSetLayout);
-        pipelineLayout = createGraphicsPipelineLayout(device, dispatchTable, descriptorSetLayouts);
-        
-        graphicsPipeline = createGraphicsPipeline(device, dispatchTable, vertexModule, pVertexSpecInfo, fragmentModule, pFragmentSpecInfo, imageExtent, renderPass, pipelineLayout);
-        
-        
-        imageDescriptorSets = allocateAndWriteImageSamplerDescriptorSets(device,
-                                                                         dispatchTable,
+        imageDescriptorSets = allocateAndWriteImageSamplerDescriptorSets(pLogicalDevice.get(),
                                                                          descriptorPool,
-                                                                         imageSamplerDescriptorSetLayout,
-                                                                         sampler,
+                                                                         pState->imageSamplerDescriptorSetLayout,
+                                                                         pState->sampler,
                                                                          std::vector<std::vector<VkImageView>>(1,inputImageViews));
         
-        framebuffers = createFramebuffers(device, dispatchTable, renderPass, imageExtent, outputImageViews);
+        framebuffers = createFramebuffers(pLogicalDevice.get(), pState->renderPass, imageExtent, outputImageViews);
     }
     void SimpleEffect::applyEffect(uint32_t imageIndex, VkCommandBuffer commandBuffer)
     {
-        std::cout << "applying SimpleEffect" << commandBuffer << std::endl;
+        Logger::trace("applying SimpleEffect", commandBuffer);
         //Used to make the Image accessable by the shader
         VkImageMemoryBarrier memoryBarrier;
         memoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -116,17 +153,17 @@ namespace vkBasalt
         secondBarrier.subresourceRange.baseArrayLayer = 0;
         secondBarrier.subresourceRange.layerCount = 1;
         
-        dispatchTable.CmdPipelineBarrier(commandBuffer,VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,0,0, nullptr,0, nullptr,1, &memoryBarrier);
-        std::cout << "after the first pipeline barrier" << std::endl;
+        pLogicalDevice->dispatchTable.CmdPipelineBarrier(commandBuffer,VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,0,0, nullptr,0, nullptr,1, &memoryBarrier);
+        Logger::trace("after the first pipeline barrier");
         
-        std::cout << "framebuffer " << framebuffers.size() << std::endl;
+        Logger::trace("framebuffer ", framebuffers.size());
         
-        std::cout << "framebuffer " << framebuffers[imageIndex] << std::endl;
+        Logger::trace("framebuffer ", framebuffers[imageIndex]);
 
         VkRenderPassBeginInfo renderPassBeginInfo;
         renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassBeginInfo.pNext = nullptr;
-        renderPassBeginInfo.renderPass = renderPass;
+        renderPassBeginInfo.renderPass = pState->renderPass;
         renderPassBeginInfo.framebuffer = framebuffers[imageIndex];
         renderPassBeginInfo.renderArea.offset = {0,0};
         renderPassBeginInfo.renderArea.extent = imageExtent;
@@ -134,44 +171,46 @@ namespace vkBasalt
         renderPassBeginInfo.clearValueCount = 1;
         renderPassBeginInfo.pClearValues = &clearValue;
         
-        std::cout << "before beginn renderpass" << std::endl;
-        dispatchTable.CmdBeginRenderPass(commandBuffer,&renderPassBeginInfo,VK_SUBPASS_CONTENTS_INLINE);
-        std::cout << "after beginn renderpass" << std::endl;
+        Logger::trace("before beginn renderpass");
+        pLogicalDevice->dispatchTable.CmdBeginRenderPass(commandBuffer,&renderPassBeginInfo,VK_SUBPASS_CONTENTS_INLINE);
+        Logger::trace("after beginn renderpass");
         
-        dispatchTable.CmdBindDescriptorSets(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,pipelineLayout,0,1,&(imageDescriptorSets[imageIndex]),0,nullptr);
-        std::cout << "after binding image sampler" << std::endl;
+        pLogicalDevice->dispatchTable.CmdBindDescriptorSets(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,pState->pipelineLayout,0,1,&(imageDescriptorSets[imageIndex]),0,nullptr);
+        Logger::trace("after binding image sampler");
         
-        dispatchTable.CmdBindPipeline(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,graphicsPipeline);
-        std::cout << "after bind pipeliene" << std::endl;
+        pLogicalDevice->dispatchTable.CmdBindPipeline(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,pState->graphicsPipeline);
+        Logger::trace("after bind pipeliene");
+
+        recordScreenExtent(pLogicalDevice.get(), commandBuffer, pState->pipelineLayout, imageExtent);
         
-        dispatchTable.CmdDraw(commandBuffer, 3, 1, 0, 0);
-        std::cout << "after draw" << std::endl;
+        pLogicalDevice->dispatchTable.CmdDraw(commandBuffer, 3, 1, 0, 0);
+        Logger::trace("after draw");
 
-        dispatchTable.CmdEndRenderPass(commandBuffer);
-        std::cout << "after end renderpass" << std::endl;
+        pLogicalDevice->dispatchTable.CmdEndRenderPass(commandBuffer);
+        Logger::trace("after end renderpass");
         
-        dispatchTable.CmdPipelineBarrier(commandBuffer,VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,0,0, nullptr,0, nullptr,1, &secondBarrier);
-        std::cout << "after the second pipeline barrier" << std::endl;
+        pLogicalDevice->dispatchTable.CmdPipelineBarrier(commandBuffer,VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,0,0, nullptr,0, nullptr,1, &secondBarrier);
+        Logger::trace("after the second pipeline barrier");
 
     }
+    std::shared_ptr<EffectState> SimpleEffect::getState()
+    {
+        return pState;
+    }
     SimpleEffect::~SimpleEffect()
     {
-        std::cout << "destroying SimpleEffect" << this << std::endl;
-        dispatchTable.DestroyPipeline(device, graphicsPipeline, nullptr);
-        dispatchTable.DestroyPipelineLayout(device,pipelineLayout,nullptr);
-        dispatchTable.DestroyRenderPass(device,renderPass,nullptr);
-        dispatchTable.DestroyDescriptorSetLayout(device,imageSamplerDescriptorSetLayout,nullptr);
-        dispatchTable.DestroyShaderModule(device,vertexModule,nullptr);
-        dispatchTable.DestroyShaderModule(device,fragmentModule,nullptr);
-        
-        dispatchTable.DestroyDescriptorPool(device,descriptorPool,nullptr);
+        Logger::debug("destroying SimpleEffect", this);
+        pLogicalDevice->dispatchTable.DestroyDescriptorPool(pLogicalDevice->device,descriptorPool,nullptr);
+        pLogicalDevice->resourceTracker.remove(ResourceType::DescriptorPool, descriptorPool);
         for(unsigned int i=0;i<framebuffers.size();i++)
         {
-            dispatchTable.DestroyFramebuffer(device,framebuffers[i],nullptr);
-            dispatchTable.DestroyImageView(device,inputImageViews[i],nullptr);
-            dispatchTable.DestroyImageView(device,outputImageViews[i],nullptr);
-            std::cout << "after DestroyImageView" << std::endl;
+            pLogicalDevice->dispatchTable.DestroyFramebuffer(pLogicalDevice->device,framebuffers[i],nullptr);
+            pLogicalDevice->dispatchTable.DestroyImageView(pLogicalDevice->device,inputImageViews[i],nullptr);
+            pLogicalDevice->dispatchTable.DestroyImageView(pLogicalDevice->device,outputImageViews[i],nullptr);
+            Logger::debug("after DestroyImageView");
         }
-        dispatchTable.DestroySampler(device,sampler,nullptr);
+        pLogicalDevice->resourceTracker.remove(ResourceType::Framebuffer, framebuffers);
+        pLogicalDevice->resourceTracker.remove(ResourceType::ImageView, inputImageViews);
+        pLogicalDevice->resourceTracker.remove(ResourceType::ImageView, outputImageViews);
     }
 }
@@ -13,44 +13,57 @@
 #include "vulkan/vk_layer_dispatch_table.h"
 
 #include "effect.hpp"
+#include "logical_device.hpp"
 #include "config.hpp"
+#include "shader.hpp"
 
 namespace vkBasalt{
+    class SimpleEffectState : public EffectState
+    {
+    public:
+        SimpleEffectState(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format, std::shared_ptr<vkBasalt::Config> pConfig, const std::string& name);
+        virtual ~SimpleEffectState();
+        bool isBuilt();
+
+        VkDescriptorSetLayout imageSamplerDescriptorSetLayout;
+        VkShaderModule vertexModule;
+        VkShaderModule fragmentModule;
+        VkRenderPass renderPass;
+        VkPipelineLayout pipelineLayout;
+        VkPipeline graphicsPipeline;
+        VkSampler sampler;
+    };
+
     class SimpleEffect : public Effect
     {
     public:
         SimpleEffect();
         void virtual applyEffect(uint32_t imageIndex, VkCommandBuffer commandBuffer) override;
+        std::shared_ptr<EffectState> getState() override;
         virtual ~SimpleEffect();
     protected:
-        VkPhysicalDevice physicalDevice;
-        VkLayerInstanceDispatchTable instanceDispatchTable;
-        VkDevice device;
-        VkLayerDispatchTable dispatchTable;
+        std::shared_ptr<LogicalDevice> pLogicalDevice;
+        std::shared_ptr<SimpleEffectState> pState;//set by the subclass before buildState and init
         std::vector<VkImage> inputImages;
         std::vector<VkImage> outputImages;
         std::vector<VkImageView> inputImageViews;
         std::vector<VkImageView> outputImageViews;
         std::vector<VkDescriptorSet> imageDescriptorSets;
         std::vector<VkFramebuffer> framebuffers;
-        VkDescriptorSetLayout imageSamplerDescriptorSetLayout;
         VkDescriptorPool descriptorPool;
-        VkShaderModule vertexModule;
-        VkShaderModule fragmentModule;
-        VkRenderPass renderPass;
-        VkPipelineLayout pipelineLayout;
-        VkPipeline graphicsPipeline;
         VkExtent2D imageExtent;
         VkFormat format;
-        VkSampler sampler;
         std::shared_ptr<vkBasalt::Config> pConfig;
-        std::vector<char> vertexCode;
-        std::vector<char> fragmentCode;
+        //only needed by buildState, a reused state does not read the shaders again
+        ShaderCode vertexCode;
+        ShaderCode fragmentCode;
         VkSpecializationInfo* pVertexSpecInfo;
         VkSpecializationInfo* pFragmentSpecInfo;
         std::vector<VkDescriptorSetLayout> descriptorSetLayouts;//subclasses can put DescriptorSets in here, but the first one will be the input image descriptorSet
         
-        void init(VkPhysicalDevice physicalDevice, VkLayerInstanceDispatchTable instanceDispatchTable, VkDevice device, VkLayerDispatchTable dispatchTable, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig);
+        //creates the objects of pState from the code and specialization infos above
+        void buildState();
+        void init(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig);
     };
 }
 
@@ -1,4 +1,5 @@
 #include "effect_smaa.hpp"
+#include "logger.hpp"
 
 #include <cstring>
 
@@ -25,11 +26,8 @@
 
 namespace vkBasalt
 {
+    //the screen size is a push constant, the options start at constant_id 4
     typedef struct {
-        float screenWidth;
-        float screenHeight;
-        float reverseScreenWidth;
-        float reverseScreenHeight;
         float threshold;
         int32_t maxSearchSteps;
         int32_t maxSearchStepsDiag;
@@ -38,7 +36,158 @@ namespace vkBasalt
 
 
 
-    SmaaEffect::SmaaEffect(VkPhysicalDevice physicalDevice, VkLayerInstanceDispatchTable instanceDispatchTable, VkDevice device, VkLayerDispatchTable dispatchTable, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig, VkQueue queue, VkCommandPool commandPool)
+    SmaaEffectState::SmaaEffectState(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format, std::shared_ptr<vkBasalt::Config> pConfig, const std::string& name)
+        : EffectState(pLogicalDevice, format, pConfig, name)
+    {
+        edgeFormat = VK_FORMAT_UNDEFINED;
+        blendFormat = VK_FORMAT_UNDEFINED;
+        areaImage = VK_NULL_HANDLE;
+        searchImage = VK_NULL_HANDLE;
+        areaImageView = VK_NULL_HANDLE;
+        searchImageView = VK_NULL_HANDLE;
+        imageSamplerDescriptorSetLayout = VK_NULL_HANDLE;
+        edgeVertexModule = VK_NULL_HANDLE;
+        edgeFragmentModule = VK_NULL_HANDLE;
+        blendVertexModule = VK_NULL_HANDLE;
+        blendFragmentModule = VK_NULL_HANDLE;
+        neighborVertexModule = VK_NULL_HANDLE;
+        neignborFragmentModule = VK_NULL_HANDLE;
+        renderPass = VK_NULL_HANDLE;
+        edgeRenderPass = VK_NULL_HANDLE;
+        unormRenderPass = VK_NULL_HANDLE;
+        pipelineLayout = VK_NULL_HANDLE;
+        edgePipeline = VK_NULL_HANDLE;
+        blendPipeline = VK_NULL_HANDLE;
+        neighborPipeline = VK_NULL_HANDLE;
+        sampler = VK_NULL_HANDLE;
+    }
+    bool SmaaEffectState::isBuilt()
+    {
+        return neighborPipeline != VK_NULL_HANDLE;
+    }
+    SmaaEffectState::~SmaaEffectState()
+    {
+        Logger::debug("destroying smaa effect state ", this);
+        pLogicalDevice->dispatchTable.DestroyPipeline(pLogicalDevice->device, edgePipeline,     nullptr);
+        pLogicalDevice->dispatchTable.DestroyPipeline(pLogicalDevice->device, blendPipeline,    nullptr);
+        pLogicalDevice->dispatchTable.DestroyPipeline(pLogicalDevice->device, neighborPipeline, nullptr);
+        pLogicalDevice->resourceTracker.remove(ResourceType::Pipeline, std::vector<VkPipeline>{edgePipeline, blendPipeline, neighborPipeline});
+
+        pLogicalDevice->dispatchTable.DestroyPipelineLayout(pLogicalDevice->device,pipelineLayout,nullptr);
+        pLogicalDevice->objectCache.release(CachedType::RenderPass, renderPass);
+        pLogicalDevice->objectCache.release(CachedType::RenderPass, edgeRenderPass);
+        pLogicalDevice->objectCache.release(CachedType::RenderPass, unormRenderPass);
+        pLogicalDevice->objectCache.release(CachedType::DescriptorSetLayout, imageSamplerDescriptorSetLayout);
+
+        pLogicalDevice->objectCache.release(CachedType::ShaderModule, edgeVertexModule);
+        pLogicalDevice->objectCache.release(CachedType::ShaderModule, edgeFragmentModule);
+        pLogicalDevice->objectCache.release(CachedType::ShaderModule, blendVertexModule);
+        pLogicalDevice->objectCache.release(CachedType::ShaderModule, blendFragmentModule);
+        pLogicalDevice->objectCache.release(CachedType::ShaderModule, neighborVertexModule);
+        pLogicalDevice->objectCache.release(CachedType::ShaderModule, neignborFragmentModule);
+
+        discardUpload(pLogicalDevice.get(), areaImage);
+        discardUpload(pLogicalDevice.get(), searchImage);
+        pLogicalDevice->dispatchTable.DestroyImageView(pLogicalDevice->device,areaImageView,nullptr);
+        pLogicalDevice->dispatchTable.DestroyImage(pLogicalDevice->device,areaImage,nullptr);
+        pLogicalDevice->dispatchTable.DestroyImageView(pLogicalDevice->device,searchImageView,nullptr);
+        pLogicalDevice->dispatchTable.DestroyImage(pLogicalDevice->device,searchImage,nullptr);
+        pLogicalDevice->memoryAllocator.free(areaMemory);
+        pLogicalDevice->memoryAllocator.free(searchMemory);
+        pLogicalDevice->resourceTracker.remove(ResourceType::ImageView, std::vector<VkImageView>{areaImageView, searchImageView});
+        pLogicalDevice->resourceTracker.remove(ResourceType::Image, std::vector<VkImage>{areaImage, searchImage});
+
+        pLogicalDevice->objectCache.release(CachedType::Sampler, sampler);
+    }
+
+    SmaaEffect::SmaaEffect(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig, std::shared_ptr<EffectState> pOldState)
+    {
+        Logger::debug("in creating SmaaEffect ");
+
+        this->pLogicalDevice = pLogicalDevice;
+        this->format = format;
+        this->imageExtent = imageExtent;
+        this->inputImages = inputImages;
+        this->outputImages = outputImages;
+        this->pConfig = pConfig;
+
+        pState = reuseEffectState<SmaaEffectState>(pOldState, pLogicalDevice, format, pConfig, "smaa");
+        if(!pState->isBuilt())
+        {
+            pState->blendFormat = pLogicalDevice->physicalDeviceInfo.findSupportedFormat({VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM},
+                                                                                          VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+            if(pState->blendFormat == VK_FORMAT_UNDEFINED)
+            {
+                throw std::runtime_error("no format for the smaa edge and blend images");
+            }
+            //the edge pass only writes red and green, set by the memory budget plan when memory is short
+            pState->edgeFormat = pState->blendFormat;
+            if(pConfig->getOption("smaaCompactEdges", "false") == "true")
+            {
+                VkFormat compactFormat = pLogicalDevice->physicalDeviceInfo.findSupportedFormat({VK_FORMAT_R8G8_UNORM},
+                                                                                                VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+                if(compactFormat != VK_FORMAT_UNDEFINED)
+                {
+                    pState->edgeFormat = compactFormat;
+                }
+            }
+        }
+
+        //the edge and blend images are only used inside applyEffect, so they share their memory with the scratch images of other effects
+        pScratchImage.reset(new ScratchImage(pLogicalDevice.get(),
+                                             {pState->edgeFormat, pState->blendFormat},
+                                             imageExtent,
+                                             VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+                                             inputImages.size()));
+        slotCount = pScratchImage->getSlotCount();
+        for(uint32_t i=0;i<slotCount;i++)
+        {
+            edgeImages.push_back(pScratchImage->getImages(i)[0]);
+            blendImages.push_back(pScratchImage->getImages(i)[1]);
+        }
+
+        if(!pState->isBuilt())
+        {
+            buildState();
+        }
+
+        inputImageViews = createImageViews(pLogicalDevice.get(), format, inputImages);
+        Logger::debug("after creating input ImageViews");
+        edgeImageViews = createImageViews(pLogicalDevice.get(), pState->edgeFormat, edgeImages);
+        Logger::debug("after creating edge  ImageViews");
+        blendImageViews = createImageViews(pLogicalDevice.get(), pState->blendFormat, blendImages);
+        Logger::debug("after creating blend ImageViews");
+        outputImageViews = createImageViews(pLogicalDevice.get(), format, outputImages);
+        Logger::debug("after creating output ImageViews");
+
+        VkDescriptorPoolSize imagePoolSize;
+        imagePoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        imagePoolSize.descriptorCount = inputImages.size()*5;
+
+        std::vector<VkDescriptorPoolSize> poolSizes = {imagePoolSize};
+
+        descriptorPool = createDescriptorPool(pLogicalDevice.get(), poolSizes);
+        Logger::debug("after creating descriptorPool");
+
+        std::vector<VkImageView> slotEdgeImageViews;
+        std::vector<VkImageView> slotBlendImageViews;
+        for(uint32_t i=0;i<inputImageViews.size();i++)
+        {
+            slotEdgeImageViews.push_back(edgeImageViews[i % slotCount]);
+            slotBlendImageViews.push_back(blendImageViews[i % slotCount]);
+        }
+        std::vector<std::vector<VkImageView>> imageViewsVector = {inputImageViews,
+                                                                  slotEdgeImageViews,
+                                                                  std::vector<VkImageView>(inputImageViews.size(), pState->areaImageView),
+                                                                  std::vector<VkImageView>(inputImageViews.size(), pState->searchImageView),
+                                                                  slotBlendImageViews};
+        imageDescriptorSets = allocateAndWriteImageSamplerDescriptorSets(pLogicalDevice.get(), descriptorPool, pState->imageSamplerDescriptorSetLayout, pState->sampler, imageViewsVector);
+
+        edgeFramebuffers     = createFramebuffers(pLogicalDevice.get(), pState->edgeRenderPass,  imageExtent,   edgeImageViews);
+        blendFramebuffers    = createFramebuffers(pLogicalDevice.get(), pState->unormRenderPass, imageExtent,  blendImageViews);
+        neignborFramebuffers = createFramebuffers(pLogicalDevice.get(), pState->renderPass,      imageExtent, outputImageViews);
+    }
+    void SmaaEffect::buildState()
     {
         std::string smaaEdgeVertexFile        = "smaa_edge.vert.spv";
         std::string smaaEdgeLumaFragmentFile  = "smaa_edge_luma.frag.spv";
@@ -47,105 +196,49 @@ namespace vkBasalt
         std::string smaaBlendFragmentFile     = "smaa_blend.frag.spv";
         std::string smaaNeighborVertexFile    = "smaa_neighbor.vert.spv";
         std::string smaaNeighborFragmentFile  = "smaa_neighbor.frag.spv";
-        std::cout << "in creating SmaaEffect " << std::endl;
+        Logger::debug("in building smaa effect state ");
 
-        this->physicalDevice = physicalDevice;
-        this->instanceDispatchTable = instanceDispatchTable;
-        this->device = device;
-        this->dispatchTable = dispatchTable;
-        this->format = format;
-        this->imageExtent = imageExtent;
-        this->inputImages = inputImages;
-        this->outputImages = outputImages;
-        this->pConfig = pConfig;
+        ResourceScope resourceScope(pState->resourceOwner);
 
-        //create Images for the first and second pass at once -> less memory fragmentation
-        std::vector<VkImage> edgeAndBlendImages= createImages(instanceDispatchTable,
-                                                               device,
-                                                               dispatchTable,
-                                                               physicalDevice,
-                                                               inputImages.size()*2,
-                                                               {imageExtent.width, imageExtent.height, 1},
-                                                               VK_FORMAT_B8G8R8A8_UNORM,//TODO search for format and save it
-                                                               VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-                                                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                                               imageMemory);
-
-        edgeImages  = std::vector<VkImage>(edgeAndBlendImages.begin(), edgeAndBlendImages.begin() + edgeAndBlendImages.size()/2);
-        blendImages = std::vector<VkImage>(edgeAndBlendImages.begin() + edgeAndBlendImages.size()/2, edgeAndBlendImages.end());
-
-        inputImageViews = createImageViews(device, dispatchTable, format, inputImages);
-        std::cout << "after creating input ImageViews" << std::endl;
-        edgeImageViews = createImageViews(device, dispatchTable, VK_FORMAT_B8G8R8A8_UNORM, edgeImages);
-        std::cout << "after creating edge  ImageViews" << std::endl;
-        blendImageViews = createImageViews(device, dispatchTable, VK_FORMAT_B8G8R8A8_UNORM, blendImages);
-        std::cout << "after creating blend ImageViews" << std::endl;
-        outputImageViews = createImageViews(device, dispatchTable, format, outputImages);
-        std::cout << "after creating output ImageViews" << std::endl;
-        sampler = createSampler(device, dispatchTable);
-        std::cout << "after creating sampler" << std::endl;
+        pState->sampler = createSampler(pLogicalDevice.get());
+        Logger::debug("after creating sampler");
 
         VkExtent3D areaImageExtent = {AREATEX_WIDTH, AREATEX_HEIGHT, 1};
-        areaImage = createImages(instanceDispatchTable,
-                                 device,
-                                 dispatchTable,
-                                 physicalDevice,
-                                 1,
-                                 areaImageExtent,
-                                 VK_FORMAT_R8G8_UNORM,//TODO search for format and save it
-                                 VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                 areaMemory)[0];
+        pState->areaImage = createImages(pLogicalDevice.get(),
+                                         1,
+                                         areaImageExtent,
+                                         VK_FORMAT_R8G8_UNORM,//TODO search for format and save it
+                                         VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                         pState->areaMemory)[0];
         VkExtent3D searchImageExtent = {SEARCHTEX_WIDTH, SEARCHTEX_HEIGHT, 1};
-        searchImage = createImages(instanceDispatchTable,
-                                   device,
-                                   dispatchTable,
-                                   physicalDevice,
-                                   1,
-                                   searchImageExtent,
-                                   VK_FORMAT_R8_UNORM,//TODO search for format and save it
-                                   VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                   searchMemory)[0];
-
-        uploadToImage(instanceDispatchTable,
-                       device,
-                       dispatchTable,
-                       physicalDevice,
-                       areaImage,
+        pState->searchImage = createImages(pLogicalDevice.get(),
+                                           1,
+                                           searchImageExtent,
+                                           VK_FORMAT_R8_UNORM,//TODO search for format and save it
+                                           VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                           pState->searchMemory)[0];
+
+        uploadToImage(pLogicalDevice.get(),
+                       pState->areaImage,
                        areaImageExtent,
                        AREATEX_SIZE,
-                       queue,
-                       commandPool,
                        areaTexBytes);
 
-        uploadToImage(instanceDispatchTable,
-                       device,
-                       dispatchTable,
-                       physicalDevice,
-                       searchImage,
+        uploadToImage(pLogicalDevice.get(),
+                       pState->searchImage,
                        searchImageExtent,
                        SEARCHTEX_SIZE,
-                       queue,
-                       commandPool,
                        searchTexBytes);
 
-        areaImageView = createImageViews(device, dispatchTable, VK_FORMAT_R8G8_UNORM, std::vector<VkImage>(1,areaImage))[0];
-        std::cout << "after creating area ImageView" << std::endl;
-        searchImageView = createImageViews(device, dispatchTable, VK_FORMAT_R8_UNORM, std::vector<VkImage>(1,searchImage))[0];
-        std::cout << "after creating search ImageView" << std::endl;
+        pState->areaImageView = createImageViews(pLogicalDevice.get(), VK_FORMAT_R8G8_UNORM, std::vector<VkImage>(1,pState->areaImage))[0];
+        Logger::debug("after creating area ImageView");
+        pState->searchImageView = createImageViews(pLogicalDevice.get(), VK_FORMAT_R8_UNORM, std::vector<VkImage>(1,pState->searchImage))[0];
+        Logger::debug("after creating search ImageView");
 
-        imageSamplerDescriptorSetLayout = createImageSamplerDescriptorSetLayout(device, dispatchTable, 5);
-        std::cout << "after creating descriptorSetLayouts" << std::endl;
-
-        VkDescriptorPoolSize imagePoolSize;
-        imagePoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        imagePoolSize.descriptorCount = inputImages.size()*5;
-
-        std::vector<VkDescriptorPoolSize> poolSizes = {imagePoolSize};
-
-        descriptorPool = createDescriptorPool(device, dispatchTable, poolSizes);
-        std::cout << "after creating descriptorPool" << std::endl;
+        pState->imageSamplerDescriptorSetLayout = createImageSamplerDescriptorSetLayout(pLogicalDevice.get(), 5);
+        Logger::debug("after creating descriptorSetLayouts");
 
         //get config options
         SmaaOptions smaaOptions;
@@ -154,38 +247,36 @@ namespace vkBasalt
         smaaOptions.maxSearchStepsDiag  = std::stoi(pConfig->getOption("smaaMaxSearchStepsDiag", "16"));
         smaaOptions.cornerRounding      = std::stoi(pConfig->getOption("smaaCornerRounding", "25"));
 
-        auto shaderCode = readFile(smaaEdgeVertexFile);
-        createShaderModule(device, dispatchTable, shaderCode, &edgeVertexModule);
+        auto shaderCode = getShaderCode(smaaEdgeVertexFile);
+        createShaderModule(pLogicalDevice.get(), shaderCode, &pState->edgeVertexModule);
         shaderCode = pConfig->getOption("smaaEdgeDetection", "luma") == "color"
-            ? readFile(smaaEdgeColorFragmentFile)
-            : readFile(smaaEdgeLumaFragmentFile);
-        createShaderModule(device, dispatchTable, shaderCode, &edgeFragmentModule);
-        shaderCode = readFile(smaaBlendVertexFile);
-        createShaderModule(device, dispatchTable, shaderCode, &blendVertexModule);
-        shaderCode = readFile(smaaBlendFragmentFile);
-        createShaderModule(device, dispatchTable, shaderCode, &blendFragmentModule);
-        shaderCode = readFile(smaaNeighborVertexFile);
-        createShaderModule(device, dispatchTable, shaderCode, &neighborVertexModule);
-        shaderCode = readFile(smaaNeighborFragmentFile);
-        createShaderModule(device, dispatchTable, shaderCode, &neignborFragmentModule);
-
-        renderPass      = createRenderPass(device, dispatchTable, format);
-        unormRenderPass = createRenderPass(device, dispatchTable, VK_FORMAT_B8G8R8A8_UNORM);
-
-        std::vector<VkDescriptorSetLayout> descriptorSetLayouts = {imageSamplerDescriptorSetLayout};
-        pipelineLayout = createGraphicsPipelineLayout(device, dispatchTable, descriptorSetLayouts);
-
-        std::vector<VkSpecializationMapEntry> specMapEntrys(8);
+            ? getShaderCode(smaaEdgeColorFragmentFile)
+            : getShaderCode(smaaEdgeLumaFragmentFile);
+        createShaderModule(pLogicalDevice.get(), shaderCode, &pState->edgeFragmentModule);
+        shaderCode = getShaderCode(smaaBlendVertexFile);
+        createShaderModule(pLogicalDevice.get(), shaderCode, &pState->blendVertexModule);
+        shaderCode = getShaderCode(smaaBlendFragmentFile);
+        createShaderModule(pLogicalDevice.get(), shaderCode, &pState->blendFragmentModule);
+        shaderCode = getShaderCode(smaaNeighborVertexFile);
+        createShaderModule(pLogicalDevice.get(), shaderCode, &pState->neighborVertexModule);
+        shaderCode = getShaderCode(smaaNeighborFragmentFile);
+        createShaderModule(pLogicalDevice.get(), shaderCode, &pState->neignborFragmentModule);
+
+        //the render passes only depend on the formats, so they are the same for every swapchain
+        pState->renderPass      = createRenderPass(pLogicalDevice.get(), format);
+        pState->edgeRenderPass  = createRenderPass(pLogicalDevice.get(), pState->edgeFormat);
+        pState->unormRenderPass = createRenderPass(pLogicalDevice.get(), pState->blendFormat);
+
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts = {pState->imageSamplerDescriptorSetLayout};
+        pState->pipelineLayout = createGraphicsPipelineLayout(pLogicalDevice.get(), descriptorSetLayouts);
+
+        std::vector<VkSpecializationMapEntry> specMapEntrys(4);
         for(uint32_t i=0;i<specMapEntrys.size();i++)
         {
-            specMapEntrys[i].constantID = i;
+            specMapEntrys[i].constantID = i + 4;
             specMapEntrys[i].offset = sizeof(float) * i;//TODO not clean to assume that sizeof(int32_t) == sizeof(float)
             specMapEntrys[i].size = sizeof(float);
         }
-        smaaOptions.screenWidth = (float) imageExtent.width,
-        smaaOptions.screenHeight = (float) imageExtent.height,
-        smaaOptions.reverseScreenWidth = 1.0f/imageExtent.width;
-        smaaOptions.reverseScreenHeight = 1.0f/imageExtent.height;
 
         VkSpecializationInfo specializationInfo;
         specializationInfo.mapEntryCount = specMapEntrys.size();
@@ -193,25 +284,13 @@ namespace vkBasalt
         specializationInfo.dataSize = sizeof(smaaOptions);
         specializationInfo.pData = &smaaOptions;
 
-        edgePipeline     = createGraphicsPipeline(device, dispatchTable, edgeVertexModule, &specializationInfo, edgeFragmentModule, &specializationInfo, imageExtent, unormRenderPass, pipelineLayout);
-        blendPipeline    = createGraphicsPipeline(device, dispatchTable, blendVertexModule, &specializationInfo, blendFragmentModule, &specializationInfo, imageExtent, unormRenderPass, pipelineLayout);
-        neighborPipeline = createGraphicsPipeline(device, dispatchTable, neighborVertexModule, &specializationInfo, neignborFragmentModule, &specializationInfo, imageExtent, renderPass, pipelineLayout);
-
-
-        std::vector<std::vector<VkImageView>> imageViewsVector = {inputImageViews,
-                                                                  edgeImageViews,
-                                                                  std::vector<VkImageView>(inputImageViews.size(), areaImageView),
-                                                                  std::vector<VkImageView>(inputImageViews.size(), searchImageView),
-                                                                  blendImageViews};
-        imageDescriptorSets = allocateAndWriteImageSamplerDescriptorSets(device, dispatchTable, descriptorPool, imageSamplerDescriptorSetLayout, sampler, imageViewsVector);
-
-        edgeFramebuffers     = createFramebuffers(device, dispatchTable, unormRenderPass, imageExtent,   edgeImageViews);
-        blendFramebuffers    = createFramebuffers(device, dispatchTable, unormRenderPass, imageExtent,  blendImageViews);
-        neignborFramebuffers = createFramebuffers(device, dispatchTable, renderPass,      imageExtent, outputImageViews);
+        pState->edgePipeline     = createGraphicsPipeline(pLogicalDevice.get(), pState->edgeVertexModule, &specializationInfo, pState->edgeFragmentModule, &specializationInfo, pState->edgeRenderPass, pState->pipelineLayout);
+        pState->blendPipeline    = createGraphicsPipeline(pLogicalDevice.get(), pState->blendVertexModule, &specializationInfo, pState->blendFragmentModule, &specializationInfo, pState->unormRenderPass, pState->pipelineLayout);
+        pState->neighborPipeline = createGraphicsPipeline(pLogicalDevice.get(), pState->neighborVertexModule, &specializationInfo, pState->neignborFragmentModule, &specializationInfo, pState->renderPass, pState->pipelineLayout);
     }
     void SmaaEffect::applyEffect(uint32_t imageIndex, VkCommandBuffer commandBuffer)
     {
-        std::cout << "applying smaa effect" << commandBuffer << std::endl;
+        Logger::trace("applying smaa effect", commandBuffer);
         //Used to make the Image accessable by the shader
         VkImageMemoryBarrier memoryBarrier;
         memoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -246,120 +325,116 @@ namespace vkBasalt
         secondBarrier.subresourceRange.baseArrayLayer = 0;
         secondBarrier.subresourceRange.layerCount = 1;
 
-        dispatchTable.CmdPipelineBarrier(commandBuffer,VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,0,0, nullptr,0, nullptr,1, &memoryBarrier);
-        std::cout << "after the first pipeline barrier" << std::endl;
+        pLogicalDevice->dispatchTable.CmdPipelineBarrier(commandBuffer,VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,0,0, nullptr,0, nullptr,1, &memoryBarrier);
+        Logger::trace("after the first pipeline barrier");
+
+        //the edge and blend images may still be read by the effect that used the memory before
+        recordTransientBarrier(pLogicalDevice.get(), commandBuffer);
+        uint32_t slot = imageIndex % slotCount;
 
         VkRenderPassBeginInfo renderPassBeginInfo;
         renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassBeginInfo.pNext = nullptr;
-        renderPassBeginInfo.renderPass = unormRenderPass;
-        renderPassBeginInfo.framebuffer = edgeFramebuffers[imageIndex];
+        renderPassBeginInfo.renderPass = pState->edgeRenderPass;
+        renderPassBeginInfo.framebuffer = edgeFramebuffers[slot];
         renderPassBeginInfo.renderArea.offset = {0,0};
         renderPassBeginInfo.renderArea.extent = imageExtent;
         VkClearValue clearValue = {0.0f, 0.0f, 0.0f, 1.0f};
         renderPassBeginInfo.clearValueCount = 1;
         renderPassBeginInfo.pClearValues = &clearValue;
         //edge renderPass
-        std::cout << "before beginn edge renderpass" << std::endl;
-        dispatchTable.CmdBeginRenderPass(commandBuffer,&renderPassBeginInfo,VK_SUBPASS_CONTENTS_INLINE);
-        std::cout << "after beginn renderpass" << std::endl;
+        Logger::trace("before beginn edge renderpass");
+        pLogicalDevice->dispatchTable.CmdBeginRenderPass(commandBuffer,&renderPassBeginInfo,VK_SUBPASS_CONTENTS_INLINE);
+        Logger::trace("after beginn renderpass");
+
+        pLogicalDevice->dispatchTable.CmdBindDescriptorSets(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,pState->pipelineLayout,0,1,&(imageDescriptorSets[imageIndex]),0,nullptr);
+        Logger::trace("after binding image sampler");
 
-        dispatchTable.CmdBindDescriptorSets(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,pipelineLayout,0,1,&(imageDescriptorSets[imageIndex]),0,nullptr);
-        std::cout << "after binding image sampler" << std::endl;
+        //all passes share the pipeline layout, so the dynamic state and push constants stay valid for the later passes
+        recordScreenExtent(pLogicalDevice.get(), commandBuffer, pState->pipelineLayout, imageExtent);
 
-        dispatchTable.CmdBindPipeline(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,edgePipeline);
-        std::cout << "after bind pipeliene" << std::endl;
+        pLogicalDevice->dispatchTable.CmdBindPipeline(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,pState->edgePipeline);
+        Logger::trace("after bind pipeliene");
 
-        dispatchTable.CmdDraw(commandBuffer, 3, 1, 0, 0);
-        std::cout << "after draw" << std::endl;
+        pLogicalDevice->dispatchTable.CmdDraw(commandBuffer, 3, 1, 0, 0);
+        Logger::trace("after draw");
 
-        dispatchTable.CmdEndRenderPass(commandBuffer);
-        std::cout << "after end renderpass" << std::endl;
+        pLogicalDevice->dispatchTable.CmdEndRenderPass(commandBuffer);
+        Logger::trace("after end renderpass");
 
-        memoryBarrier.image = edgeImages[imageIndex];
-        renderPassBeginInfo.framebuffer = blendFramebuffers[imageIndex];
+        memoryBarrier.image = edgeImages[slot];
+        renderPassBeginInfo.renderPass = pState->unormRenderPass;
+        renderPassBeginInfo.framebuffer = blendFramebuffers[slot];
         //blend renderPass
-        dispatchTable.CmdPipelineBarrier(commandBuffer,VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,0,0, nullptr,0, nullptr,1, &memoryBarrier);
-        std::cout << "after the first pipeline barrier" << std::endl;
+        pLogicalDevice->dispatchTable.CmdPipelineBarrier(commandBuffer,VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,0,0, nullptr,0, nullptr,1, &memoryBarrier);
+        Logger::trace("after the first pipeline barrier");
 
-        std::cout << "before beginn blend renderpass" << std::endl;
-        dispatchTable.CmdBeginRenderPass(commandBuffer,&renderPassBeginInfo,VK_SUBPASS_CONTENTS_INLINE);
-        std::cout << "after beginn renderpass" << std::endl;
+        Logger::trace("before beginn blend renderpass");
+        pLogicalDevice->dispatchTable.CmdBeginRenderPass(commandBuffer,&renderPassBeginInfo,VK_SUBPASS_CONTENTS_INLINE);
+        Logger::trace("after beginn renderpass");
 
-        dispatchTable.CmdBindPipeline(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,blendPipeline);
-        std::cout << "after bind pipeliene" << std::endl;
+        pLogicalDevice->dispatchTable.CmdBindPipeline(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,pState->blendPipeline);
+        Logger::trace("after bind pipeliene");
 
-        dispatchTable.CmdDraw(commandBuffer, 3, 1, 0, 0);
-        std::cout << "after draw" << std::endl;
+        pLogicalDevice->dispatchTable.CmdDraw(commandBuffer, 3, 1, 0, 0);
+        Logger::trace("after draw");
 
-        dispatchTable.CmdEndRenderPass(commandBuffer);
-        std::cout << "after end renderpass" << std::endl;
+        pLogicalDevice->dispatchTable.CmdEndRenderPass(commandBuffer);
+        Logger::trace("after end renderpass");
 
-        memoryBarrier.image = blendImages[imageIndex];
+        memoryBarrier.image = blendImages[slot];
         renderPassBeginInfo.framebuffer = neignborFramebuffers[imageIndex];
-        renderPassBeginInfo.renderPass = renderPass;
+        renderPassBeginInfo.renderPass = pState->renderPass;
         //neighbor renderPass
-        dispatchTable.CmdPipelineBarrier(commandBuffer,VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,0,0, nullptr,0, nullptr,1, &memoryBarrier);
-        std::cout << "after the first pipeline barrier" << std::endl;
+        pLogicalDevice->dispatchTable.CmdPipelineBarrier(commandBuffer,VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,0,0, nullptr,0, nullptr,1, &memoryBarrier);
+        Logger::trace("after the first pipeline barrier");
 
-        std::cout << "before beginn neighbor renderpass" << std::endl;
-        dispatchTable.CmdBeginRenderPass(commandBuffer,&renderPassBeginInfo,VK_SUBPASS_CONTENTS_INLINE);
-        std::cout << "after beginn renderpass" << std::endl;
+        Logger::trace("before beginn neighbor renderpass");
+        pLogicalDevice->dispatchTable.CmdBeginRenderPass(commandBuffer,&renderPassBeginInfo,VK_SUBPASS_CONTENTS_INLINE);
+        Logger::trace("after beginn renderpass");
 
-        dispatchTable.CmdBindPipeline(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,neighborPipeline);
-        std::cout << "after bind pipeliene" << std::endl;
+        pLogicalDevice->dispatchTable.CmdBindPipeline(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,pState->neighborPipeline);
+        Logger::trace("after bind pipeliene");
 
-        dispatchTable.CmdDraw(commandBuffer, 3, 1, 0, 0);
-        std::cout << "after draw" << std::endl;
+        pLogicalDevice->dispatchTable.CmdDraw(commandBuffer, 3, 1, 0, 0);
+        Logger::trace("after draw");
 
-        dispatchTable.CmdEndRenderPass(commandBuffer);
-        std::cout << "after end renderpass" << std::endl;
+        pLogicalDevice->dispatchTable.CmdEndRenderPass(commandBuffer);
+        Logger::trace("after end renderpass");
 
-        dispatchTable.CmdPipelineBarrier(commandBuffer,VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,0,0, nullptr,0, nullptr,1, &secondBarrier);
-        std::cout << "after the second pipeline barrier" << std::endl;
+        pLogicalDevice->dispatchTable.CmdPipelineBarrier(commandBuffer,VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,0,0, nullptr,0, nullptr,1, &secondBarrier);
+        Logger::trace("after the second pipeline barrier");
 
     }
+    std::shared_ptr<EffectState> SmaaEffect::getState()
+    {
+        return pState;
+    }
     SmaaEffect::~SmaaEffect()
     {
-        std::cout << "destroying smaa effect " << this << std::endl;
-        dispatchTable.DestroyPipeline(device, edgePipeline,     nullptr);
-        dispatchTable.DestroyPipeline(device, blendPipeline,    nullptr);
-        dispatchTable.DestroyPipeline(device, neighborPipeline, nullptr);
-
-        dispatchTable.DestroyPipelineLayout(device,pipelineLayout,nullptr);
-        dispatchTable.DestroyRenderPass(device,renderPass,nullptr);
-        dispatchTable.DestroyRenderPass(device,unormRenderPass,nullptr);
-        dispatchTable.DestroyDescriptorSetLayout(device,imageSamplerDescriptorSetLayout,nullptr);
-
-        dispatchTable.DestroyShaderModule(device, edgeVertexModule,       nullptr);
-        dispatchTable.DestroyShaderModule(device, edgeFragmentModule,     nullptr);
-        dispatchTable.DestroyShaderModule(device, blendVertexModule,      nullptr);
-        dispatchTable.DestroyShaderModule(device, blendFragmentModule,    nullptr);
-        dispatchTable.DestroyShaderModule(device, neighborVertexModule,   nullptr);
-        dispatchTable.DestroyShaderModule(device, neignborFragmentModule, nullptr);
-
-        dispatchTable.DestroyDescriptorPool(device,descriptorPool,nullptr);
-        dispatchTable.FreeMemory(device,imageMemory,nullptr);
-        dispatchTable.FreeMemory(device,areaMemory,nullptr);
-        dispatchTable.FreeMemory(device,searchMemory,nullptr);
+        Logger::debug("destroying smaa effect ", this);
+        pLogicalDevice->dispatchTable.DestroyDescriptorPool(pLogicalDevice->device,descriptorPool,nullptr);
+        pLogicalDevice->resourceTracker.remove(ResourceType::DescriptorPool, descriptorPool);
+        for(unsigned int i=0;i<neignborFramebuffers.size();i++)
+        {
+            pLogicalDevice->dispatchTable.DestroyFramebuffer(pLogicalDevice->device,neignborFramebuffers[i],nullptr);
+            pLogicalDevice->dispatchTable.DestroyImageView(pLogicalDevice->device,inputImageViews[i],nullptr);
+            pLogicalDevice->dispatchTable.DestroyImageView(pLogicalDevice->device,outputImageViews[i],nullptr);
+            Logger::debug("after DestroyImageView");
+        }
+        pLogicalDevice->resourceTracker.remove(ResourceType::Framebuffer, neignborFramebuffers);
+        pLogicalDevice->resourceTracker.remove(ResourceType::ImageView, inputImageViews);
+        pLogicalDevice->resourceTracker.remove(ResourceType::ImageView, outputImageViews);
         for(unsigned int i=0;i<edgeFramebuffers.size();i++)
         {
-            dispatchTable.DestroyFramebuffer(device,edgeFramebuffers[i],nullptr);
-            dispatchTable.DestroyFramebuffer(device,blendFramebuffers[i],nullptr);
-            dispatchTable.DestroyFramebuffer(device,neignborFramebuffers[i],nullptr);
-            dispatchTable.DestroyImageView(device,inputImageViews[i],nullptr);
-            dispatchTable.DestroyImageView(device,edgeImageViews[i],nullptr);
-            dispatchTable.DestroyImageView(device,blendImageViews[i],nullptr);
-            dispatchTable.DestroyImageView(device,outputImageViews[i],nullptr);
-            dispatchTable.DestroyImage(device,edgeImages[i],nullptr);
-            dispatchTable.DestroyImage(device,blendImages[i],nullptr);
-            std::cout << "after DestroyImageView" << std::endl;
+            pLogicalDevice->dispatchTable.DestroyFramebuffer(pLogicalDevice->device,edgeFramebuffers[i],nullptr);
+            pLogicalDevice->dispatchTable.DestroyFramebuffer(pLogicalDevice->device,blendFramebuffers[i],nullptr);
+            pLogicalDevice->dispatchTable.DestroyImageView(pLogicalDevice->device,edgeImageViews[i],nullptr);
+            pLogicalDevice->dispatchTable.DestroyImageView(pLogicalDevice->device,blendImageViews[i],nullptr);
         }
-        dispatchTable.DestroyImageView(device,areaImageView,nullptr);
-        dispatchTable.DestroyImage(device,areaImage,nullptr);
-        dispatchTable.DestroyImageView(device,searchImageView,nullptr);
-        dispatchTable.DestroyImage(device,searchImage,nullptr);
-
-        dispatchTable.DestroySampler(device,sampler,nullptr);
+        pLogicalDevice->resourceTracker.remove(ResourceType::Framebuffer, edgeFramebuffers);
+        pLogicalDevice->resourceTracker.remove(ResourceType::Framebuffer, blendFramebuffers);
+        pLogicalDevice->resourceTracker.remove(ResourceType::ImageView, edgeImageViews);
+        pLogicalDevice->resourceTracker.remove(ResourceType::ImageView, blendImageViews);
     }
 }
@@ -13,38 +13,27 @@
 #include "vulkan/vk_layer_dispatch_table.h"
 
 #include "effect.hpp"
+#include "logical_device.hpp"
 #include "config.hpp"
+#include "scratch_image.hpp"
 
 namespace vkBasalt{
-    class SmaaEffect : public Effect
+    class SmaaEffectState : public EffectState
     {
     public:
-        SmaaEffect(VkPhysicalDevice physicalDevice, VkLayerInstanceDispatchTable instanceDispatchTable, VkDevice device, VkLayerDispatchTable dispatchTable, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig, VkQueue queue, VkCommandPool commandPool);
-        void applyEffect(uint32_t imageIndex, VkCommandBuffer commandBuffer) override; 
-        ~SmaaEffect();
-    private:
-        VkPhysicalDevice physicalDevice;
-        VkLayerInstanceDispatchTable instanceDispatchTable;
-        VkDevice device;
-        VkLayerDispatchTable dispatchTable;
-        std::vector<VkImage> inputImages;
-        std::vector<VkImage> edgeImages;
-        std::vector<VkImage> blendImages;
-        std::vector<VkImage> outputImages;
-        std::vector<VkImageView> inputImageViews;
-        std::vector<VkImageView> edgeImageViews;
-        std::vector<VkImageView> blendImageViews;
-        std::vector<VkImageView> outputImageViews;
-        std::vector<VkDescriptorSet> imageDescriptorSets;
-        std::vector<VkFramebuffer> edgeFramebuffers;
-        std::vector<VkFramebuffer> blendFramebuffers;
-        std::vector<VkFramebuffer> neignborFramebuffers;
+        SmaaEffectState(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format, std::shared_ptr<vkBasalt::Config> pConfig, const std::string& name);
+        ~SmaaEffectState();
+        bool isBuilt();
+
+        VkFormat edgeFormat;
+        VkFormat blendFormat;
         VkImage areaImage;
         VkImage searchImage;
+        MemoryAllocation areaMemory;
+        MemoryAllocation searchMemory;
         VkImageView areaImageView;
         VkImageView searchImageView;
         VkDescriptorSetLayout imageSamplerDescriptorSetLayout;
-        VkDescriptorPool descriptorPool;
         VkShaderModule edgeVertexModule;
         VkShaderModule edgeFragmentModule;
         VkShaderModule blendVertexModule;
@@ -52,18 +41,46 @@ namespace vkBasalt{
         VkShaderModule neighborVertexModule;
         VkShaderModule neignborFragmentModule;
         VkRenderPass renderPass;
+        VkRenderPass edgeRenderPass;
         VkRenderPass unormRenderPass;
         VkPipelineLayout pipelineLayout;
         VkPipeline edgePipeline;
         VkPipeline blendPipeline;
         VkPipeline neighborPipeline;
+        VkSampler sampler;
+    };
+
+    class SmaaEffect : public Effect
+    {
+    public:
+        SmaaEffect(std::shared_ptr<LogicalDevice> pLogicalDevice, VkFormat format,  VkExtent2D imageExtent, std::vector<VkImage> inputImages, std::vector<VkImage> outputImages, std::shared_ptr<vkBasalt::Config> pConfig, std::shared_ptr<EffectState> pOldState);
+        void applyEffect(uint32_t imageIndex, VkCommandBuffer commandBuffer) override; 
+        std::shared_ptr<EffectState> getState() override;
+        ~SmaaEffect();
+    private:
+        std::shared_ptr<LogicalDevice> pLogicalDevice;
+        std::shared_ptr<SmaaEffectState> pState;
+        std::vector<VkImage> inputImages;
+        std::vector<VkImage> edgeImages;
+        std::vector<VkImage> blendImages;
+        std::vector<VkImage> outputImages;
+        std::vector<VkImageView> inputImageViews;
+        std::vector<VkImageView> edgeImageViews;
+        std::vector<VkImageView> blendImageViews;
+        std::vector<VkImageView> outputImageViews;
+        std::vector<VkDescriptorSet> imageDescriptorSets;
+        std::vector<VkFramebuffer> edgeFramebuffers;
+        std::vector<VkFramebuffer> blendFramebuffers;
+        std::vector<VkFramebuffer> neignborFramebuffers;
+        VkDescriptorPool descriptorPool;
         VkExtent2D imageExtent;
         VkFormat format;
-        VkDeviceMemory imageMemory;
-        VkDeviceMemory areaMemory;
-        VkDeviceMemory searchMemory;
-        VkSampler sampler;
+        std::unique_ptr<ScratchImage> pScratchImage;//the edge and blend images, one of each per slot
+        uint32_t slotCount;
         std::shared_ptr<vkBasalt::Config> pConfig;
+
+        //creates the objects of pState
+        void buildState();
     };
 }
 
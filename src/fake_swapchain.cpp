@@ -1,5 +1,8 @@
 #include "fake_swapchain.hpp"
 #include "memory.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
 
 #ifndef ASSERT_VULKAN
 #define ASSERT_VULKAN(val)\
@@ -11,7 +14,7 @@
 
 namespace vkBasalt
 {
-    std::vector<VkImage> createFakeSwapchainImages(VkLayerInstanceDispatchTable instanceDispatchTable, VkPhysicalDevice physicalDevice, VkDevice device, VkLayerDispatchTable dispatchTable, VkSwapchainCreateInfoKHR swapchainCreateInfo, uint32_t count, VkDeviceMemory& deviceMemory)
+    std::vector<VkImage> createFakeSwapchainImages(LogicalDevice* pLogicalDevice, VkSwapchainCreateInfoKHR swapchainCreateInfo, uint32_t count, std::vector<MemoryAllocation>& deviceMemory)
     {
         std::vector<VkImage> fakeImages(count);
         VkImageCreateInfo imageCreateInfo;
@@ -27,7 +30,7 @@ namespace vkBasalt
         imageCreateInfo.arrayLayers = swapchainCreateInfo.imageArrayLayers;
         imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
         imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-        imageCreateInfo.usage = swapchainCreateInfo.imageUsage | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT ;//TODO what usage do we need?
+        imageCreateInfo.usage = swapchainCreateInfo.imageUsage | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;//TRANSFER_SRC for the copy while the effects are toggled off
         imageCreateInfo.sharingMode = swapchainCreateInfo.imageSharingMode;
         imageCreateInfo.queueFamilyIndexCount = swapchainCreateInfo.queueFamilyIndexCount;
         imageCreateInfo.pQueueFamilyIndices = swapchainCreateInfo.pQueueFamilyIndices;
@@ -36,35 +39,51 @@ namespace vkBasalt
         VkResult result;
         for(uint32_t i=0;i<count;i++)
         {
-            result = dispatchTable.CreateImage(device, &imageCreateInfo, nullptr, &(fakeImages[i]));
+            result = pLogicalDevice->dispatchTable.CreateImage(pLogicalDevice->device, &imageCreateInfo, nullptr, &(fakeImages[i]));
             ASSERT_VULKAN(result);
         }
         
-        //Allocate a bunch of memory for all images at one
-        VkMemoryRequirements memoryRequirements;
-        dispatchTable.GetImageMemoryRequirements(device, fakeImages[0], &memoryRequirements);
-        
-        std::cout << "fake image size: " << memoryRequirements.size << std::endl;
-        std::cout << "fake image alignment: " << memoryRequirements.alignment << std::endl;
-        
-        if(memoryRequirements.size%memoryRequirements.alignment!=0)
+        //images the driver wants a dedicated allocation for get one, the rest share one allocation,
+        //each at an offset that fits its own size and alignment
+        std::vector<VkImage> packedImages;
+        std::vector<VkDeviceSize> offsets;
+        VkMemoryRequirements packedRequirements;
+        packedRequirements.size = 0;
+        packedRequirements.alignment = 1;
+        packedRequirements.memoryTypeBits = ~0u;
+        deviceMemory.clear();
+        for(uint32_t i=0;i<count;i++)
         {
-            memoryRequirements.size = (memoryRequirements.size/memoryRequirements.alignment+1)*memoryRequirements.alignment;
+            VkMemoryRequirements memoryRequirements;
+            bool dedicated;
+            getImageMemoryRequirements(pLogicalDevice, fakeImages[i], memoryRequirements, dedicated);
+            Logger::debug("fake image size: ", memoryRequirements.size, ", alignment: ", memoryRequirements.alignment, (dedicated ? ", dedicated" : ""));
+
+            if(dedicated)
+            {
+                deviceMemory.push_back(pLogicalDevice->memoryAllocator.allocateDedicated(memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, fakeImages[i]));
+                result = pLogicalDevice->dispatchTable.BindImageMemory(pLogicalDevice->device, fakeImages[i], deviceMemory.back().memory, deviceMemory.back().offset);
+                ASSERT_VULKAN(result);
+                pLogicalDevice->resourceTracker.add(ResourceType::Image, fakeImages[i], memoryRequirements.size);
+                continue;
+            }
+            VkDeviceSize offset = (packedRequirements.size + memoryRequirements.alignment - 1) / memoryRequirements.alignment * memoryRequirements.alignment;
+            packedImages.push_back(fakeImages[i]);
+            offsets.push_back(offset);
+            packedRequirements.size = offset + memoryRequirements.size;
+            packedRequirements.alignment = std::max(packedRequirements.alignment, memoryRequirements.alignment);
+            packedRequirements.memoryTypeBits &= memoryRequirements.memoryTypeBits;
+            pLogicalDevice->resourceTracker.add(ResourceType::Image, fakeImages[i], memoryRequirements.size);
         }
-        
-        
-        VkMemoryAllocateInfo memoryAllocateInfo;
-        memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        memoryAllocateInfo.pNext = nullptr;
-        memoryAllocateInfo.allocationSize = memoryRequirements.size * count;
-        memoryAllocateInfo.memoryTypeIndex = findMemoryTypeIndex(instanceDispatchTable,physicalDevice,memoryRequirements.memoryTypeBits,VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        
-        result = dispatchTable.AllocateMemory(device, &memoryAllocateInfo, nullptr, &deviceMemory);
-        ASSERT_VULKAN(result);
-        
-        for(uint32_t i=0;i<count;i++)
+        if(packedImages.empty())
+        {
+            return fakeImages;
+        }
+
+        deviceMemory.push_back(pLogicalDevice->memoryAllocator.allocate(packedRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false));
+        for(uint32_t i=0;i<packedImages.size();i++)
         {
-            result = dispatchTable.BindImageMemory(device, fakeImages[i], deviceMemory, memoryRequirements.size*i);
+            result = pLogicalDevice->dispatchTable.BindImageMemory(pLogicalDevice->device, packedImages[i], deviceMemory.back().memory, deviceMemory.back().offset + offsets[i]);
             ASSERT_VULKAN(result);
         }
         return fakeImages;
@@ -10,8 +10,11 @@
 #include "vulkan/vk_layer.h"
 #include "vulkan/vk_layer_dispatch_table.h"
 
+#include "logical_device.hpp"
+
 namespace vkBasalt{
-    std::vector<VkImage> createFakeSwapchainImages(VkLayerInstanceDispatchTable instanceDispatchTable, VkPhysicalDevice physicalDevice, VkDevice device, VkLayerDispatchTable dispatchTable, VkSwapchainCreateInfoKHR swapchainCreateInfo, uint32_t count, VkDeviceMemory& deviceMemory);
+    //deviceMemory gets one allocation for the packed images and one for each image the driver wants a dedicated allocation for
+    std::vector<VkImage> createFakeSwapchainImages(LogicalDevice* pLogicalDevice, VkSwapchainCreateInfoKHR swapchainCreateInfo, uint32_t count, std::vector<MemoryAllocation>& deviceMemory);
 }
 
 
@@ -10,7 +10,7 @@
 
 namespace vkBasalt
 {
-    std::vector<VkFramebuffer> createFramebuffers(VkDevice device, VkLayerDispatchTable dispatchTable, VkRenderPass renderPass, VkExtent2D& extent, std::vector<VkImageView> imageViews)
+    std::vector<VkFramebuffer> createFramebuffers(LogicalDevice* pLogicalDevice, VkRenderPass renderPass, VkExtent2D& extent, std::vector<VkImageView> imageViews)
     {
         std::vector<VkFramebuffer> framebuffers(imageViews.size());
         for(uint32_t i=0;i<imageViews.size();i++)
@@ -26,8 +26,9 @@ namespace vkBasalt
             framebufferCreateInfo.height = extent.height;
             framebufferCreateInfo.layers = 1;
 
-            VkResult result = dispatchTable.CreateFramebuffer(device,&framebufferCreateInfo,nullptr,&(framebuffers[i]));
+            VkResult result = pLogicalDevice->dispatchTable.CreateFramebuffer(pLogicalDevice->device,&framebufferCreateInfo,nullptr,&(framebuffers[i]));
             ASSERT_VULKAN(result);
+            pLogicalDevice->resourceTracker.add(ResourceType::Framebuffer, framebuffers[i]);
             
         }
         return framebuffers;
@@ -10,9 +10,11 @@
 #include "vulkan/vk_layer.h"
 #include "vulkan/vk_layer_dispatch_table.h"
 
+#include "logical_device.hpp"
+
 namespace vkBasalt
 {
-    std::vector<VkFramebuffer> createFramebuffers(VkDevice device, VkLayerDispatchTable dispatchTable, VkRenderPass renderPass, VkExtent2D& extent, std::vector<VkImageView> imageViews);
+    std::vector<VkFramebuffer> createFramebuffers(LogicalDevice* pLogicalDevice, VkRenderPass renderPass, VkExtent2D& extent, std::vector<VkImageView> imageViews);
 }
 
 
@@ -1,5 +1,7 @@
 #include "graphics_pipeline.hpp"
 
+#include <chrono>
+
 #ifndef ASSERT_VULKAN
 #define ASSERT_VULKAN(val)\
         if(val!=VK_SUCCESS)\
@@ -10,30 +12,43 @@
 
 namespace vkBasalt
 {
-    VkPipelineLayout createGraphicsPipelineLayout(VkDevice device, VkLayerDispatchTable dispatchTable, std::vector<VkDescriptorSetLayout> descriptorSetLayouts)
+    namespace
+    {
+        //shader/screen_size.h, four floats at offset 0: width, height and their reciprocals
+        //the smaa vertex shaders read it through SMAA_RT_METRICS, fxaa, deband and the smaa fragment shaders in the fragment stage,
+        //the full screen triangle, cas and lut do not declare it, which a range that names their stage allows
+        //vkCmdPushConstants has to name every stage of the range, so the layout and the push share these
+        const VkShaderStageFlags screenSizeStages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        const uint32_t screenSizeSize = sizeof(float) * 4;
+    }
+
+    VkPipelineLayout createGraphicsPipelineLayout(LogicalDevice* pLogicalDevice, std::vector<VkDescriptorSetLayout> descriptorSetLayouts)
     {
+        VkPushConstantRange screenSizeRange;
+        screenSizeRange.stageFlags = screenSizeStages;
+        screenSizeRange.offset = 0;
+        screenSizeRange.size = screenSizeSize;
+
         VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo;
         pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutCreateInfo.pNext = nullptr;
         pipelineLayoutCreateInfo.flags = 0;
         pipelineLayoutCreateInfo.setLayoutCount = descriptorSetLayouts.size();
         pipelineLayoutCreateInfo.pSetLayouts = descriptorSetLayouts.data();
-        pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-        pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &screenSizeRange;
 
         VkPipelineLayout pipelineLayout;
-        VkResult result = dispatchTable.CreatePipelineLayout(device,&pipelineLayoutCreateInfo,nullptr,&pipelineLayout);
+        VkResult result = pLogicalDevice->dispatchTable.CreatePipelineLayout(pLogicalDevice->device,&pipelineLayoutCreateInfo,nullptr,&pipelineLayout);
         ASSERT_VULKAN(result);
         return pipelineLayout;
     }
     
-    VkPipeline createGraphicsPipeline(VkDevice device,
-                                      VkLayerDispatchTable dispatchTable,
+    VkPipeline createGraphicsPipeline(LogicalDevice* pLogicalDevice,
                                       VkShaderModule vertexModule,
                                       VkSpecializationInfo* vertexSpecializationInfo,
                                       VkShaderModule fragmentModule,
                                       VkSpecializationInfo* fragmentSpecializationInfo,
-                                      VkExtent2D extent,
                                       VkRenderPass renderPass,
                                       VkPipelineLayout pipelineLayout)
     {
@@ -77,26 +92,15 @@ namespace vkBasalt
         inputAssemblyCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
         inputAssemblyCreateInfo.primitiveRestartEnable = VK_FALSE;
 
-        VkViewport viewport;
-        viewport.x = 0.0f;
-        viewport.y = 0.0f;
-        viewport.width = extent.width;
-        viewport.height = extent.height;
-        viewport.minDepth = 0.0f;
-        viewport.maxDepth = 1.0f;
-
-        VkRect2D scissor;
-        scissor.offset = {0,0};
-        scissor.extent = {extent.width,extent.height};
-
+        //the viewport and scissor are dynamic, see recordScreenExtent
         VkPipelineViewportStateCreateInfo viewportStateCreateInfo;
         viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
         viewportStateCreateInfo.pNext = nullptr;
         viewportStateCreateInfo.flags = 0;
         viewportStateCreateInfo.viewportCount = 1;
-        viewportStateCreateInfo.pViewports = &viewport;
+        viewportStateCreateInfo.pViewports = nullptr;
         viewportStateCreateInfo.scissorCount = 1;
-        viewportStateCreateInfo.pScissors = &scissor;
+        viewportStateCreateInfo.pScissors = nullptr;
 
         VkPipelineRasterizationStateCreateInfo rasterizationCreateInfo;
         rasterizationCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -150,13 +154,15 @@ namespace vkBasalt
         colorBlendCreateInfo.blendConstants[3] = 0.0f;
         
         VkDynamicState dynamicStates[] = {
+            VK_DYNAMIC_STATE_VIEWPORT,
+            VK_DYNAMIC_STATE_SCISSOR
         };
 
         VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo;
         dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
         dynamicStateCreateInfo.pNext = nullptr;
         dynamicStateCreateInfo.flags = 0;
-        dynamicStateCreateInfo.dynamicStateCount = 0;
+        dynamicStateCreateInfo.dynamicStateCount = 2;
         dynamicStateCreateInfo.pDynamicStates = dynamicStates;
 
 
@@ -181,9 +187,39 @@ namespace vkBasalt
         pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
         pipelineCreateInfo.basePipelineIndex = -1;
 
-        result = dispatchTable.CreateGraphicsPipelines(device,VK_NULL_HANDLE,1,&pipelineCreateInfo,nullptr,&pipeline);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        result = pLogicalDevice->dispatchTable.CreateGraphicsPipelines(pLogicalDevice->device,pLogicalDevice->pipelineCache.getHandle(),1,&pipelineCreateInfo,nullptr,&pipeline);
         ASSERT_VULKAN(result);
+        pLogicalDevice->pipelineCache.reportCreation(std::chrono::steady_clock::now() - start);
+        pLogicalDevice->resourceTracker.add(ResourceType::Pipeline, pipeline);
         
         return pipeline;
     }
+
+    void recordScreenExtent(LogicalDevice* pLogicalDevice, VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, VkExtent2D extent)
+    {
+        VkViewport viewport;
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = extent.width;
+        viewport.height = extent.height;
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+
+        VkRect2D scissor;
+        scissor.offset = {0,0};
+        scissor.extent = {extent.width,extent.height};
+
+        float screenSize[4] = {(float) extent.width, (float) extent.height, 1.0f / extent.width, 1.0f / extent.height};
+        static_assert(sizeof(screenSize) == screenSizeSize, "the push has to fill the whole range");
+
+        pLogicalDevice->dispatchTable.CmdSetViewport(commandBuffer, 0, 1, &viewport);
+        pLogicalDevice->dispatchTable.CmdSetScissor(commandBuffer, 0, 1, &scissor);
+        pLogicalDevice->dispatchTable.CmdPushConstants(commandBuffer,
+                                                       pipelineLayout,
+                                                       screenSizeStages,
+                                                       0,
+                                                       sizeof(screenSize),
+                                                       screenSize);
+    }
 }
@@ -10,18 +10,20 @@
 #include "vulkan/vk_layer.h"
 #include "vulkan/vk_layer_dispatch_table.h"
 
+#include "logical_device.hpp"
+
 namespace vkBasalt
 {
-    VkPipelineLayout createGraphicsPipelineLayout(VkDevice device, VkLayerDispatchTable dispatchTable, std::vector<VkDescriptorSetLayout> descriptorSetLayouts);
-    VkPipeline createGraphicsPipeline(VkDevice device,
-                                      VkLayerDispatchTable dispatchTable,
+    VkPipelineLayout createGraphicsPipelineLayout(LogicalDevice* pLogicalDevice, std::vector<VkDescriptorSetLayout> descriptorSetLayouts);
+    VkPipeline createGraphicsPipeline(LogicalDevice* pLogicalDevice,
                                       VkShaderModule vertexModule,
                                       VkSpecializationInfo* vertexSpecializationInfo,
                                       VkShaderModule fragmentModule,
                                       VkSpecializationInfo* fragmentSpecializationInfo,
-                                      VkExtent2D extent,
                                       VkRenderPass renderPass,
                                       VkPipelineLayout pipelineLayout);
+    //the viewport, scissor and screen size push constants of the pipelines, they do not depend on the extent so they survive a recreated swapchain
+    void recordScreenExtent(LogicalDevice* pLogicalDevice, VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, VkExtent2D extent);
 
 }
 
@@ -0,0 +1,342 @@
+#ifndef HANDLE_MAP_HPP_INCLUDED
+#define HANDLE_MAP_HPP_INCLUDED
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace vkBasalt
+{
+    /*
+       one hazard pointer per thread, shared by every handle map, a find publishes the table it probes in the slot of its thread
+       finds do not nest, so one slot per thread is enough
+
+       only the first find of a thread writes shared memory to take a slot, the slots are never freed,
+       the slot of a thread that exited goes to the next new thread
+    */
+    class HazardSlots
+    {
+    public:
+        struct alignas(64) Slot
+        {
+            std::atomic<const void*> pointer{nullptr};
+            std::atomic<bool> used{false};
+            Slot* pNext = nullptr;
+        };
+
+        static Slot& get()
+        {
+            thread_local Owner owner;
+            return *owner.pSlot;
+        }
+
+        //whether a find of any thread may still probe the pointer
+        static bool isProtected(const void* pointer)
+        {
+            for(Slot* pSlot = getHead().load(std::memory_order_acquire);pSlot != nullptr;pSlot = pSlot->pNext)
+            {
+                if(pSlot->pointer.load(std::memory_order_seq_cst) == pointer)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        struct Owner
+        {
+            Slot* pSlot;
+            Owner() : pSlot(acquire())
+            {
+            }
+            ~Owner()
+            {
+                pSlot->pointer.store(nullptr, std::memory_order_relaxed);
+                pSlot->used.store(false, std::memory_order_release);
+            }
+        };
+
+        static std::atomic<Slot*>& getHead()
+        {
+            static std::atomic<Slot*> head{nullptr};
+            return head;
+        }
+
+        static Slot* acquire()
+        {
+            std::atomic<Slot*>& head = getHead();
+            for(Slot* pSlot = head.load(std::memory_order_acquire);pSlot != nullptr;pSlot = pSlot->pNext)
+            {
+                bool used = false;
+                if(!pSlot->used.load(std::memory_order_relaxed) && pSlot->used.compare_exchange_strong(used, true, std::memory_order_acquire))
+                {
+                    return pSlot;
+                }
+            }
+            Slot* pSlot = new Slot;
+            pSlot->used.store(true, std::memory_order_relaxed);
+            pSlot->pNext = head.load(std::memory_order_relaxed);
+            while(!head.compare_exchange_weak(pSlot->pNext, pSlot, std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
+            return pSlot;
+        }
+    };
+
+    /*
+       open addressed map from a vulkan handle to a heap allocated record
+
+       find is lock free and may run concurrently to insert and erase,
+       insert and erase are serialized by a mutex, they only happen in create and destroy calls.
+
+       A record is deleted in erase, the vulkan spec already forbids using an object
+       while it is being destroyed, so nobody can still hold a pointer to it.
+
+       A slot whose record got erased keeps its key as a tombstone, so probing continues past it.
+       Tables that got replaced by a rehash are kept while the hazard slot of a find still points to them,
+       so a find only writes the slot of its own thread.
+    */
+    template<typename Record>
+    class HandleMap
+    {
+    public:
+        HandleMap()
+        {
+            pTable.store(createTable(64), std::memory_order_relaxed);
+        }
+
+        ~HandleMap()
+        {
+            Table* table = pTable.load(std::memory_order_relaxed);
+            for(uint32_t i=0;i<=table->mask;i++)
+            {
+                delete table->slots[i].record.load(std::memory_order_relaxed);
+            }
+            delete table;
+            for(Table* retired : retiredTables)
+            {
+                delete retired;
+            }
+        }
+
+        HandleMap(const HandleMap&) = delete;
+        HandleMap& operator=(const HandleMap&) = delete;
+
+        //returns nullptr if there is no record for the handle
+        template<typename Handle>
+        Record* find(Handle handle) const
+        {
+            uint64_t key = toKey(handle);
+            //the table is safe once it is still current after the hazard got published,
+            //a grow that replaces it later sees the hazard when it tries to free it
+            HazardSlots::Slot& hazard = HazardSlots::get();
+            Table* table = pTable.load(std::memory_order_acquire);
+            for(;;)
+            {
+                hazard.pointer.store(table, std::memory_order_seq_cst);
+                Table* current = pTable.load(std::memory_order_seq_cst);
+                if(current == table)
+                {
+                    break;
+                }
+                table = current;
+            }
+            Record* record = nullptr;
+            for(uint32_t i=hash(key)&table->mask;;i=(i+1)&table->mask)
+            {
+                uint64_t slotKey = table->slots[i].key.load(std::memory_order_acquire);
+                if(slotKey == key)
+                {
+                    record = table->slots[i].record.load(std::memory_order_acquire);
+                    break;
+                }
+                if(slotKey == 0)
+                {
+                    break;
+                }
+            }
+            hazard.pointer.store(nullptr, std::memory_order_release);
+            return record;
+        }
+
+        //tables that wait for the running finds to leave them, for tests and debugging
+        size_t retiredTableCount()
+        {
+            std::lock_guard<std::mutex> l(writeLock);
+            return retiredTables.size();
+        }
+
+        //creates a default constructed record for the handle, an existing record gets replaced
+        template<typename Handle>
+        Record& insert(Handle handle)
+        {
+            uint64_t key = toKey(handle);
+            Record* record = new Record();
+            std::lock_guard<std::mutex> l(writeLock);
+
+            Table* table = pTable.load(std::memory_order_relaxed);
+            if((table->usedSlots+1)*2 > table->mask+1)
+            {
+                table = grow(table);
+            }
+
+            Slot* tombstone = nullptr;
+            for(uint32_t i=hash(key)&table->mask;;i=(i+1)&table->mask)
+            {
+                Slot& slot = table->slots[i];
+                uint64_t slotKey = slot.key.load(std::memory_order_relaxed);
+                if(slotKey == key)
+                {
+                    Record* oldRecord = slot.record.exchange(record, std::memory_order_acq_rel);
+                    if(oldRecord)
+                    {
+                        delete oldRecord;
+                    }
+                    else
+                    {
+                        liveRecords++;//the handle was reused while its tombstone was still there
+                    }
+                    return *record;
+                }
+                if(slotKey != 0 && slot.record.load(std::memory_order_relaxed) == nullptr && tombstone == nullptr)
+                {
+                    tombstone = &slot;
+                }
+                if(slotKey == 0)
+                {
+                    //the record has to be visible before the key, since find does not take the lock
+                    Slot& target = tombstone ? *tombstone : slot;
+                    target.record.store(record, std::memory_order_release);
+                    target.key.store(key, std::memory_order_release);
+                    if(!tombstone)
+                    {
+                        table->usedSlots++;
+                    }
+                    liveRecords++;
+                    return *record;
+                }
+            }
+        }
+
+        template<typename Handle>
+        void erase(Handle handle)
+        {
+            uint64_t key = toKey(handle);
+            std::lock_guard<std::mutex> l(writeLock);
+            Table* table = pTable.load(std::memory_order_relaxed);
+            for(uint32_t i=hash(key)&table->mask;;i=(i+1)&table->mask)
+            {
+                Slot& slot = table->slots[i];
+                uint64_t slotKey = slot.key.load(std::memory_order_relaxed);
+                if(slotKey == key)
+                {
+                    Record* record = slot.record.exchange(nullptr, std::memory_order_acq_rel);
+                    if(record)
+                    {
+                        liveRecords--;
+                        delete record;
+                    }
+                    freeRetiredTables();
+                    return;
+                }
+                if(slotKey == 0)
+                {
+                    return;
+                }
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint64_t> key{0};
+            std::atomic<Record*> record{nullptr};
+        };
+        struct Table
+        {
+            uint32_t mask;
+            uint32_t usedSlots;//slots with a key, including tombstones
+            std::unique_ptr<Slot[]> slots;
+        };
+        std::atomic<Table*> pTable;
+        std::mutex writeLock;
+        uint32_t liveRecords = 0;
+        std::vector<Table*> retiredTables;//guarded by writeLock
+
+        //the new table is published before the hazards are read, so a find that does not show up here
+        //sees the new table when it checks its hazard and moves on to it
+        //called with writeLock held, a table that is still probed is freed by a later insert or erase
+        void freeRetiredTables()
+        {
+            for(size_t i=0;i<retiredTables.size();)
+            {
+                if(HazardSlots::isProtected(retiredTables[i]))
+                {
+                    i++;
+                    continue;
+                }
+                delete retiredTables[i];
+                retiredTables[i] = retiredTables.back();
+                retiredTables.pop_back();
+            }
+        }
+
+        template<typename Handle>
+        static uint64_t toKey(Handle handle)
+        {
+            //non dispatchable handles are uint64_t on 32 bit, everything else is a pointer
+            return (uint64_t) handle;
+        }
+
+        static uint32_t hash(uint64_t key)
+        {
+            //fibonacci hashing, handles are mostly aligned pointers so the low bits alone are useless
+            return (uint32_t) ((key * 0x9E3779B97F4A7C15ull) >> 32);
+        }
+
+        static Table* createTable(uint32_t size)
+        {
+            Table* table = new Table;
+            table->mask = size - 1;
+            table->usedSlots = 0;
+            table->slots.reset(new Slot[size]);
+            return table;
+        }
+
+        //rehashes into a new table, only drops tombstones if the live records still fit in the old size
+        Table* grow(Table* table)
+        {
+            uint32_t size = table->mask + 1;
+            if((liveRecords+1)*4 > size)
+            {
+                size *= 2;
+            }
+            Table* newTable = createTable(size);
+            for(uint32_t i=0;i<=table->mask;i++)
+            {
+                Record* record = table->slots[i].record.load(std::memory_order_relaxed);
+                if(!record)
+                {
+                    continue;
+                }
+                uint64_t key = table->slots[i].key.load(std::memory_order_relaxed);
+                uint32_t j = hash(key) & newTable->mask;
+                while(newTable->slots[j].key.load(std::memory_order_relaxed) != 0)
+                {
+                    j = (j+1) & newTable->mask;
+                }
+                newTable->slots[j].record.store(record, std::memory_order_relaxed);
+                newTable->slots[j].key.store(key, std::memory_order_relaxed);
+                newTable->usedSlots++;
+            }
+            pTable.store(newTable, std::memory_order_seq_cst);
+            retiredTables.push_back(table);
+            freeRetiredTables();
+            return newTable;
+        }
+    };
+}
+
+#endif // HANDLE_MAP_HPP_INCLUDED
@@ -1,5 +1,4 @@
 #include "image.hpp"
-#include "memory.hpp"
 #include "buffer.hpp"
 
 #ifndef ASSERT_VULKAN
@@ -12,185 +11,317 @@
 
 namespace vkBasalt
 {
-    std::vector<VkImage> createImages(VkLayerInstanceDispatchTable instanceDispatchTable,
-                                      VkDevice device,
-                                      VkLayerDispatchTable dispatchTable,
-                                      VkPhysicalDevice physicalDevice,
+    namespace
+    {
+        std::vector<VkImage> createUnboundImages(LogicalDevice* pLogicalDevice,
+                                                 uint32_t count,
+                                                 VkExtent3D extent,
+                                                 VkFormat format,
+                                                 VkImageUsageFlags usage)
+        {
+            std::vector<VkImage> images(count);
+            VkImageCreateInfo imageCreateInfo;
+            imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageCreateInfo.pNext = nullptr;
+            imageCreateInfo.flags = 0;
+            if(extent.depth == 1)
+            {
+                imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+            }
+            else
+            {
+                imageCreateInfo.imageType = VK_IMAGE_TYPE_3D;
+            }
+            imageCreateInfo.format = format;
+            imageCreateInfo.extent = extent;
+            imageCreateInfo.mipLevels = 1;
+            imageCreateInfo.arrayLayers = 1;
+            imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageCreateInfo.usage = usage;
+            imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageCreateInfo.queueFamilyIndexCount = 0;//Don't care
+            imageCreateInfo.pQueueFamilyIndices = nullptr;//Don't care
+            imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        
+            VkResult result;
+            for(uint32_t i=0;i<count;i++)
+            {
+                result = pLogicalDevice->dispatchTable.CreateImage(pLogicalDevice->device, &imageCreateInfo, nullptr, &(images[i]));
+                ASSERT_VULKAN(result);
+            }
+            return images;
+        }
+    }
+
+    std::vector<VkImage> createImages(LogicalDevice* pLogicalDevice,
                                       uint32_t count,
                                       VkExtent3D extent,
                                       VkFormat format,
                                       VkImageUsageFlags usage,
                                       VkMemoryPropertyFlags properties,
-                                      VkDeviceMemory& imageMemory)
+                                      MemoryAllocation& imageMemory)
     {
-        std::vector<VkImage> images(count);
-        VkImageCreateInfo imageCreateInfo;
-        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-        imageCreateInfo.pNext = nullptr;
-        imageCreateInfo.flags = 0;
-        if(extent.depth == 1)
-        {
-            imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
-        }
-        else
-        {
-            imageCreateInfo.imageType = VK_IMAGE_TYPE_3D;
-        }
-        imageCreateInfo.format = format;
-        imageCreateInfo.extent = extent;
-        imageCreateInfo.mipLevels = 1;
-        imageCreateInfo.arrayLayers = 1;
-        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-        imageCreateInfo.usage = usage;
-        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        imageCreateInfo.queueFamilyIndexCount = 0;//Don't care
-        imageCreateInfo.pQueueFamilyIndices = nullptr;//Don't care
-        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        
+        std::vector<VkImage> images = createUnboundImages(pLogicalDevice, count, extent, format, usage);
         VkResult result;
-        for(uint32_t i=0;i<count;i++)
-        {
-            result = dispatchTable.CreateImage(device, &imageCreateInfo, nullptr, &(images[i]));
-            ASSERT_VULKAN(result);
-        }
         //Allocate a bunch of memory for all images at one
         VkMemoryRequirements memoryRequirements;
-        dispatchTable.GetImageMemoryRequirements(device, images[0], &memoryRequirements);
+        pLogicalDevice->dispatchTable.GetImageMemoryRequirements(pLogicalDevice->device, images[0], &memoryRequirements);
         
         if(memoryRequirements.size%memoryRequirements.alignment!=0)
         {
             memoryRequirements.size = (memoryRequirements.size/memoryRequirements.alignment+1)*memoryRequirements.alignment;
         }
+        VkDeviceSize imageSize = memoryRequirements.size;
+        memoryRequirements.size *= count;
         
-        VkMemoryAllocateInfo memoryAllocateInfo;
-        memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        memoryAllocateInfo.pNext = nullptr;
-        memoryAllocateInfo.allocationSize = memoryRequirements.size * count;
-        memoryAllocateInfo.memoryTypeIndex = findMemoryTypeIndex(instanceDispatchTable,physicalDevice,memoryRequirements.memoryTypeBits,properties);
-        
-        result = dispatchTable.AllocateMemory(device, &memoryAllocateInfo, nullptr, &imageMemory);
-        ASSERT_VULKAN(result);
+        imageMemory = pLogicalDevice->memoryAllocator.allocate(memoryRequirements, properties, false);
         
         for(uint32_t i=0;i<count;i++)
         {
-            result = dispatchTable.BindImageMemory(device, images[i], imageMemory, memoryRequirements.size*i);
+            result = pLogicalDevice->dispatchTable.BindImageMemory(pLogicalDevice->device, images[i], imageMemory.memory, imageMemory.offset + imageSize*i);
             ASSERT_VULKAN(result);
+            pLogicalDevice->resourceTracker.add(ResourceType::Image, images[i], imageSize);
+        }
+        return images;
+    }
+
+    std::vector<VkImage> createTransientImages(LogicalDevice* pLogicalDevice,
+                                               const std::vector<VkFormat>& formats,
+                                               VkExtent3D extent,
+                                               VkImageUsageFlags usage,
+                                               uint32_t slot,
+                                               TransientRegion*& pRegion)
+    {
+        std::vector<VkImage> images;
+        for(VkFormat format : formats)
+        {
+            images.push_back(createUnboundImages(pLogicalDevice, 1, extent, format, usage)[0]);
+        }
+        pRegion = pLogicalDevice->transientImagePool.bindImages(slot, images);
+        //the memory is counted for the region, the images only alias it
+        for(VkImage image : images)
+        {
+            pLogicalDevice->resourceTracker.add(ResourceType::Image, image);
         }
         return images;
     }
     
-    void uploadToImage(VkLayerInstanceDispatchTable instanceDispatchTable,
-                       VkDevice device,
-                       VkLayerDispatchTable dispatchTable,
-                       VkPhysicalDevice physicalDevice,
+    void uploadToImage(LogicalDevice* pLogicalDevice,
                        VkImage image,
                        VkExtent3D extent,
                        uint32_t size,
-                       VkQueue queue,
-                       VkCommandPool commandPool,
                        const unsigned char* writeData)
     {
         
         VkBuffer stagingBuffer;
-        VkDeviceMemory stagingMemory;
+        MemoryAllocation stagingMemory;
         
-        createBuffer(instanceDispatchTable,
-                     device,
-                     dispatchTable,
-                     physicalDevice,
+        //the staging buffer may outlive the effect that uploads, so it belongs to the device
+        ResourceScope resourceScope(ResourceTracker::deviceOwner);
+        createBuffer(pLogicalDevice,
                      size,
                      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
                      stagingBuffer,
                      stagingMemory);
-        void* data;
-        VkResult result = dispatchTable.MapMemory(device, stagingMemory, 0, size, 0, &data);
-        ASSERT_VULKAN(result);
-        std::memcpy(data, writeData, size);
-        dispatchTable.UnmapMemory(device, stagingMemory);
-        
-        VkCommandBufferAllocateInfo allocInfo = {};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = commandPool;
-        allocInfo.commandBufferCount = 1;
+        //staging memory is host coherent and stays mapped by the allocator
+        std::memcpy(stagingMemory.pMappedData, writeData, size);
+        VkResult result;
+
+        //the upload is recorded for every graphics capable family, the present submits it on the queue of its frame
+        //every upload records into its own pools, so effects built on other threads never wait for the recording
+        const std::vector<VkQueueFamilyProperties>& queueProperties = pLogicalDevice->physicalDeviceInfo.queueFamilyProperties;
+        PendingUpload upload;
+        upload.image = image;
+        upload.commandPools.resize(queueProperties.size(), VK_NULL_HANDLE);
+        upload.commandBuffers.resize(queueProperties.size(), VK_NULL_HANDLE);
+        upload.stagingBuffer = stagingBuffer;
+        upload.stagingMemory = stagingMemory;
+        for(uint32_t queueFamilyIndex=0;queueFamilyIndex<queueProperties.size();queueFamilyIndex++)
+        {
+            if((queueProperties[queueFamilyIndex].queueFlags & VK_QUEUE_GRAPHICS_BIT) == 0)
+            {
+                continue;
+            }
+            VkCommandPoolCreateInfo commandPoolCreateInfo;
+            commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            commandPoolCreateInfo.pNext = nullptr;
+            commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+
+            VkCommandPool& commandPool = upload.commandPools[queueFamilyIndex];
+            result = pLogicalDevice->dispatchTable.CreateCommandPool(pLogicalDevice->device, &commandPoolCreateInfo, nullptr, &commandPool);
+            ASSERT_VULKAN(result);
+
+            VkCommandBufferAllocateInfo allocInfo = {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = commandPool;
+            allocInfo.commandBufferCount = 1;
 
-        VkCommandBuffer commandBuffer;
-        dispatchTable.AllocateCommandBuffers(device, &allocInfo, &commandBuffer);
-        //initialize dispatch table for commandBuffer since it is a dispatchable object
-        *reinterpret_cast<void**>(commandBuffer) = *reinterpret_cast<void**>(device);
+            VkCommandBuffer& commandBuffer = upload.commandBuffers[queueFamilyIndex];
+            pLogicalDevice->dispatchTable.AllocateCommandBuffers(pLogicalDevice->device, &allocInfo, &commandBuffer);
+            //initialize dispatch table for commandBuffer since it is a dispatchable object
+            *reinterpret_cast<void**>(commandBuffer) = *reinterpret_cast<void**>(pLogicalDevice->device);
 
-        VkCommandBufferBeginInfo beginInfo = {};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            VkCommandBufferBeginInfo beginInfo = {};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-        dispatchTable.BeginCommandBuffer(commandBuffer, &beginInfo);
+            pLogicalDevice->dispatchTable.BeginCommandBuffer(commandBuffer, &beginInfo);
         
-        VkImageMemoryBarrier memoryBarrier;
-        memoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        memoryBarrier.pNext = nullptr;
-        memoryBarrier.srcAccessMask = 0;
-        memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        memoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        memoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        memoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        memoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        memoryBarrier.image = image;
-        memoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        memoryBarrier.subresourceRange.baseMipLevel = 0;
-        memoryBarrier.subresourceRange.levelCount = 1;
-        memoryBarrier.subresourceRange.baseArrayLayer = 0;
-        memoryBarrier.subresourceRange.layerCount = 1;
+            VkImageMemoryBarrier memoryBarrier;
+            memoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            memoryBarrier.pNext = nullptr;
+            memoryBarrier.srcAccessMask = 0;
+            memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            memoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            memoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            memoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            memoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            memoryBarrier.image = image;
+            memoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            memoryBarrier.subresourceRange.baseMipLevel = 0;
+            memoryBarrier.subresourceRange.levelCount = 1;
+            memoryBarrier.subresourceRange.baseArrayLayer = 0;
+            memoryBarrier.subresourceRange.layerCount = 1;
         
-        dispatchTable.CmdPipelineBarrier(
-            commandBuffer,
-            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-            0,
-            0, nullptr,
-            0, nullptr,
-            1, &memoryBarrier
-        );
+            pLogicalDevice->dispatchTable.CmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                0, nullptr,
+                0, nullptr,
+                1, &memoryBarrier
+            );
         
-        VkBufferImageCopy region;
-        region.bufferOffset = 0;
-        region.bufferRowLength = 0;
-        region.bufferImageHeight = 0;
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.mipLevel = 0;
-        region.imageSubresource.baseArrayLayer = 0;
-        region.imageSubresource.layerCount = 1;
-        region.imageOffset = {0,0,0};
-        region.imageExtent = extent;
+            VkBufferImageCopy region;
+            region.bufferOffset = 0;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = 0;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset = {0,0,0};
+            region.imageExtent = extent;
         
-        dispatchTable.CmdCopyBufferToImage(commandBuffer,stagingBuffer,image,VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,1,&region);
+            pLogicalDevice->dispatchTable.CmdCopyBufferToImage(commandBuffer,stagingBuffer,image,VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,1,&region);
         
-        memoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        memoryBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            memoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            memoryBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
         
-        dispatchTable.CmdPipelineBarrier(
-            commandBuffer,
-            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-            0,
-            0, nullptr,
-            0, nullptr,
-            1, &memoryBarrier
-        );
+            pLogicalDevice->dispatchTable.CmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                0,
+                0, nullptr,
+                0, nullptr,
+                1, &memoryBarrier
+            );
         
-        dispatchTable.EndCommandBuffer(commandBuffer);
+            pLogicalDevice->dispatchTable.EndCommandBuffer(commandBuffer);
+        }
 
-        VkSubmitInfo submitInfo = {};
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &commandBuffer;
+        std::lock_guard<std::mutex> l(pLogicalDevice->uploadLock);
+        pLogicalDevice->pendingUploads.push_back(std::move(upload));
+        pLogicalDevice->uploadsPending.store(true, std::memory_order_release);
+    }
 
-        dispatchTable.QueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-        dispatchTable.QueueWaitIdle(queue);
+    namespace
+    {
+        void freeUpload(LogicalDevice* pLogicalDevice, PendingUpload& upload)
+        {
+            for(VkCommandPool commandPool : upload.commandPools)
+            {
+                if(commandPool != VK_NULL_HANDLE)
+                {
+                    pLogicalDevice->dispatchTable.DestroyCommandPool(pLogicalDevice->device, commandPool, nullptr);
+                }
+            }
+            pLogicalDevice->dispatchTable.DestroyBuffer(pLogicalDevice->device, upload.stagingBuffer, nullptr);
+            pLogicalDevice->resourceTracker.remove(ResourceType::Buffer, upload.stagingBuffer);
+            pLogicalDevice->memoryAllocator.free(upload.stagingMemory);
+        }
+    }
 
-        dispatchTable.FreeCommandBuffers(device, commandPool, 1, &commandBuffer);
-        dispatchTable.FreeMemory(device,stagingMemory,nullptr);
-        dispatchTable.DestroyBuffer(device,stagingBuffer,nullptr);
+    void discardUpload(LogicalDevice* pLogicalDevice, VkImage image)
+    {
+        std::lock_guard<std::mutex> l(pLogicalDevice->uploadLock);
+        std::vector<PendingUpload>& pendingUploads = pLogicalDevice->pendingUploads;
+        for(auto upload = pendingUploads.begin(); upload != pendingUploads.end(); upload++)
+        {
+            if(upload->image == image)
+            {
+                freeUpload(pLogicalDevice, *upload);
+                pendingUploads.erase(upload);
+                pLogicalDevice->uploadsPending.store(!pendingUploads.empty(), std::memory_order_relaxed);
+                return;
+            }
+        }
+        for(SubmittedUploads& submittedUploads : pLogicalDevice->submittedUploads)
+        {
+            for(PendingUpload& upload : submittedUploads.uploads)
+            {
+                //without timeline semaphores there is no value to wait for, but the effect that owns the image
+                //is only destroyed once the application idled the queues, see RetiredSwapchain
+                if(upload.image == image && submittedUploads.timelineSemaphore != VK_NULL_HANDLE)
+                {
+                    VkSemaphoreWaitInfo waitInfo;
+                    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+                    waitInfo.pNext = nullptr;
+                    waitInfo.flags = 0;
+                    waitInfo.semaphoreCount = 1;
+                    waitInfo.pSemaphores = &submittedUploads.timelineSemaphore;
+                    waitInfo.pValues = &submittedUploads.frameValue;
+                    pLogicalDevice->dispatchTable.WaitSemaphores(pLogicalDevice->device, &waitInfo, UINT64_MAX);
+                    return;
+                }
+            }
+        }
+    }
+
+    void freeFinishedUploads(LogicalDevice* pLogicalDevice, VkSemaphore timelineSemaphore, uint64_t completedValue)
+    {
+        std::lock_guard<std::mutex> l(pLogicalDevice->uploadLock);
+        std::vector<SubmittedUploads>& submittedUploads = pLogicalDevice->submittedUploads;
+        //every queue frees only its own batches, the values of different queues are not comparable
+        for(auto batch = submittedUploads.begin(); batch != submittedUploads.end();)
+        {
+            if(batch->timelineSemaphore != timelineSemaphore || batch->frameValue > completedValue)
+            {
+                batch++;
+                continue;
+            }
+            for(PendingUpload& upload : batch->uploads)
+            {
+                freeUpload(pLogicalDevice, upload);
+            }
+            batch = submittedUploads.erase(batch);
+        }
+        pLogicalDevice->uploadsSubmitted.store(!submittedUploads.empty(), std::memory_order_relaxed);
+    }
+
+    void freeUploads(LogicalDevice* pLogicalDevice)
+    {
+        std::lock_guard<std::mutex> l(pLogicalDevice->uploadLock);
+        for(SubmittedUploads& submittedUploads : pLogicalDevice->submittedUploads)
+        {
+            for(PendingUpload& upload : submittedUploads.uploads)
+            {
+                freeUpload(pLogicalDevice, upload);
+            }
+        }
+        pLogicalDevice->submittedUploads.clear();
+        pLogicalDevice->uploadsSubmitted.store(false, std::memory_order_relaxed);
+        for(PendingUpload& upload : pLogicalDevice->pendingUploads)
+        {
+            freeUpload(pLogicalDevice, upload);
+        }
+        pLogicalDevice->pendingUploads.clear();
+        pLogicalDevice->uploadsPending.store(false, std::memory_order_relaxed);
     }
 }
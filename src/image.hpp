@@ -10,28 +10,37 @@
 #include "vulkan/vulkan.h"
 #include "vulkan/vk_layer.h"
 #include "vulkan/vk_layer_dispatch_table.h"
+
+#include "logical_device.hpp"
 namespace vkBasalt
 {
-    std::vector<VkImage> createImages(VkLayerInstanceDispatchTable instanceDispatchTable,
-                                      VkDevice device,
-                                      VkLayerDispatchTable dispatchTable,
-                                      VkPhysicalDevice physicalDevice,
+    std::vector<VkImage> createImages(LogicalDevice* pLogicalDevice,
                                       uint32_t count,
                                       VkExtent3D extent,
                                       VkFormat format,
                                       VkImageUsageFlags usage,
                                       VkMemoryPropertyFlags properties,
-                                      VkDeviceMemory& imageMemory);
-    void uploadToImage(VkLayerInstanceDispatchTable instanceDispatchTable,
-                       VkDevice device,
-                       VkLayerDispatchTable dispatchTable,
-                       VkPhysicalDevice physicalDevice,
+                                      MemoryAllocation& imageMemory);
+    //one image per format, they alias the scratch images of other effects in the same slot, see TransientImagePool
+    std::vector<VkImage> createTransientImages(LogicalDevice* pLogicalDevice,
+                                               const std::vector<VkFormat>& formats,
+                                               VkExtent3D extent,
+                                               VkImageUsageFlags usage,
+                                               uint32_t slot,
+                                               TransientRegion*& pRegion);
+    //records the upload, the next present submits it in front of its frame, see PendingUpload
+    void uploadToImage(LogicalDevice* pLogicalDevice,
                        VkImage image,
                        VkExtent3D extent,
                        uint32_t size,
-                       VkQueue queue,
-                       VkCommandPool commandPool,
                        const unsigned char* writeData);
+    //has to be called before an image that got an upload is destroyed,
+    //drops the upload if it was not submitted yet or waits for it otherwise
+    void discardUpload(LogicalDevice* pLogicalDevice, VkImage image);
+    //frees the staging resources of the uploads a present on the queue of timelineSemaphore submitted in a frame up to completedValue
+    void freeFinishedUploads(LogicalDevice* pLogicalDevice, VkSemaphore timelineSemaphore, uint64_t completedValue);
+    //frees every upload, submitted or not, the device has to be idle
+    void freeUploads(LogicalDevice* pLogicalDevice);
 }
 
 
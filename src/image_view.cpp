@@ -10,7 +10,7 @@
 
 namespace vkBasalt
 {
-    std::vector<VkImageView> createImageViews(VkDevice device, VkLayerDispatchTable dispatchTable, VkFormat format, std::vector<VkImage> images, VkImageViewType viewType)
+    std::vector<VkImageView> createImageViews(LogicalDevice* pLogicalDevice, VkFormat format, std::vector<VkImage> images, VkImageViewType viewType)
     {
         std::vector<VkImageView> imageViews(images.size());
         
@@ -35,8 +35,9 @@ namespace vkBasalt
         for(unsigned int i=0;i<images.size();i++)
         {
             imageViewCreateInfo.image = images[i];
-            VkResult result = dispatchTable.CreateImageView(device,&imageViewCreateInfo,nullptr,&(imageViews[i]));
+            VkResult result = pLogicalDevice->dispatchTable.CreateImageView(pLogicalDevice->device,&imageViewCreateInfo,nullptr,&(imageViews[i]));
             ASSERT_VULKAN(result);
+            pLogicalDevice->resourceTracker.add(ResourceType::ImageView, imageViews[i]);
         }
         
         return imageViews;
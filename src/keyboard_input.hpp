@@ -0,0 +1,14 @@
+#ifndef KEYBOARD_INPUT_HPP_INCLUDED
+#define KEYBOARD_INPUT_HPP_INCLUDED
+#include <string>
+#include <cstdint>
+
+namespace vkBasalt
+{
+    //returns 0 if the name is not a known key, names are the X11 keysym names e.g. Home or F12
+    uint32_t convertToKeySym(const std::string& key);
+    //returns false if there is no X server to ask
+    bool isKeyPressed(uint32_t keySym);
+}
+
+#endif // KEYBOARD_INPUT_HPP_INCLUDED
@@ -0,0 +1,30 @@
+#include "keyboard_input.hpp"
+
+#include <memory>
+
+#include <X11/Xlib.h>
+
+namespace vkBasalt
+{
+    uint32_t convertToKeySym(const std::string& key)
+    {
+        return (uint32_t) XStringToKeysym(key.c_str());
+    }
+
+    //the caller makes sure only one thread asks at a time, the display connection is not thread safe,
+    //pollToggleKey holds its polling flag around the whole query
+    bool isKeyPressed(uint32_t keySym)
+    {
+        static std::unique_ptr<Display, int(*)(Display*)> display(XOpenDisplay(nullptr), XCloseDisplay);
+        if(!display)
+        {
+            return false;
+        }
+
+        char keyMap[32];
+        XQueryKeymap(display.get(), keyMap);
+
+        KeyCode keyCode = XKeysymToKeycode(display.get(), (KeySym) keySym);
+        return (keyMap[keyCode/8] & (1 << (keyCode%8))) != 0;
+    }
+}
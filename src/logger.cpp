@@ -0,0 +1,220 @@
+#include "logger.hpp"
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <cstdlib>
+#include <chrono>
+
+namespace vkBasalt
+{
+    namespace
+    {
+        LogLevel readLogLevel()
+        {
+            const char* env = std::getenv("VKBASALT_LOG_LEVEL");
+            if(env == nullptr)
+            {
+                return LogLevel::Info;
+            }
+            std::string level(env);
+            if(level == "trace")
+            {
+                return LogLevel::Trace;
+            }
+            if(level == "debug")
+            {
+                return LogLevel::Debug;
+            }
+            if(level == "warning")
+            {
+                return LogLevel::Warning;
+            }
+            if(level == "error")
+            {
+                return LogLevel::Error;
+            }
+            if(level == "none")
+            {
+                return LogLevel::None;
+            }
+            return LogLevel::Info;
+        }
+
+        const char* levelName(LogLevel level)
+        {
+            switch(level)
+            {
+                case LogLevel::Trace:   return "trace";
+                case LogLevel::Debug:   return "debug";
+                case LogLevel::Info:    return "info";
+                case LogLevel::Warning: return "warning";
+                case LogLevel::Error:   return "error";
+                default:                return "";
+            }
+        }
+
+        /*
+           bounded multi producer ring, every entry carries a sequence number that tells
+           whether it is free for the producer of position n (sequence == n)
+           or filled for the consumer (sequence == n+1)
+
+           long messages get cut to the size of an entry
+        */
+        class LogRing
+        {
+        public:
+            LogRing()
+            {
+                entries.reset(new Entry[ringSize]);
+                for(uint64_t i=0;i<ringSize;i++)
+                {
+                    entries[i].sequence.store(i, std::memory_order_relaxed);
+                }
+
+                const char* fileName = std::getenv("VKBASALT_LOG_FILE");
+                if(fileName != nullptr)
+                {
+                    file.open(fileName, std::ios::out | std::ios::trunc);
+                }
+                output = file.is_open() ? &file : &std::cerr;
+
+                writerThread = std::thread(&LogRing::writeLoop, this);
+            }
+
+            ~LogRing()
+            {
+                stop.store(true, std::memory_order_release);
+                wakeUp.notify_one();
+                writerThread.join();
+            }
+
+            void push(LogLevel level, const std::string& message)
+            {
+                uint64_t position = enqueuePosition.load(std::memory_order_relaxed);
+                Entry* entry;
+                for(;;)
+                {
+                    entry = &entries[position & (ringSize-1)];
+                    int64_t difference = (int64_t) entry->sequence.load(std::memory_order_acquire) - (int64_t) position;
+                    if(difference == 0)
+                    {
+                        if(enqueuePosition.compare_exchange_weak(position, position+1, std::memory_order_relaxed))
+                        {
+                            break;
+                        }
+                    }
+                    else if(difference < 0)
+                    {
+                        //the writer did not catch up yet
+                        dropped.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    }
+                    else
+                    {
+                        position = enqueuePosition.load(std::memory_order_relaxed);
+                    }
+                }
+
+                entry->level = level;
+                entry->length = std::min(message.size(), sizeof(entry->message));
+                std::memcpy(entry->message, message.data(), entry->length);
+                entry->sequence.store(position+1, std::memory_order_release);
+                wakeUp.notify_one();
+            }
+
+        private:
+            static constexpr uint64_t ringSize = 512;//power of two
+
+            struct Entry
+            {
+                std::atomic<uint64_t> sequence;
+                LogLevel level;
+                size_t length;
+                char message[240];
+            };
+
+            std::unique_ptr<Entry[]> entries;
+            std::atomic<uint64_t> enqueuePosition{0};
+            uint64_t dequeuePosition = 0;//only touched by the writer thread
+            std::atomic<uint32_t> dropped{0};
+            std::atomic<bool> stop{false};
+
+            std::ofstream file;
+            std::ostream* output;
+            std::thread writerThread;
+            std::mutex wakeUpLock;
+            std::condition_variable wakeUp;
+
+            //returns false if the ring is empty
+            bool writeNext()
+            {
+                Entry& entry = entries[dequeuePosition & (ringSize-1)];
+                if(entry.sequence.load(std::memory_order_acquire) != dequeuePosition+1)
+                {
+                    return false;
+                }
+                *output << "vkBasalt " << levelName(entry.level) << ": ";
+                output->write(entry.message, entry.length);
+                *output << '\n';
+                entry.sequence.store(dequeuePosition+ringSize, std::memory_order_release);
+                dequeuePosition++;
+                return true;
+            }
+
+            void writeLoop()
+            {
+                for(;;)
+                {
+                    bool stopping = stop.load(std::memory_order_acquire);
+                    bool wroteSomething = false;
+                    while(writeNext())
+                    {
+                        wroteSomething = true;
+                    }
+                    uint32_t droppedCount = dropped.exchange(0, std::memory_order_relaxed);
+                    if(droppedCount != 0)
+                    {
+                        *output << "vkBasalt warning: dropped " << droppedCount << " log messages\n";
+                        wroteSomething = true;
+                    }
+                    if(wroteSomething)
+                    {
+                        output->flush();
+                    }
+                    if(stopping)
+                    {
+                        return;
+                    }
+                    //the producers notify without taking the lock, the timeout catches a missed wake up
+                    std::unique_lock<std::mutex> l(wakeUpLock);
+                    wakeUp.wait_for(l, std::chrono::milliseconds(50));
+                }
+            }
+        };
+
+        LogRing& getLogRing()
+        {
+            //created with the first message that passes the level, so a silent layer never starts the thread
+            static LogRing logRing;
+            return logRing;
+        }
+    }
+
+    LogLevel Logger::getLevel()
+    {
+        static const LogLevel level = readLogLevel();
+        return level;
+    }
+
+    void Logger::push(LogLevel level, const std::string& message)
+    {
+        getLogRing().push(level, message);
+    }
+}
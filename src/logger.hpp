@@ -0,0 +1,85 @@
+#ifndef LOGGER_HPP_INCLUDED
+#define LOGGER_HPP_INCLUDED
+#include <string>
+#include <sstream>
+#include <cstdint>
+
+namespace vkBasalt
+{
+    enum class LogLevel : uint32_t
+    {
+        Trace = 0,
+        Debug,
+        Info,
+        Warning,
+        Error,
+        None
+    };
+
+    //trace messages come from recording command buffers, they only get compiled in with -DVKBASALT_LOG_TRACE
+#ifdef VKBASALT_LOG_TRACE
+    constexpr LogLevel compiledLogLevel = LogLevel::Trace;
+#else
+    constexpr LogLevel compiledLogLevel = LogLevel::Debug;
+#endif
+
+    /*
+       leveled logging for the whole layer
+
+       VKBASALT_LOG_LEVEL selects the lowest level that gets written (trace, debug, info, warning, error, none), default is info
+       VKBASALT_LOG_FILE writes into that file instead of stderr
+
+       the calling thread only formats the message and puts it into a lock free ring buffer,
+       a background thread writes it out, if the ring is full the message is dropped instead of blocking the application
+    */
+    class Logger
+    {
+    public:
+        template<typename... Args>
+        static void trace(const Args&... args)
+        {
+            log<LogLevel::Trace>(args...);
+        }
+        template<typename... Args>
+        static void debug(const Args&... args)
+        {
+            log<LogLevel::Debug>(args...);
+        }
+        template<typename... Args>
+        static void info(const Args&... args)
+        {
+            log<LogLevel::Info>(args...);
+        }
+        template<typename... Args>
+        static void warn(const Args&... args)
+        {
+            log<LogLevel::Warning>(args...);
+        }
+        template<typename... Args>
+        static void err(const Args&... args)
+        {
+            log<LogLevel::Error>(args...);
+        }
+
+        static LogLevel getLevel();
+
+    private:
+        template<LogLevel level, typename... Args>
+        static void log(const Args&... args)
+        {
+            if constexpr(level >= compiledLogLevel)
+            {
+                if(level >= getLevel())
+                {
+                    std::ostringstream stream;
+                    (stream << ... << args);
+                    push(level, stream.str());
+                }
+            }
+        }
+
+        static void push(LogLevel level, const std::string& message);
+    };
+}
+
+#endif // LOGGER_HPP_INCLUDED
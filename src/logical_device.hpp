@@ -0,0 +1,83 @@
+#ifndef LOGICAL_DEVICE_HPP_INCLUDED
+#define LOGICAL_DEVICE_HPP_INCLUDED
+#include <mutex>
+#include <atomic>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+#include "vulkan/vk_layer.h"
+#include "vulkan/vk_layer_dispatch_table.h"
+
+#include "physical_device_info.hpp"
+#include "resource_tracker.hpp"
+#include "memory_allocator.hpp"
+#include "transient_image_pool.hpp"
+#include "pipeline_cache.hpp"
+#include "object_cache.hpp"
+
+namespace vkBasalt
+{
+    //an upload recorded by an effect build, the layer must not submit to a queue of the application from its own threads,
+    //so the next present submits it in front of its frame, on the queue it submits the frame to
+    //it is recorded for every graphics capable queue family, so no present has to move to another queue for it
+    struct PendingUpload
+    {
+        VkImage image;
+        std::vector<VkCommandPool> commandPools;//indexed by queue family, the upload's own pools, destroying them frees the command buffers
+        std::vector<VkCommandBuffer> commandBuffers;//indexed by queue family, VK_NULL_HANDLE for families without graphics
+        VkBuffer stagingBuffer;
+        MemoryAllocation stagingMemory;
+    };
+
+    //the uploads one present submitted, their staging resources are freed once the timeline of the queue reached the frame,
+    //without timeline semaphores timelineSemaphore is VK_NULL_HANDLE and they stay until the device is idle
+    struct SubmittedUploads
+    {
+        VkSemaphore timelineSemaphore;
+        uint64_t frameValue;
+        std::vector<PendingUpload> uploads;
+    };
+
+    /*
+       everything that belongs to one VkDevice
+
+       created once in vkCreateDevice and shared through a std::shared_ptr by the layer,
+       the swapchains and their effects, helpers get a plain pointer to it
+       so the dispatch tables are never copied
+    */
+    struct LogicalDevice
+    {
+        VkLayerDispatchTable dispatchTable;
+        VkLayerInstanceDispatchTable instanceDispatchTable;
+        VkDevice device;
+        VkPhysicalDevice physicalDevice;
+        PhysicalDeviceInfo physicalDeviceInfo;
+        //the first graphics queue, used when the presenting queue has no graphics and can not run the effects
+        VkQueue queue;
+        uint32_t queueFamilyIndex;
+        VkCommandPool commandPool;
+        std::vector<VkCommandPool> commandPools;//indexed by queue family, VK_NULL_HANDLE for families without graphics
+        std::vector<VkQueue> queues;//every queue the application got from this device
+        bool timelineSemaphores;//true if the device was created with timeline semaphores enabled
+        bool memoryBudget;//true if VK_EXT_memory_budget can be queried
+        bool dedicatedAllocation;//true if vkGetImageMemoryRequirements2 and VkMemoryDedicatedAllocateInfo can be used
+        std::vector<PendingUpload> pendingUploads;//recorded, not submitted yet
+        std::vector<SubmittedUploads> submittedUploads;
+        std::atomic<bool> uploadsSubmitted;//submittedUploads is not empty, so the presents only take uploadLock if there is something to free
+        std::atomic<bool> uploadsPending;//pendingUploads is not empty, so the presents only take uploadLock if there is something to submit
+        std::mutex uploadLock;//guards pendingUploads and submittedUploads, a present with uploads holds it until they are submitted
+        ResourceTracker resourceTracker;//what the layer created, by swapchain and effect
+        MemoryAllocator memoryAllocator;//every image and buffer of the layer gets its memory from here
+        TransientImagePool transientImagePool;
+        PipelineCache pipelineCache;//every pipeline of the layer is created with it, saved to disk in vkDestroyDevice
+        ObjectCache objectCache;//shader modules, samplers, render passes and descriptor set layouts, shared by content
+        //the last frame the layer submitted on any queue, the next one waits for it since they share the transient images
+        VkQueue lastFrameQueue;
+        VkSemaphore lastFrameSemaphore;
+        uint64_t lastFrameValue;
+        std::mutex lastFrameLock;//guards the last frame, only held for the bookkeeping of a present
+        std::mutex lock;//guards queue, queueFamilyIndex, the command pools, queues and submits to the fallback queue
+    };
+}
+
+#endif // LOGICAL_DEVICE_HPP_INCLUDED
@@ -9,10 +9,9 @@
 #endif
 namespace vkBasalt
 {
-    uint32_t findMemoryTypeIndex(VkLayerInstanceDispatchTable dispatchTable, VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties)
+    uint32_t findMemoryTypeIndex(LogicalDevice* pLogicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties)
     {
-        VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties;
-        dispatchTable.GetPhysicalDeviceMemoryProperties(physicalDevice,&physicalDeviceMemoryProperties);
+        VkPhysicalDeviceMemoryProperties& physicalDeviceMemoryProperties = pLogicalDevice->physicalDeviceInfo.memoryProperties;
         for(uint32_t i=0;i<physicalDeviceMemoryProperties.memoryTypeCount;i++)
         {
             if((typeFilter & (1 << i)) && (physicalDeviceMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
@@ -23,4 +22,33 @@ namespace vkBasalt
 
         throw std::runtime_error("Found no correct memory type");
     }
+
+    void getImageMemoryRequirements(LogicalDevice* pLogicalDevice, VkImage image, VkMemoryRequirements& memoryRequirements, bool& dedicated)
+    {
+        if(!pLogicalDevice->dedicatedAllocation)
+        {
+            pLogicalDevice->dispatchTable.GetImageMemoryRequirements(pLogicalDevice->device, image, &memoryRequirements);
+            dedicated = false;
+            return;
+        }
+
+        VkMemoryDedicatedRequirements dedicatedRequirements;
+        dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+        dedicatedRequirements.pNext = nullptr;
+        dedicatedRequirements.prefersDedicatedAllocation = VK_FALSE;
+        dedicatedRequirements.requiresDedicatedAllocation = VK_FALSE;
+
+        VkMemoryRequirements2 memoryRequirements2;
+        memoryRequirements2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+        memoryRequirements2.pNext = &dedicatedRequirements;
+
+        VkImageMemoryRequirementsInfo2 requirementsInfo;
+        requirementsInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+        requirementsInfo.pNext = nullptr;
+        requirementsInfo.image = image;
+
+        pLogicalDevice->dispatchTable.GetImageMemoryRequirements2(pLogicalDevice->device, &requirementsInfo, &memoryRequirements2);
+        memoryRequirements = memoryRequirements2.memoryRequirements;
+        dedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+    }
 }
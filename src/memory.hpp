@@ -10,8 +10,12 @@
 #include "vulkan/vk_layer.h"
 #include "vulkan/vk_layer_dispatch_table.h"
 
+#include "logical_device.hpp"
+
 namespace vkBasalt{
-    uint32_t findMemoryTypeIndex(VkLayerInstanceDispatchTable dispatchTable, VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties);
+    uint32_t findMemoryTypeIndex(LogicalDevice* pLogicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties);
+    //dedicated is true if the driver prefers or requires the image to have a VkDeviceMemory of its own
+    void getImageMemoryRequirements(LogicalDevice* pLogicalDevice, VkImage image, VkMemoryRequirements& memoryRequirements, bool& dedicated);
 }
 
 
@@ -0,0 +1,477 @@
+#include "memory_allocator.hpp"
+#include "logical_device.hpp"
+#include "memory.hpp"
+#include "logger.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+#ifndef ASSERT_VULKAN
+#define ASSERT_VULKAN(val)\
+        if(val!=VK_SUCCESS)\
+        {\
+            throw std::runtime_error("ASSERT_VULKAN failed " + std::to_string(val));\
+        }
+#endif
+
+namespace vkBasalt
+{
+    namespace
+    {
+        //every offset and size inside a block is a multiple of this, so tiny ranges never fragment the free lists
+        constexpr VkDeviceSize granularity = 256;
+        constexpr uint32_t secondLevelBits = 2;
+        constexpr uint32_t secondLevelCount = 1 << secondLevelBits;
+        constexpr uint32_t firstLevelCount = 64;
+
+        constexpr VkDeviceSize firstBlockSize = 32 * 1024 * 1024;
+        constexpr VkDeviceSize maxBlockSize = 256 * 1024 * 1024;
+
+        VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        uint32_t findLastSet(uint64_t value)
+        {
+            return 63 - __builtin_clzll(value);
+        }
+
+        uint32_t findFirstSet(uint64_t value)
+        {
+            return __builtin_ctzll(value);
+        }
+
+        //size must be at least granularity
+        void mapSize(VkDeviceSize size, uint32_t& firstLevel, uint32_t& secondLevel)
+        {
+            firstLevel = findLastSet(size);
+            secondLevel = (uint32_t) (size >> (firstLevel - secondLevelBits)) & (secondLevelCount - 1);
+        }
+    }
+
+    struct MemoryRange
+    {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+        bool free;
+        //neighbors in the block, sorted by offset
+        MemoryRange* pPrevious;
+        MemoryRange* pNext;
+        //neighbors in the free list of the same size class
+        MemoryRange* pPreviousFree;
+        MemoryRange* pNextFree;
+    };
+
+    struct MemoryBlock
+    {
+        VkDeviceMemory memory;
+        uint32_t memoryTypeIndex;
+        bool linear;
+        bool dedicated;//bound to a single image with VkMemoryDedicatedAllocateInfo
+        VkDeviceSize size;
+        VkDeviceSize usedSize;
+        void* pMappedData;
+        MemoryRange* pFirstRange;
+
+        uint64_t firstLevelBitmap;
+        uint32_t secondLevelBitmaps[firstLevelCount];
+        MemoryRange* freeLists[firstLevelCount][secondLevelCount];
+
+        MemoryBlock(VkDeviceMemory memory, uint32_t memoryTypeIndex, bool linear, bool dedicated, VkDeviceSize size, void* pMappedData)
+            : memory(memory), memoryTypeIndex(memoryTypeIndex), linear(linear), dedicated(dedicated), size(size), usedSize(0), pMappedData(pMappedData), firstLevelBitmap(0)
+        {
+            std::fill(std::begin(secondLevelBitmaps), std::end(secondLevelBitmaps), 0);
+            std::fill(&freeLists[0][0], &freeLists[0][0] + firstLevelCount * secondLevelCount, nullptr);
+            pFirstRange = new MemoryRange{0, size, true, nullptr, nullptr, nullptr, nullptr};
+            insertFree(pFirstRange);
+        }
+
+        ~MemoryBlock()
+        {
+            MemoryRange* pRange = pFirstRange;
+            while(pRange != nullptr)
+            {
+                MemoryRange* pNext = pRange->pNext;
+                delete pRange;
+                pRange = pNext;
+            }
+        }
+
+        void insertFree(MemoryRange* pRange)
+        {
+            uint32_t firstLevel, secondLevel;
+            mapSize(pRange->size, firstLevel, secondLevel);
+            pRange->free = true;
+            pRange->pPreviousFree = nullptr;
+            pRange->pNextFree = freeLists[firstLevel][secondLevel];
+            if(pRange->pNextFree != nullptr)
+            {
+                pRange->pNextFree->pPreviousFree = pRange;
+            }
+            freeLists[firstLevel][secondLevel] = pRange;
+            firstLevelBitmap |= uint64_t(1) << firstLevel;
+            secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+        }
+
+        void removeFree(MemoryRange* pRange)
+        {
+            uint32_t firstLevel, secondLevel;
+            mapSize(pRange->size, firstLevel, secondLevel);
+            if(pRange->pPreviousFree != nullptr)
+            {
+                pRange->pPreviousFree->pNextFree = pRange->pNextFree;
+            }
+            else
+            {
+                freeLists[firstLevel][secondLevel] = pRange->pNextFree;
+            }
+            if(pRange->pNextFree != nullptr)
+            {
+                pRange->pNextFree->pPreviousFree = pRange->pPreviousFree;
+            }
+            if(freeLists[firstLevel][secondLevel] == nullptr)
+            {
+                secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+                if(secondLevelBitmaps[firstLevel] == 0)
+                {
+                    firstLevelBitmap &= ~(uint64_t(1) << firstLevel);
+                }
+            }
+            pRange->free = false;
+        }
+
+        //cuts the range down to size, the rest behind it becomes a free range
+        void splitOff(MemoryRange* pRange, VkDeviceSize size)
+        {
+            MemoryRange* pRest = new MemoryRange{pRange->offset + size, pRange->size - size, true, pRange, pRange->pNext, nullptr, nullptr};
+            if(pRange->pNext != nullptr)
+            {
+                pRange->pNext->pPrevious = pRest;
+            }
+            pRange->pNext = pRest;
+            pRange->size = size;
+            insertFree(pRest);
+        }
+
+        //returns nullptr if no free range is big enough
+        MemoryRange* allocate(VkDeviceSize size, VkDeviceSize alignment)
+        {
+            //an empty block is a single range at offset 0, the size class search below would be too pessimistic for it
+            if(usedSize == 0 && size <= this->size)
+            {
+                MemoryRange* pRange = pFirstRange;
+                removeFree(pRange);
+                if(pRange->size > size)
+                {
+                    splitOff(pRange, size);
+                }
+                usedSize += pRange->size;
+                return pRange;
+            }
+            //worst case padding, so every range in the found list fits no matter where it starts
+            VkDeviceSize searchSize = size + (alignment > granularity ? alignment - granularity : 0);
+            if(searchSize > this->size)
+            {
+                return nullptr;
+            }
+            uint32_t firstLevel, secondLevel;
+            mapSize(searchSize, firstLevel, secondLevel);
+            //round up to the next size class, the ranges in the own class could be smaller
+            searchSize += (VkDeviceSize(1) << (firstLevel - secondLevelBits)) - 1;
+            mapSize(searchSize, firstLevel, secondLevel);
+
+            uint32_t secondLevelMap = secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+            if(secondLevelMap == 0)
+            {
+                uint64_t firstLevelMap = firstLevel + 1 < firstLevelCount ? firstLevelBitmap & (~uint64_t(0) << (firstLevel + 1)) : 0;
+                if(firstLevelMap == 0)
+                {
+                    return nullptr;
+                }
+                firstLevel = findFirstSet(firstLevelMap);
+                secondLevelMap = secondLevelBitmaps[firstLevel];
+            }
+            secondLevel = findFirstSet(secondLevelMap);
+
+            MemoryRange* pRange = freeLists[firstLevel][secondLevel];
+            removeFree(pRange);
+
+            VkDeviceSize padding = alignUp(pRange->offset, alignment) - pRange->offset;
+            if(padding != 0)
+            {
+                //the padding stays free as its own range in front
+                splitOff(pRange, padding);
+                MemoryRange* pPadding = pRange;
+                pRange = pRange->pNext;
+                removeFree(pRange);
+                insertFree(pPadding);
+            }
+            if(pRange->size > size)
+            {
+                splitOff(pRange, size);
+            }
+            usedSize += pRange->size;
+            return pRange;
+        }
+
+        void free(MemoryRange* pRange)
+        {
+            usedSize -= pRange->size;
+            MemoryRange* pPrevious = pRange->pPrevious;
+            if(pPrevious != nullptr && pPrevious->free)
+            {
+                removeFree(pPrevious);
+                pPrevious->size += pRange->size;
+                pPrevious->pNext = pRange->pNext;
+                if(pRange->pNext != nullptr)
+                {
+                    pRange->pNext->pPrevious = pPrevious;
+                }
+                delete pRange;
+                pRange = pPrevious;
+            }
+            MemoryRange* pNext = pRange->pNext;
+            if(pNext != nullptr && pNext->free)
+            {
+                removeFree(pNext);
+                pRange->size += pNext->size;
+                pRange->pNext = pNext->pNext;
+                if(pNext->pNext != nullptr)
+                {
+                    pNext->pNext->pPrevious = pRange;
+                }
+                delete pNext;
+            }
+            insertFree(pRange);
+        }
+    };
+
+    MemoryAllocator::MemoryAllocator()
+        : pLogicalDevice(nullptr), separateLinear(false), allocatedSize(0), usedSize(0), peakAllocatedSize(0)
+    {
+    }
+
+    MemoryAllocator::~MemoryAllocator()
+    {
+    }
+
+    void MemoryAllocator::init(LogicalDevice* pLogicalDevice)
+    {
+        this->pLogicalDevice = pLogicalDevice;
+        separateLinear = pLogicalDevice->physicalDeviceInfo.properties.limits.bufferImageGranularity > 1;
+
+        VkPhysicalDeviceMemoryProperties& memoryProperties = pLogicalDevice->physicalDeviceInfo.memoryProperties;
+        nextBlockSizes.resize(memoryProperties.memoryTypeCount);
+        for(uint32_t i=0;i<memoryProperties.memoryTypeCount;i++)
+        {
+            VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[i].heapIndex].size;
+            nextBlockSizes[i] = std::max(granularity, alignUp(std::min(firstBlockSize, heapSize / 8), granularity));
+        }
+    }
+
+    void MemoryAllocator::destroy()
+    {
+        std::lock_guard<std::mutex> l(lock);
+        Logger::debug("memory allocator peak: ", peakAllocatedSize, " bytes in blocks");
+        for(auto& block : blocks)
+        {
+            if(block->usedSize != 0)
+            {
+                Logger::warn("memory block freed while ", block->usedSize, " bytes are still in use");
+            }
+            freeBlock(block.get());
+        }
+        blocks.clear();
+        usedSize = 0;
+    }
+
+    MemoryAllocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear)
+    {
+        uint32_t memoryTypeIndex = findMemoryTypeIndex(pLogicalDevice, requirements.memoryTypeBits, properties);
+        linear = linear && separateLinear;
+        VkDeviceSize size = alignUp(std::max(requirements.size, VkDeviceSize(1)), granularity);
+        VkDeviceSize alignment = std::max(requirements.alignment, granularity);
+
+        std::lock_guard<std::mutex> l(lock);
+        MemoryBlock* pBlock = nullptr;
+        MemoryRange* pRange = nullptr;
+        for(auto& block : blocks)
+        {
+            if(block->memoryTypeIndex == memoryTypeIndex && block->linear == linear && !block->dedicated)
+            {
+                pRange = block->allocate(size, alignment);
+                if(pRange != nullptr)
+                {
+                    pBlock = block.get();
+                    break;
+                }
+            }
+        }
+        if(pRange == nullptr)
+        {
+            //a fresh block is empty, so this can not fail
+            pBlock = createBlock(memoryTypeIndex, linear, size);
+            pRange = pBlock->allocate(size, alignment);
+        }
+        return makeAllocation(pBlock, pRange, requirements.size);
+    }
+
+    MemoryAllocation MemoryAllocator::allocateDedicated(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, VkImage image)
+    {
+        uint32_t memoryTypeIndex = findMemoryTypeIndex(pLogicalDevice, requirements.memoryTypeBits, properties);
+        VkDeviceSize size = alignUp(std::max(requirements.size, VkDeviceSize(1)), granularity);
+
+        std::lock_guard<std::mutex> l(lock);
+        MemoryBlock* pBlock = createBlock(memoryTypeIndex, false, size, image);
+        MemoryRange* pRange = pBlock->allocate(size, granularity);
+        return makeAllocation(pBlock, pRange, requirements.size);
+    }
+
+    MemoryAllocation MemoryAllocator::makeAllocation(MemoryBlock* pBlock, MemoryRange* pRange, VkDeviceSize size)
+    {
+        usedSize += pRange->size;
+
+        MemoryAllocation allocation;
+        allocation.memory = pBlock->memory;
+        allocation.offset = pRange->offset;
+        allocation.size = size;
+        allocation.pMappedData = pBlock->pMappedData != nullptr ? static_cast<char*>(pBlock->pMappedData) + pRange->offset : nullptr;
+        allocation.pBlock = pBlock;
+        allocation.pRange = pRange;
+        return allocation;
+    }
+
+    void MemoryAllocator::free(MemoryAllocation& allocation)
+    {
+        if(allocation.pRange == nullptr)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> l(lock);
+        usedSize -= allocation.pRange->size;
+        MemoryBlock* pBlock = allocation.pBlock;
+        pBlock->free(allocation.pRange);
+        allocation = MemoryAllocation();
+        //other blocks stay around even if they are empty now, a recreated swapchain will want the same memory again
+        //a dedicated block belongs to an image that is about to be destroyed
+        if(pBlock->dedicated)
+        {
+            freeBlock(pBlock);
+            blocks.erase(std::find_if(blocks.begin(), blocks.end(), [pBlock](const std::unique_ptr<MemoryBlock>& block) {
+                return block.get() == pBlock;
+            }));
+        }
+    }
+
+    uint32_t MemoryAllocator::getBlockCount()
+    {
+        std::lock_guard<std::mutex> l(lock);
+        return blocks.size();
+    }
+
+    VkDeviceSize MemoryAllocator::getAllocatedSize()
+    {
+        std::lock_guard<std::mutex> l(lock);
+        return allocatedSize;
+    }
+
+    VkDeviceSize MemoryAllocator::getUsedSize()
+    {
+        std::lock_guard<std::mutex> l(lock);
+        return usedSize;
+    }
+
+    VkDeviceSize MemoryAllocator::getPeakAllocatedSize()
+    {
+        std::lock_guard<std::mutex> l(lock);
+        return peakAllocatedSize;
+    }
+
+    MemoryBlock* MemoryAllocator::createBlock(uint32_t memoryTypeIndex, bool linear, VkDeviceSize minimumSize, VkImage dedicatedImage)
+    {
+        VkDeviceSize& nextBlockSize = nextBlockSizes[memoryTypeIndex];
+        //bigger resources get a block of their own size, it is recycled like every other block
+        bool exactSize = minimumSize > nextBlockSize || dedicatedImage != VK_NULL_HANDLE;
+        VkDeviceSize blockSize = exactSize ? minimumSize : nextBlockSize;
+
+        VkMemoryDedicatedAllocateInfo dedicatedAllocateInfo;
+        dedicatedAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+        dedicatedAllocateInfo.pNext = nullptr;
+        dedicatedAllocateInfo.image = dedicatedImage;
+        dedicatedAllocateInfo.buffer = VK_NULL_HANDLE;
+
+        VkMemoryAllocateInfo memoryAllocateInfo;
+        memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        memoryAllocateInfo.pNext = dedicatedImage != VK_NULL_HANDLE ? &dedicatedAllocateInfo : nullptr;
+        memoryAllocateInfo.allocationSize = blockSize;
+        memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+        VkDeviceMemory memory;
+        VkResult result = pLogicalDevice->dispatchTable.AllocateMemory(pLogicalDevice->device, &memoryAllocateInfo, nullptr, &memory);
+        if(result != VK_SUCCESS && freeEmptyBlocks())
+        {
+            result = pLogicalDevice->dispatchTable.AllocateMemory(pLogicalDevice->device, &memoryAllocateInfo, nullptr, &memory);
+        }
+        if(result != VK_SUCCESS && blockSize != minimumSize)
+        {
+            //the heap is too full for a whole block, but the resource itself might still fit
+            blockSize = minimumSize;
+            memoryAllocateInfo.allocationSize = blockSize;
+            result = pLogicalDevice->dispatchTable.AllocateMemory(pLogicalDevice->device, &memoryAllocateInfo, nullptr, &memory);
+        }
+        ASSERT_VULKAN(result);
+
+        void* pMappedData = nullptr;
+        if(pLogicalDevice->physicalDeviceInfo.memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            result = pLogicalDevice->dispatchTable.MapMemory(pLogicalDevice->device, memory, 0, VK_WHOLE_SIZE, 0, &pMappedData);
+            if(result != VK_SUCCESS)
+            {
+                pLogicalDevice->dispatchTable.FreeMemory(pLogicalDevice->device, memory, nullptr);
+            }
+            ASSERT_VULKAN(result);
+        }
+
+        if(!exactSize)
+        {
+            VkPhysicalDeviceMemoryProperties& memoryProperties = pLogicalDevice->physicalDeviceInfo.memoryProperties;
+            VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+            nextBlockSize = std::max(nextBlockSize, alignUp(std::min(std::min(nextBlockSize * 2, maxBlockSize), heapSize / 8), granularity));
+        }
+
+        blocks.emplace_back(new MemoryBlock(memory, memoryTypeIndex, linear, dedicatedImage != VK_NULL_HANDLE, blockSize, pMappedData));
+        allocatedSize += blockSize;
+        peakAllocatedSize = std::max(peakAllocatedSize, allocatedSize);
+        Logger::debug("allocated memory block of ", blockSize, " bytes in memory type ", memoryTypeIndex, ", ", blocks.size(), " blocks with ", allocatedSize, " bytes");
+        return blocks.back().get();
+    }
+
+    void MemoryAllocator::freeBlock(MemoryBlock* pBlock)
+    {
+        if(pBlock->pMappedData != nullptr)
+        {
+            pLogicalDevice->dispatchTable.UnmapMemory(pLogicalDevice->device, pBlock->memory);
+        }
+        pLogicalDevice->dispatchTable.FreeMemory(pLogicalDevice->device, pBlock->memory, nullptr);
+        allocatedSize -= pBlock->size;
+    }
+
+    bool MemoryAllocator::freeEmptyBlocks()
+    {
+        auto firstEmpty = std::stable_partition(blocks.begin(), blocks.end(), [](const std::unique_ptr<MemoryBlock>& block) {
+            return block->usedSize != 0;
+        });
+        if(firstEmpty == blocks.end())
+        {
+            return false;
+        }
+        for(auto block = firstEmpty; block != blocks.end(); block++)
+        {
+            freeBlock(block->get());
+        }
+        Logger::debug("freed ", blocks.end() - firstEmpty, " empty memory blocks");
+        blocks.erase(firstEmpty, blocks.end());
+        return true;
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef MEMORY_ALLOCATOR_HPP_INCLUDED
+#define MEMORY_ALLOCATOR_HPP_INCLUDED
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+
+#include "vulkan/vulkan.h"
+#include "vulkan/vk_layer.h"
+#include "vulkan/vk_layer_dispatch_table.h"
+
+namespace vkBasalt
+{
+    struct LogicalDevice;
+    struct MemoryBlock;
+    struct MemoryRange;
+
+    //a part of a device memory block, memory and offset are what vkBind*Memory wants
+    struct MemoryAllocation
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void* pMappedData = nullptr;//only for host visible memory, already offset
+        MemoryBlock* pBlock = nullptr;
+        MemoryRange* pRange = nullptr;
+    };
+
+    /*
+       sub-allocator for all images and buffers of the layer
+
+       device memory is allocated in big blocks per memory type and the resources are placed in them with TLSF,
+       free ranges are kept in buckets by size (log2 for the first level, 4 linear steps for the second)
+       so finding a fitting range and merging neighbors on free are constant time
+
+       if the device has a bufferImageGranularity > 1, linear resources (buffers) and optimal images get separate blocks,
+       so they never end up next to each other on the same granularity page
+
+       empty blocks are kept, so the resources of a recreated swapchain go back into the blocks the old one used,
+       they are only freed when the device is destroyed or when a new block does not fit into the heap anymore
+
+       host visible blocks are mapped once when they are created
+
+       images the driver wants a dedicated allocation for get a block that only they can use
+    */
+    class MemoryAllocator
+    {
+    public:
+        MemoryAllocator();
+        ~MemoryAllocator();
+        MemoryAllocator(const MemoryAllocator&) = delete;
+        MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+        void init(LogicalDevice* pLogicalDevice);
+        //frees every block, all allocations must be freed before
+        void destroy();
+
+        //linear is true for buffers and linear images, throws if there is no memory left
+        MemoryAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear);
+        //a VkDeviceMemory of its own for image, for drivers that prefer it, it is freed as soon as the allocation is
+        MemoryAllocation allocateDedicated(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, VkImage image);
+        void free(MemoryAllocation& allocation);
+
+        uint32_t getBlockCount();
+        VkDeviceSize getAllocatedSize();
+        VkDeviceSize getUsedSize();
+        VkDeviceSize getPeakAllocatedSize();
+
+    private:
+        LogicalDevice* pLogicalDevice;
+        bool separateLinear;
+        std::vector<std::unique_ptr<MemoryBlock>> blocks;
+        std::vector<VkDeviceSize> nextBlockSizes;//per memory type, grows with every block
+        VkDeviceSize allocatedSize;
+        VkDeviceSize usedSize;
+        VkDeviceSize peakAllocatedSize;
+        std::mutex lock;
+
+        MemoryBlock* createBlock(uint32_t memoryTypeIndex, bool linear, VkDeviceSize minimumSize, VkImage dedicatedImage = VK_NULL_HANDLE);
+        MemoryAllocation makeAllocation(MemoryBlock* pBlock, MemoryRange* pRange, VkDeviceSize size);
+        void freeBlock(MemoryBlock* pBlock);
+        bool freeEmptyBlocks();
+    };
+}
+
+#endif // MEMORY_ALLOCATOR_HPP_INCLUDED
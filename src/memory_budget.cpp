@@ -0,0 +1,163 @@
+#include "memory_budget.hpp"
+#include "memory.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+
+namespace vkBasalt
+{
+    namespace
+    {
+        constexpr VkDeviceSize mebibyte = 1024 * 1024;
+        //the lut texture and the smaa area and search textures do not depend on the swapchain
+        constexpr VkDeviceSize lutSize = 64 * 64 * 64 * 4;
+        constexpr VkDeviceSize smaaTextureSize = 160 * 560 * 2 + 64 * 16;
+
+        VkDeviceSize getBytesPerPixel(VkFormat format)
+        {
+            return format == VK_FORMAT_R16G16B16A16_SFLOAT ? 8 : 4;
+        }
+
+        //the memory an effect needs apart from the images of the chain
+        VkDeviceSize estimateEffectSize(const std::string& effect, VkDeviceSize pixelCount, uint32_t slotCount, bool compactSmaaEdges)
+        {
+            if(effect == "smaa")
+            {
+                return slotCount * pixelCount * ((compactSmaaEdges ? 2 : 4) + 4) + smaaTextureSize;
+            }
+            if(effect == "lut")
+            {
+                return lutSize;
+            }
+            return 0;
+        }
+
+        VkDeviceSize estimatePlanSize(const SwapchainMemoryPlan& plan, VkExtent2D extent, VkFormat format, uint32_t imageCount, uint32_t slotCount)
+        {
+            VkDeviceSize pixelCount = (VkDeviceSize) extent.width * extent.height;
+            VkDeviceSize imageSize = pixelCount * getBytesPerPixel(format);
+            uint32_t intermediateSetCount = std::min<uint32_t>(plan.effectStrings.size() - 1, 2);
+            VkDeviceSize size = imageSize * imageCount;
+            size += imageSize * intermediateSetCount * (plan.sharedIntermediates ? 1 : imageCount);
+            //the scratch images of all effects share their memory, so only the biggest counts
+            VkDeviceSize scratchSize = 0;
+            bool smaa = false;
+            bool lut = false;
+            for(const std::string& effect : plan.effectStrings)
+            {
+                smaa |= effect == "smaa";
+                lut |= effect == "lut";
+            }
+            if(smaa)
+            {
+                scratchSize = estimateEffectSize("smaa", pixelCount, slotCount, plan.compactSmaaEdges);
+            }
+            if(lut)
+            {
+                size += lutSize;
+            }
+            return size + scratchSize;
+        }
+    }
+
+    bool queryMemoryBudget(LogicalDevice* pLogicalDevice, VkDeviceSize& budget, VkDeviceSize& usage)
+    {
+        if(!pLogicalDevice->memoryBudget)
+        {
+            return false;
+        }
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+        budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+        budgetProperties.pNext = nullptr;
+        VkPhysicalDeviceMemoryProperties2 memoryProperties = {};
+        memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        memoryProperties.pNext = &budgetProperties;
+        pLogicalDevice->instanceDispatchTable.GetPhysicalDeviceMemoryProperties2(pLogicalDevice->physicalDevice, &memoryProperties);
+
+        uint32_t memoryTypeIndex = findMemoryTypeIndex(pLogicalDevice, ~0u, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        uint32_t heapIndex = memoryProperties.memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+        budget = budgetProperties.heapBudget[heapIndex];
+        usage = budgetProperties.heapUsage[heapIndex];
+        return true;
+    }
+
+    SwapchainMemoryPlan planSwapchainMemory(LogicalDevice* pLogicalDevice,
+                                            const std::vector<std::string>& effectStrings,
+                                            VkExtent2D extent,
+                                            VkFormat format,
+                                            uint32_t imageCount,
+                                            VkDeviceSize oldSwapchainSize)
+    {
+        SwapchainMemoryPlan plan;
+        plan.effectStrings = effectStrings;
+        plan.sharedIntermediates = false;
+        plan.compactSmaaEdges = false;
+
+        VkDeviceSize budget;
+        VkDeviceSize usage;
+        if(effectStrings.empty() || !queryMemoryBudget(pLogicalDevice, budget, usage))
+        {
+            return plan;
+        }
+        //free space in the blocks of the layer counts as well, a recreated swapchain gets it back first
+        VkDeviceSize reusable = pLogicalDevice->memoryAllocator.getAllocatedSize() - pLogicalDevice->memoryAllocator.getUsedSize();
+        VkDeviceSize available = (budget > usage ? budget - usage : 0) + reusable + oldSwapchainSize;
+        uint32_t slotCount = pLogicalDevice->transientImagePool.getSlotCount(imageCount);
+        VkDeviceSize pixelCount = (VkDeviceSize) extent.width * extent.height;
+
+        VkDeviceSize size = estimatePlanSize(plan, extent, format, imageCount, slotCount);
+        Logger::debug("memory budget ", budget / mebibyte, " MiB, used ", usage / mebibyte, " MiB, the effects need about ", size / mebibyte, " MiB");
+        if(size <= available)
+        {
+            return plan;
+        }
+
+        //sharing needs the frames to run one after another, the same condition as for a single transient slot
+        if(plan.effectStrings.size() > 1 && slotCount == 1)
+        {
+            plan.sharedIntermediates = true;
+            size = estimatePlanSize(plan, extent, format, imageCount, slotCount);
+            Logger::info("memory budget: sharing the intermediate images between the swapchain images, about ", size / mebibyte, " MiB left");
+            if(size <= available)
+            {
+                return plan;
+            }
+        }
+
+        VkFormat compactEdgeFormat = pLogicalDevice->physicalDeviceInfo.findSupportedFormat({VK_FORMAT_R8G8_UNORM},
+                                                                                            VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+        if(std::count(plan.effectStrings.begin(), plan.effectStrings.end(), "smaa") && compactEdgeFormat != VK_FORMAT_UNDEFINED)
+        {
+            plan.compactSmaaEdges = true;
+            size = estimatePlanSize(plan, extent, format, imageCount, slotCount);
+            Logger::info("memory budget: smaa edges in a two channel format, about ", size / mebibyte, " MiB left");
+            if(size <= available)
+            {
+                return plan;
+            }
+        }
+
+        while(plan.effectStrings.size() > 1)
+        {
+            //of the most expensive effects the one furthest down the chain goes, fxaa, cas and deband only cost their intermediates
+            auto mostExpensive = plan.effectStrings.begin();
+            for(auto effect = plan.effectStrings.begin(); effect != plan.effectStrings.end(); effect++)
+            {
+                if(estimateEffectSize(*effect, pixelCount, slotCount, plan.compactSmaaEdges) >= estimateEffectSize(*mostExpensive, pixelCount, slotCount, plan.compactSmaaEdges))
+                {
+                    mostExpensive = effect;
+                }
+            }
+            Logger::info("memory budget: dropping the effect ", *mostExpensive);
+            plan.effectStrings.erase(mostExpensive);
+            size = estimatePlanSize(plan, extent, format, imageCount, slotCount);
+            if(size <= available)
+            {
+                return plan;
+            }
+        }
+
+        Logger::warn("memory budget: the effects need about ", size / mebibyte, " MiB, only ", available / mebibyte, " MiB are available");
+        return plan;
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef MEMORY_BUDGET_HPP_INCLUDED
+#define MEMORY_BUDGET_HPP_INCLUDED
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "vulkan/vulkan.h"
+#include "vulkan/vk_layer.h"
+#include "vulkan/vk_layer_dispatch_table.h"
+
+#include "logical_device.hpp"
+
+namespace vkBasalt
+{
+    //what the layer decided to create for one swapchain
+    struct SwapchainMemoryPlan
+    {
+        std::vector<std::string> effectStrings;//the configured chain without the dropped effects
+        bool sharedIntermediates;//one image per intermediate set instead of one per swapchain image
+        bool compactSmaaEdges;//smaa edges in a two channel format
+    };
+
+    //budget and usage of the heap the layer puts its images in, returns false without VK_EXT_memory_budget
+    bool queryMemoryBudget(LogicalDevice* pLogicalDevice, VkDeviceSize& budget, VkDeviceSize& usage);
+
+    /*
+       estimates what the effects of a swapchain will allocate and steps down until it fits into the budget:
+       first the intermediates are shared between the swapchain images, then the smaa edges get a smaller format,
+       then the effect with the biggest images is dropped, as long as one effect is left
+       without a known budget the plan is the configured chain
+       oldSwapchainSize is the memory of the fake images of the swapchain that gets replaced,
+       it is still part of the heap usage, but it is freed when the application destroys the old swapchain
+    */
+    SwapchainMemoryPlan planSwapchainMemory(LogicalDevice* pLogicalDevice,
+                                            const std::vector<std::string>& effectStrings,
+                                            VkExtent2D extent,
+                                            VkFormat format,
+                                            uint32_t imageCount,
+                                            VkDeviceSize oldSwapchainSize);
+}
+
+#endif // MEMORY_BUDGET_HPP_INCLUDED
@@ -0,0 +1,106 @@
+#include "object_cache.hpp"
+#include "logical_device.hpp"
+#include "logger.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+namespace vkBasalt
+{
+    ObjectCache::ObjectCache()
+        : pLogicalDevice(nullptr),
+          reuseCount(0)
+    {
+    }
+
+    void ObjectCache::init(LogicalDevice* pLogicalDevice)
+    {
+        this->pLogicalDevice = pLogicalDevice;
+    }
+
+    void ObjectCache::destroy()
+    {
+        std::lock_guard<std::mutex> l(lock);
+        if(!keys.empty())
+        {
+            Logger::warn(keys.size(), " cached objects were not released");
+        }
+        for(auto& key : keys)
+        {
+            destroyObject(key.first.first, key.first.second);
+        }
+        keys.clear();
+        entries.clear();
+        Logger::debug("object cache reused objects ", reuseCount, " times");
+    }
+
+    ObjectCache::Entry* ObjectCache::reuseEntry(const std::string& typedKey, const void* pContent, size_t contentSize)
+    {
+        auto entryList = entries.find(typedKey);
+        if(entryList == entries.end())
+        {
+            return nullptr;
+        }
+        for(Entry& entry : entryList->second)
+        {
+            if(pContent == nullptr
+               || (entry.contentSize == contentSize && (entry.pContent == pContent || std::memcmp(entry.pContent, pContent, contentSize) == 0)))
+            {
+                entry.refCount++;
+                reuseCount++;
+                return &entry;
+            }
+        }
+        Logger::debug("object cache hash collision");
+        return nullptr;
+    }
+
+    void ObjectCache::releaseObject(CachedType type, uint64_t handle)
+    {
+        if(handle == 0)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> l(lock);
+        auto key = keys.find(std::make_pair(type, handle));
+        if(key == keys.end())
+        {
+            Logger::err("released an object that is not in the object cache");
+            return;
+        }
+        auto entryList = entries.find(key->second);
+        std::vector<Entry>& entryVector = entryList->second;
+        auto entry = std::find_if(entryVector.begin(), entryVector.end(), [handle](const Entry& e){return e.handle == handle;});
+        if(--entry->refCount != 0)
+        {
+            return;
+        }
+        destroyObject(type, handle);
+        entryVector.erase(entry);
+        if(entryVector.empty())
+        {
+            entries.erase(entryList);
+        }
+        keys.erase(key);
+    }
+
+    void ObjectCache::destroyObject(CachedType type, uint64_t handle)
+    {
+        VkDevice device = pLogicalDevice->device;
+        switch(type)
+        {
+            case CachedType::ShaderModule:
+                pLogicalDevice->dispatchTable.DestroyShaderModule(device, (VkShaderModule) handle, nullptr);
+                break;
+            case CachedType::Sampler:
+                pLogicalDevice->dispatchTable.DestroySampler(device, (VkSampler) handle, nullptr);
+                break;
+            case CachedType::RenderPass:
+                pLogicalDevice->dispatchTable.DestroyRenderPass(device, (VkRenderPass) handle, nullptr);
+                break;
+            case CachedType::DescriptorSetLayout:
+                pLogicalDevice->dispatchTable.DestroyDescriptorSetLayout(device, (VkDescriptorSetLayout) handle, nullptr);
+                break;
+        }
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef OBJECT_CACHE_HPP_INCLUDED
+#define OBJECT_CACHE_HPP_INCLUDED
+#include <string>
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <mutex>
+#include <cstdint>
+
+#include "vulkan/vulkan.h"
+#include "vulkan/vk_layer.h"
+#include "vulkan/vk_layer_dispatch_table.h"
+
+namespace vkBasalt
+{
+    struct LogicalDevice;
+
+    enum class CachedType : uint32_t
+    {
+        ShaderModule = 0,
+        Sampler,
+        RenderPass,
+        DescriptorSetLayout
+    };
+
+    //appends the bytes of a plain value to the key of a cached object
+    //structs with padding have to be added field by field, the padding is not initialized
+    template<typename T>
+    void appendKey(std::string& key, const T& value)
+    {
+        key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    /*
+       the objects every effect would otherwise create for itself, shared by everything on the device that has the same content
+
+       the key is the content of the create info, so two effects of one chain, two swapchains
+       or an effect and its recreation get the same object
+       a key can also be a hash of a big content, like the SPIR-V of a shader module, the content is then compared on a hit
+       and a different content with the same hash gets its own entry next to it
+       every acquire has to be matched by a release, the last release destroys the object
+    */
+    class ObjectCache
+    {
+    public:
+        ObjectCache();
+        ObjectCache(const ObjectCache&) = delete;
+        ObjectCache& operator=(const ObjectCache&) = delete;
+
+        void init(LogicalDevice* pLogicalDevice);
+        //destroys what was not released and logs how many objects were shared
+        void destroy();
+
+        //create only runs if there is no object with this key yet, it is called without the cache locked,
+        //so effects built at the same time do not wait for each other's objects
+        //if two threads create the same object, the one that comes second destroys its own and takes the other
+        //pContent is what a hashed key was made from, it has to stay alive as long as the object is cached
+        template<typename T, typename F>
+        T acquire(CachedType type, const std::string& key, F create, const void* pContent = nullptr, size_t contentSize = 0)
+        {
+            std::string typedKey = std::string(1, (char) type) + key;
+            {
+                std::lock_guard<std::mutex> l(lock);
+                if(Entry* pEntry = reuseEntry(typedKey, pContent, contentSize))
+                {
+                    return (T) pEntry->handle;
+                }
+            }
+            T handle = create();
+            std::lock_guard<std::mutex> l(lock);
+            if(Entry* pEntry = reuseEntry(typedKey, pContent, contentSize))
+            {
+                destroyObject(type, (uint64_t) handle);
+                return (T) pEntry->handle;
+            }
+            entries[typedKey].push_back({(uint64_t) handle, 1, pContent, contentSize});
+            keys[std::make_pair(type, (uint64_t) handle)] = typedKey;
+            return handle;
+        }
+        //VK_NULL_HANDLE is ignored, so states that were never built can release everything
+        template<typename T>
+        void release(CachedType type, T handle)
+        {
+            releaseObject(type, (uint64_t) handle);
+        }
+
+    private:
+        struct Entry
+        {
+            uint64_t handle;
+            uint32_t refCount;
+            const void* pContent;//nullptr if the key is the content itself
+            size_t contentSize;
+        };
+        LogicalDevice* pLogicalDevice;
+        std::unordered_map<std::string, std::vector<Entry>> entries;//by the type followed by the key, more than one on a hash collision
+        std::map<std::pair<CachedType, uint64_t>, std::string> keys;//to find the entry of a released handle
+        uint32_t reuseCount;
+        std::mutex lock;//guards entries, keys and reuseCount
+
+        //counts a reference to the entry with this key and content if there is one, otherwise returns nullptr
+        //the caller holds lock
+        Entry* reuseEntry(const std::string& typedKey, const void* pContent, size_t contentSize);
+        void releaseObject(CachedType type, uint64_t handle);
+        void destroyObject(CachedType type, uint64_t handle);
+    };
+}
+
+#endif // OBJECT_CACHE_HPP_INCLUDED
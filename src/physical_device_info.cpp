@@ -0,0 +1,60 @@
+#include "physical_device_info.hpp"
+#include "logger.hpp"
+
+namespace vkBasalt
+{
+    namespace
+    {
+        //formats the effects use for their own images, followed by common swapchain formats
+        const VkFormat capturedFormats[] = {
+            VK_FORMAT_R8_UNORM,
+            VK_FORMAT_R8G8_UNORM,
+            VK_FORMAT_R8G8B8A8_UNORM,
+            VK_FORMAT_R8G8B8A8_SRGB,
+            VK_FORMAT_B8G8R8A8_UNORM,
+            VK_FORMAT_B8G8R8A8_SRGB,
+            VK_FORMAT_A2B10G10R10_UNORM_PACK32,
+            VK_FORMAT_A2R10G10B10_UNORM_PACK32,
+            VK_FORMAT_R16G16B16A16_SFLOAT,
+        };
+    }
+
+    VkFormatProperties PhysicalDeviceInfo::getFormatProperties(VkFormat format) const
+    {
+        auto iter = formatProperties.find((uint32_t) format);
+        if(iter == formatProperties.end())
+        {
+            return VkFormatProperties{0, 0, 0};
+        }
+        return iter->second;
+    }
+
+    VkFormat PhysicalDeviceInfo::findSupportedFormat(const std::vector<VkFormat>& candidates, VkFormatFeatureFlags features) const
+    {
+        for(VkFormat format : candidates)
+        {
+            if((getFormatProperties(format).optimalTilingFeatures & features) == features)
+            {
+                return format;
+            }
+        }
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    void capturePhysicalDeviceInfo(VkLayerInstanceDispatchTable& instanceDispatchTable, VkPhysicalDevice physicalDevice, PhysicalDeviceInfo& physicalDeviceInfo)
+    {
+        instanceDispatchTable.GetPhysicalDeviceProperties(physicalDevice, &physicalDeviceInfo.properties);
+        instanceDispatchTable.GetPhysicalDeviceMemoryProperties(physicalDevice, &physicalDeviceInfo.memoryProperties);
+
+        uint32_t count = 0;
+        instanceDispatchTable.GetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, nullptr);
+        physicalDeviceInfo.queueFamilyProperties.resize(count);
+        instanceDispatchTable.GetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, physicalDeviceInfo.queueFamilyProperties.data());
+
+        for(VkFormat format : capturedFormats)
+        {
+            instanceDispatchTable.GetPhysicalDeviceFormatProperties(physicalDevice, format, &physicalDeviceInfo.formatProperties[(uint32_t) format]);
+        }
+        Logger::debug("captured physical device info of ", physicalDeviceInfo.properties.deviceName);
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef PHYSICAL_DEVICE_INFO_HPP_INCLUDED
+#define PHYSICAL_DEVICE_INFO_HPP_INCLUDED
+#include <vector>
+#include <string>
+#include <iostream>
+#include <unordered_map>
+
+#include "vulkan/vulkan.h"
+#include "vulkan/vk_layer.h"
+#include "vulkan/vk_layer_dispatch_table.h"
+
+namespace vkBasalt
+{
+    /*
+       snapshot of everything the layer wants to know about a physical device
+       it is queried once in vkCreateDevice and never changes afterwards,
+       so it can be read from any thread without going down the chain again
+
+       the limits are part of properties
+       format properties are captured for the formats the layer itself creates images in
+       and for the usual swapchain formats
+    */
+    struct PhysicalDeviceInfo
+    {
+        VkPhysicalDeviceProperties properties;
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        std::vector<VkQueueFamilyProperties> queueFamilyProperties;
+        std::unordered_map<uint32_t, VkFormatProperties> formatProperties;//key is the VkFormat
+
+        //returns an empty VkFormatProperties for formats that were not captured
+        VkFormatProperties getFormatProperties(VkFormat format) const;
+        //returns the first candidate with all features for optimal tiling, VK_FORMAT_UNDEFINED if none has them
+        VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkFormatFeatureFlags features) const;
+    };
+
+    void capturePhysicalDeviceInfo(VkLayerInstanceDispatchTable& instanceDispatchTable, VkPhysicalDevice physicalDevice, PhysicalDeviceInfo& physicalDeviceInfo);
+}
+
+
+#endif // PHYSICAL_DEVICE_INFO_HPP_INCLUDED
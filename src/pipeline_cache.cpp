@@ -0,0 +1,232 @@
+#include "pipeline_cache.hpp"
+#include "logical_device.hpp"
+#include "logger.hpp"
+
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iterator>
+#include <unistd.h>
+#include <fcntl.h>
+#if __GNUC__ == 7
+#include <experimental/filesystem>
+#define filesystem experimental::filesystem
+#else
+#include <filesystem>
+#endif
+
+namespace vkBasalt
+{
+    namespace
+    {
+        //VkPipelineCacheHeaderVersionOne, read field by field so the layout of the struct does not matter
+        constexpr size_t headerSize = 16 + VK_UUID_SIZE;
+
+        uint32_t readUint32(const std::string& data, size_t offset)
+        {
+            uint32_t value;
+            std::memcpy(&value, data.data() + offset, sizeof(value));
+            return value;
+        }
+
+        std::string getCacheDirectory()
+        {
+            //the base directory spec says to ignore a relative XDG_CACHE_HOME, an empty one counts as unset
+            const char* tmpCacheEnv = std::getenv("XDG_CACHE_HOME");
+            if(tmpCacheEnv && tmpCacheEnv[0] == '/')
+            {
+                return std::string(tmpCacheEnv) + "/vkBasalt";
+            }
+            const char* tmpHomeEnv = std::getenv("HOME");
+            return tmpHomeEnv && tmpHomeEnv[0] == '/' ? std::string(tmpHomeEnv) + "/.cache/vkBasalt" : "";
+        }
+
+        //the data has to be on disk before the rename, otherwise a crash can leave an empty file under the real name
+        bool writeFileSynced(const std::string& path, const std::string& data)
+        {
+            int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if(fd < 0)
+            {
+                return false;
+            }
+            size_t written = 0;
+            while(written < data.size())
+            {
+                ssize_t count = write(fd, data.data() + written, data.size() - written);
+                if(count < 0)
+                {
+                    close(fd);
+                    return false;
+                }
+                written += count;
+            }
+            bool synced = fsync(fd) == 0;
+            return close(fd) == 0 && synced;
+        }
+
+        //makes the rename itself durable, a failure only means the old cache may come back after a crash
+        void syncDirectory(const std::string& path)
+        {
+            int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if(fd < 0)
+            {
+                return;
+            }
+            fsync(fd);
+            close(fd);
+        }
+    }
+
+    PipelineCache::PipelineCache()
+        : pLogicalDevice(nullptr),
+          pipelineCache(VK_NULL_HANDLE),
+          warm(false),
+          pipelineCount(0),
+          creationTime(std::chrono::steady_clock::duration::zero())
+    {
+    }
+
+    void PipelineCache::init(LogicalDevice* pLogicalDevice)
+    {
+        this->pLogicalDevice = pLogicalDevice;
+        const VkPhysicalDeviceProperties& properties = pLogicalDevice->physicalDeviceInfo.properties;
+
+        std::string cacheDirectory = getCacheDirectory();
+        std::string data;
+        if(!cacheDirectory.empty())
+        {
+            std::stringstream fileName;
+            fileName << std::hex << std::setfill('0')
+                     << "pipeline_cache_" << std::setw(4) << properties.vendorID
+                     << "_" << std::setw(4) << properties.deviceID
+                     << "_" << std::setw(8) << properties.driverVersion << "_";
+            for(uint32_t i=0;i<VK_UUID_SIZE;i++)
+            {
+                fileName << std::setw(2) << (uint32_t) properties.pipelineCacheUUID[i];
+            }
+            fileName << ".bin";
+            filePath = cacheDirectory + "/" + fileName.str();
+
+            std::ifstream file(filePath, std::ios::binary);
+            if(file)
+            {
+                data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            }
+            if(!data.empty() && !isValid(data))
+            {
+                Logger::warn("ignoring pipeline cache with a foreign header: ", filePath);
+                data.clear();
+            }
+        }
+
+        VkPipelineCacheCreateInfo pipelineCacheCreateInfo;
+        pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        pipelineCacheCreateInfo.pNext = nullptr;
+        pipelineCacheCreateInfo.flags = 0;
+        pipelineCacheCreateInfo.initialDataSize = data.size();
+        pipelineCacheCreateInfo.pInitialData = data.data();
+
+        VkResult result = pLogicalDevice->dispatchTable.CreatePipelineCache(pLogicalDevice->device, &pipelineCacheCreateInfo, nullptr, &pipelineCache);
+        if(result != VK_SUCCESS && !data.empty())
+        {
+            //the driver is allowed to refuse the data, start empty instead
+            data.clear();
+            pipelineCacheCreateInfo.initialDataSize = 0;
+            pipelineCacheCreateInfo.pInitialData = nullptr;
+            result = pLogicalDevice->dispatchTable.CreatePipelineCache(pLogicalDevice->device, &pipelineCacheCreateInfo, nullptr, &pipelineCache);
+        }
+        if(result != VK_SUCCESS)
+        {
+            Logger::warn("could not create a pipeline cache: ", result);
+            pipelineCache = VK_NULL_HANDLE;
+            return;
+        }
+        warm = !data.empty();
+        Logger::debug("pipeline cache ", filePath, (warm ? " loaded, " : " is empty, "), data.size(), " bytes");
+    }
+
+    void PipelineCache::destroy()
+    {
+        if(pipelineCache == VK_NULL_HANDLE)
+        {
+            return;
+        }
+        if(pipelineCount != 0)
+        {
+            std::chrono::duration<double, std::milli> milliseconds = creationTime;
+            Logger::info(pipelineCount, " pipelines created in ", milliseconds.count(), " ms with a ", (warm ? "warm" : "cold"), " pipeline cache");
+            save();
+        }
+        pLogicalDevice->dispatchTable.DestroyPipelineCache(pLogicalDevice->device, pipelineCache, nullptr);
+        pipelineCache = VK_NULL_HANDLE;
+    }
+
+    VkPipelineCache PipelineCache::getHandle()
+    {
+        return pipelineCache;
+    }
+
+    void PipelineCache::reportCreation(std::chrono::steady_clock::duration duration)
+    {
+        std::chrono::duration<double, std::milli> milliseconds = duration;
+        Logger::debug("pipeline created in ", milliseconds.count(), " ms, ", (warm ? "warm" : "cold"), " cache");
+        std::lock_guard<std::mutex> l(lock);
+        pipelineCount++;
+        creationTime += duration;
+    }
+
+    bool PipelineCache::isValid(const std::string& data)
+    {
+        const VkPhysicalDeviceProperties& properties = pLogicalDevice->physicalDeviceInfo.properties;
+        return data.size() >= headerSize
+            && readUint32(data, 0) >= headerSize
+            && readUint32(data, 0) <= data.size()
+            && readUint32(data, 4) == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            && readUint32(data, 8) == properties.vendorID
+            && readUint32(data, 12) == properties.deviceID
+            && std::memcmp(data.data() + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    void PipelineCache::save()
+    {
+        if(filePath.empty())
+        {
+            return;
+        }
+        size_t size = 0;
+        VkResult result = pLogicalDevice->dispatchTable.GetPipelineCacheData(pLogicalDevice->device, pipelineCache, &size, nullptr);
+        std::string data(size, '\0');
+        if(result == VK_SUCCESS)
+        {
+            result = pLogicalDevice->dispatchTable.GetPipelineCacheData(pLogicalDevice->device, pipelineCache, &size, &data[0]);
+        }
+        data.resize(size);
+        if(result != VK_SUCCESS || !isValid(data))
+        {
+            Logger::warn("not saving the pipeline cache, the driver returned ", result, " and ", size, " bytes");
+            return;
+        }
+
+        std::error_code error;
+        std::string directory = std::filesystem::path(filePath).parent_path().string();
+        std::filesystem::create_directories(directory, error);
+        //every process writes its own temporary file, the rename replaces the old cache in one step
+        std::string tmpPath = filePath + ".tmp" + std::to_string(getpid());
+        if(!writeFileSynced(tmpPath, data))
+        {
+            Logger::warn("could not write the pipeline cache to ", tmpPath);
+            std::remove(tmpPath.c_str());
+            return;
+        }
+        if(std::rename(tmpPath.c_str(), filePath.c_str()) != 0)
+        {
+            Logger::warn("could not replace the pipeline cache ", filePath);
+            std::remove(tmpPath.c_str());
+            return;
+        }
+        syncDirectory(directory);
+        Logger::debug("saved ", data.size(), " bytes of pipeline cache to ", filePath);
+    }
+}
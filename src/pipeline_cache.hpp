@@ -0,0 +1,55 @@
+#ifndef PIPELINE_CACHE_HPP_INCLUDED
+#define PIPELINE_CACHE_HPP_INCLUDED
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+#include "vulkan/vulkan.h"
+#include "vulkan/vk_layer.h"
+#include "vulkan/vk_layer_dispatch_table.h"
+
+namespace vkBasalt
+{
+    struct LogicalDevice;
+
+    /*
+       the VkPipelineCache every pipeline of the layer is created with, kept on disk between runs
+
+       the file lives in $XDG_CACHE_HOME/vkBasalt (~/.cache/vkBasalt if it is unset or not absolute) and is named after the vendor, device,
+       driver version and pipelineCacheUUID, so a driver update starts a new file instead of feeding the driver stale data
+       the header of the data is checked against the device before loading and before saving,
+       and the file is written and synced under a temporary name and renamed, so a crash never leaves half a cache behind
+    */
+    class PipelineCache
+    {
+    public:
+        PipelineCache();
+        PipelineCache(const PipelineCache&) = delete;
+        PipelineCache& operator=(const PipelineCache&) = delete;
+
+        void init(LogicalDevice* pLogicalDevice);
+        //saves the cache if pipelines were created since it was loaded, then destroys it
+        void destroy();
+
+        //VK_NULL_HANDLE if the driver could not create a cache
+        VkPipelineCache getHandle();
+        //accounts the time one vkCreateGraphicsPipelines took, the totals are logged in destroy
+        void reportCreation(std::chrono::steady_clock::duration duration);
+
+    private:
+        LogicalDevice* pLogicalDevice;
+        VkPipelineCache pipelineCache;
+        std::string filePath;//empty if there is no cache directory
+        bool warm;//the cache started with data from disk
+        uint32_t pipelineCount;
+        std::chrono::steady_clock::duration creationTime;
+        std::mutex lock;//guards pipelineCount and creationTime
+
+        //true if data starts with a VK_PIPELINE_CACHE_HEADER_VERSION_ONE header of this device that fits into it
+        bool isValid(const std::string& data);
+        void save();
+    };
+}
+
+#endif // PIPELINE_CACHE_HPP_INCLUDED
@@ -10,16 +10,14 @@
 
 namespace vkBasalt
 {
-    VkRenderPass createRenderPass(VkDevice device, VkLayerDispatchTable dispatchTable, VkFormat format)
+    VkRenderPass createRenderPass(LogicalDevice* pLogicalDevice, VkFormat format, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp)
     {
-        VkRenderPass renderPass;
-        
         VkAttachmentDescription attachmentDescription;
         attachmentDescription.flags = 0;
         attachmentDescription.format = format;
         attachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
-        attachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        attachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachmentDescription.loadOp = loadOp;
+        attachmentDescription.storeOp = storeOp;
         attachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         attachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         attachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -61,9 +59,21 @@ namespace vkBasalt
         renderPassCreateInfo.dependencyCount = 1;
         renderPassCreateInfo.pDependencies = &subpassDependency;
 
-        VkResult result = dispatchTable.CreateRenderPass(device,&renderPassCreateInfo,nullptr,&renderPass);
-        ASSERT_VULKAN(result);
-        
-        return renderPass;
+        //the subpass and the dependency are the same for every render pass of the layer, the attachment tells them apart
+        std::string key;
+        appendKey(key, attachmentDescription.format);
+        appendKey(key, attachmentDescription.samples);
+        appendKey(key, attachmentDescription.loadOp);
+        appendKey(key, attachmentDescription.storeOp);
+        appendKey(key, attachmentDescription.initialLayout);
+        appendKey(key, attachmentDescription.finalLayout);
+
+        return pLogicalDevice->objectCache.acquire<VkRenderPass>(CachedType::RenderPass, key, [&]()
+        {
+            VkRenderPass renderPass;
+            VkResult result = pLogicalDevice->dispatchTable.CreateRenderPass(pLogicalDevice->device,&renderPassCreateInfo,nullptr,&renderPass);
+            ASSERT_VULKAN(result);
+            return renderPass;
+        });
     }
 }
@@ -10,9 +10,15 @@
 #include "vulkan/vk_layer.h"
 #include "vulkan/vk_layer_dispatch_table.h"
 
+#include "logical_device.hpp"
+
 namespace vkBasalt
 {
-    VkRenderPass createRenderPass(VkDevice device, VkLayerDispatchTable dispatchTable, VkFormat format);
+    //shared through the object cache of the device, release it there instead of destroying it
+    VkRenderPass createRenderPass(LogicalDevice* pLogicalDevice,
+                                  VkFormat format,
+                                  VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                                  VkAttachmentStoreOp storeOp = VK_ATTACHMENT_STORE_OP_STORE);
 
 }
 
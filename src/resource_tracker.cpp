@@ -0,0 +1,170 @@
+#include "resource_tracker.hpp"
+#include "logger.hpp"
+
+#include <cstring>
+#include <iterator>
+
+namespace vkBasalt
+{
+    namespace
+    {
+        const char* typeNames[(uint32_t) ResourceType::Count] = {
+            "images",
+            "buffers",
+            "image views",
+            "framebuffers",
+            "pipelines",
+            "descriptor pools",
+            "memory regions"
+        };
+
+        thread_local uint64_t currentOwner = ResourceTracker::deviceOwner;
+
+        ResourceStats createStats(const std::string& name)
+        {
+            ResourceStats stats = {};
+            std::strncpy(stats.owner, name.c_str(), sizeof(stats.owner) - 1);
+            return stats;
+        }
+
+        std::string formatStats(const ResourceStats& stats)
+        {
+            std::string text;
+            VkDeviceSize size = 0;
+            for(uint32_t i=0;i<(uint32_t) ResourceType::Count;i++)
+            {
+                if(stats.counts[i] != 0)
+                {
+                    text += (text.empty() ? "" : ", ") + std::to_string(stats.counts[i]) + " " + typeNames[i];
+                }
+                size += stats.sizes[i];
+            }
+            return (text.empty() ? std::string("nothing") : text) + ", " + std::to_string(size / 1024) + " KiB";
+        }
+    }
+
+    ResourceTracker::ResourceTracker()
+        : nextOwner(deviceOwner + 1)
+    {
+        owners[deviceOwner] = createStats("device");
+    }
+
+    uint64_t ResourceTracker::createOwner(const std::string& name)
+    {
+        std::lock_guard<std::mutex> l(lock);
+        owners[nextOwner] = createStats(name);
+        return nextOwner++;
+    }
+
+    void ResourceTracker::destroyOwner(uint64_t owner)
+    {
+        std::lock_guard<std::mutex> l(lock);
+        auto ownerIt = owners.find(owner);
+        if(ownerIt == owners.end())
+        {
+            return;
+        }
+        const ResourceStats& stats = ownerIt->second;
+        uint32_t leakCount = 0;
+        for(uint32_t i=0;i<(uint32_t) ResourceType::Count;i++)
+        {
+            leakCount += stats.counts[i];
+        }
+        if(leakCount != 0)
+        {
+            Logger::warn(stats.owner, " leaked ", formatStats(stats));
+            //the objects are gone with their owner, otherwise a recreated swapchain would report them again
+            for(auto object = objects.begin(); object != objects.end();)
+            {
+                object = object->second.owner == owner ? objects.erase(object) : std::next(object);
+            }
+        }
+        if(owner != deviceOwner)
+        {
+            owners.erase(ownerIt);
+        }
+    }
+
+    std::vector<ResourceStats> ResourceTracker::getStats()
+    {
+        std::lock_guard<std::mutex> l(lock);
+        std::vector<ResourceStats> stats;
+        for(auto& owner : owners)
+        {
+            stats.push_back(owner.second);
+        }
+        return stats;
+    }
+
+    void ResourceTracker::logStats(bool reportTotals)
+    {
+        std::vector<ResourceStats> stats = getStats();
+        ResourceStats total = createStats("total");
+        for(const ResourceStats& ownerStats : stats)
+        {
+            Logger::debug("resources of ", ownerStats.owner, ": ", formatStats(ownerStats));
+            for(uint32_t i=0;i<(uint32_t) ResourceType::Count;i++)
+            {
+                total.counts[i] += ownerStats.counts[i];
+                total.sizes[i] += ownerStats.sizes[i];
+            }
+        }
+        if(reportTotals)
+        {
+            Logger::info("vkBasalt resources: ", formatStats(total));
+        }
+        else
+        {
+            Logger::debug("vkBasalt resources: ", formatStats(total));
+        }
+    }
+
+    void ResourceTracker::addObject(ResourceType type, uint64_t handle, VkDeviceSize size)
+    {
+        uint64_t owner = ResourceScope::getCurrentOwner();
+        std::lock_guard<std::mutex> l(lock);
+        auto ownerIt = owners.find(owner);
+        if(ownerIt == owners.end())
+        {
+            //the owner is already gone, the device keeps the object
+            owner = deviceOwner;
+            ownerIt = owners.find(owner);
+        }
+        objects[std::make_pair(type, handle)] = {owner, size};
+        ownerIt->second.counts[(uint32_t) type]++;
+        ownerIt->second.sizes[(uint32_t) type] += size;
+    }
+
+    void ResourceTracker::removeObject(ResourceType type, uint64_t handle)
+    {
+        std::lock_guard<std::mutex> l(lock);
+        auto object = objects.find(std::make_pair(type, handle));
+        if(object == objects.end())
+        {
+            return;
+        }
+        auto ownerIt = owners.find(object->second.owner);
+        if(ownerIt != owners.end())
+        {
+            ownerIt->second.counts[(uint32_t) type]--;
+            ownerIt->second.sizes[(uint32_t) type] -= object->second.size;
+        }
+        objects.erase(object);
+    }
+
+    ResourceScope::ResourceScope(uint64_t owner)
+        : previousOwner(currentOwner)
+    {
+        currentOwner = owner;
+    }
+
+    ResourceScope::~ResourceScope()
+    {
+        currentOwner = previousOwner;
+    }
+
+    uint64_t ResourceScope::getCurrentOwner()
+    {
+        return currentOwner;
+    }
+}
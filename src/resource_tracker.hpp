@@ -0,0 +1,110 @@
+#ifndef RESOURCE_TRACKER_HPP_INCLUDED
+#define RESOURCE_TRACKER_HPP_INCLUDED
+#include <vector>
+#include <string>
+#include <map>
+#include <utility>
+#include <mutex>
+#include <cstdint>
+
+#include "vulkan/vulkan.h"
+#include "vulkan/vk_layer.h"
+#include "vulkan/vk_layer_dispatch_table.h"
+
+namespace vkBasalt
+{
+    enum class ResourceType : uint32_t
+    {
+        Image = 0,
+        Buffer,
+        ImageView,
+        Framebuffer,
+        Pipeline,
+        DescriptorPool,
+        Memory,//memory that is not owned by a single image or buffer, like the transient regions
+        Count
+    };
+
+    //what one owner (an effect, the fake images of a swapchain, ...) currently has alive
+    //plain data, so it can be handed out through vkBasaltGetResourceStats
+    struct ResourceStats
+    {
+        char owner[64];
+        uint32_t counts[(uint32_t) ResourceType::Count];
+        VkDeviceSize sizes[(uint32_t) ResourceType::Count];//bytes from the memory requirements, 0 for objects without memory
+    };
+
+    /*
+       counts every object the layer creates, by the owner that created it
+
+       the create helpers add the object to the owner of the current ResourceScope,
+       whoever destroys it removes it again, so an owner that still has objects when it is destroyed leaked them
+       images in the transient regions are counted without size, the regions themselves carry the memory
+    */
+    class ResourceTracker
+    {
+    public:
+        //objects of the device itself, like staging buffers, this owner lives as long as the device
+        static constexpr uint64_t deviceOwner = 0;
+
+        ResourceTracker();
+
+        uint64_t createOwner(const std::string& name);
+        //warns about every object of the owner that is still alive
+        void destroyOwner(uint64_t owner);
+
+        template<typename T>
+        void add(ResourceType type, T handle, VkDeviceSize size = 0)
+        {
+            addObject(type, (uint64_t) handle, size);
+        }
+        template<typename T>
+        void remove(ResourceType type, T handle)
+        {
+            removeObject(type, (uint64_t) handle);
+        }
+        template<typename T>
+        void remove(ResourceType type, const std::vector<T>& handles)
+        {
+            for(const T& handle : handles)
+            {
+                removeObject(type, (uint64_t) handle);
+            }
+        }
+
+        std::vector<ResourceStats> getStats();
+        //the totals at info level if reportTotals, otherwise at debug, every owner at debug
+        void logStats(bool reportTotals);
+
+    private:
+        struct Object
+        {
+            uint64_t owner;
+            VkDeviceSize size;
+        };
+        std::map<uint64_t, ResourceStats> owners;
+        std::map<std::pair<ResourceType, uint64_t>, Object> objects;
+        uint64_t nextOwner;
+        std::mutex lock;
+
+        void addObject(ResourceType type, uint64_t handle, VkDeviceSize size);
+        void removeObject(ResourceType type, uint64_t handle);
+    };
+
+    //the objects created on this thread while the scope lives belong to owner
+    class ResourceScope
+    {
+    public:
+        explicit ResourceScope(uint64_t owner);
+        ResourceScope(const ResourceScope&) = delete;
+        ResourceScope& operator=(const ResourceScope&) = delete;
+        ~ResourceScope();
+
+        static uint64_t getCurrentOwner();
+
+    private:
+        uint64_t previousOwner;
+    };
+}
+
+#endif // RESOURCE_TRACKER_HPP_INCLUDED
@@ -10,10 +10,8 @@
 
 namespace vkBasalt
 {
-    VkSampler createSampler(VkDevice device, VkLayerDispatchTable dispatchTable)
+    VkSampler createSampler(LogicalDevice* pLogicalDevice)
     {
-        VkSampler sampler;
-        
         VkSamplerCreateInfo samplerCreateInfo;
         samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
         samplerCreateInfo.pNext = nullptr;
@@ -34,8 +32,30 @@ namespace vkBasalt
         samplerCreateInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
         samplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
         
-        VkResult result = dispatchTable.CreateSampler(device,&samplerCreateInfo,nullptr,&sampler);
-        ASSERT_VULKAN(result);
-        return sampler;
+        std::string key;
+        appendKey(key, samplerCreateInfo.flags);
+        appendKey(key, samplerCreateInfo.magFilter);
+        appendKey(key, samplerCreateInfo.minFilter);
+        appendKey(key, samplerCreateInfo.mipmapMode);
+        appendKey(key, samplerCreateInfo.addressModeU);
+        appendKey(key, samplerCreateInfo.addressModeV);
+        appendKey(key, samplerCreateInfo.addressModeW);
+        appendKey(key, samplerCreateInfo.mipLodBias);
+        appendKey(key, samplerCreateInfo.anisotropyEnable);
+        appendKey(key, samplerCreateInfo.maxAnisotropy);
+        appendKey(key, samplerCreateInfo.compareEnable);
+        appendKey(key, samplerCreateInfo.compareOp);
+        appendKey(key, samplerCreateInfo.minLod);
+        appendKey(key, samplerCreateInfo.maxLod);
+        appendKey(key, samplerCreateInfo.borderColor);
+        appendKey(key, samplerCreateInfo.unnormalizedCoordinates);
+
+        return pLogicalDevice->objectCache.acquire<VkSampler>(CachedType::Sampler, key, [&]()
+        {
+            VkSampler sampler;
+            VkResult result = pLogicalDevice->dispatchTable.CreateSampler(pLogicalDevice->device,&samplerCreateInfo,nullptr,&sampler);
+            ASSERT_VULKAN(result);
+            return sampler;
+        });
     }
 }
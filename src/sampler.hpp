@@ -9,9 +9,12 @@
 #include "vulkan/vulkan.h"
 #include "vulkan/vk_layer.h"
 #include "vulkan/vk_layer_dispatch_table.h"
+
+#include "logical_device.hpp"
 namespace vkBasalt
 {
-    VkSampler createSampler(VkDevice device, VkLayerDispatchTable dispatchTable);
+    //shared through the object cache of the device, release it there instead of destroying it
+    VkSampler createSampler(LogicalDevice* pLogicalDevice);
 }
 
 #endif // SAMPLER_HPP_INCLUDED
@@ -0,0 +1,42 @@
+#include "scratch_image.hpp"
+#include "image.hpp"
+#include "logger.hpp"
+
+namespace vkBasalt
+{
+    ScratchImage::ScratchImage(LogicalDevice* pLogicalDevice, const std::vector<VkFormat>& formats, VkExtent2D extent, VkImageUsageFlags usage, uint32_t imageCount)
+    {
+        this->pLogicalDevice = pLogicalDevice;
+        uint32_t slotCount = pLogicalDevice->transientImagePool.getSlotCount(imageCount);
+        for(uint32_t i=0;i<slotCount;i++)
+        {
+            TransientRegion* pRegion;
+            images.push_back(createTransientImages(pLogicalDevice, formats, {extent.width, extent.height, 1}, usage, i, pRegion));
+            regions.push_back(pRegion);
+        }
+        Logger::debug(formats.size(), " scratch images ", extent.width, "x", extent.height, " in ", slotCount, " slots");
+    }
+
+    ScratchImage::~ScratchImage()
+    {
+        for(uint32_t i=0;i<images.size();i++)
+        {
+            for(VkImage image : images[i])
+            {
+                pLogicalDevice->dispatchTable.DestroyImage(pLogicalDevice->device, image, nullptr);
+            }
+            pLogicalDevice->resourceTracker.remove(ResourceType::Image, images[i]);
+            pLogicalDevice->transientImagePool.release(regions[i]);
+        }
+    }
+
+    uint32_t ScratchImage::getSlotCount()
+    {
+        return images.size();
+    }
+
+    const std::vector<VkImage>& ScratchImage::getImages(uint32_t slot)
+    {
+        return images[slot];
+    }
+}
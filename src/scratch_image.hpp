@@ -0,0 +1,42 @@
+#ifndef SCRATCH_IMAGE_HPP_INCLUDED
+#define SCRATCH_IMAGE_HPP_INCLUDED
+#include <vector>
+#include <cstdint>
+
+#include "vulkan/vulkan.h"
+#include "vulkan/vk_layer.h"
+#include "vulkan/vk_layer_dispatch_table.h"
+
+#include "logical_device.hpp"
+
+namespace vkBasalt
+{
+    /*
+       images an effect only needs while it is applied, one image per format for every slot of the transient pool
+
+       the memory is aliased with the scratch images of other effects, so the render passes that write them
+       have to clear them, which createRenderPass does
+
+       every scratch image of the layer is sampled by the pass after the one that writes it (like the smaa edges),
+       so none of them could be a transient attachment in lazily allocated memory
+    */
+    class ScratchImage
+    {
+    public:
+        ScratchImage(LogicalDevice* pLogicalDevice, const std::vector<VkFormat>& formats, VkExtent2D extent, VkImageUsageFlags usage, uint32_t imageCount);
+        ScratchImage(const ScratchImage&) = delete;
+        ScratchImage& operator=(const ScratchImage&) = delete;
+        ~ScratchImage();
+
+        uint32_t getSlotCount();
+        //the images of slot imageIndex % getSlotCount()
+        const std::vector<VkImage>& getImages(uint32_t slot);
+
+    private:
+        LogicalDevice* pLogicalDevice;
+        std::vector<std::vector<VkImage>> images;//per slot
+        std::vector<TransientRegion*> regions;//per slot
+    };
+}
+
+#endif // SCRATCH_IMAGE_HPP_INCLUDED
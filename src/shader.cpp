@@ -1,12 +1,8 @@
 #include "shader.hpp"
+#include "logger.hpp"
 
-#include <array>
-#if __GNUC__ == 7
-#include <experimental/filesystem>
-#define filesystem experimental::filesystem
-#else
-#include <filesystem>
-#endif
+#include <map>
+#include <mutex>
 
 #ifndef ASSERT_VULKAN
 #define ASSERT_VULKAN(val)\
@@ -17,67 +13,106 @@
 #endif
 
 namespace vkBasalt{
-    std::vector<char> readFile(const std::string &filename)
+    //one entry of the table the shader makefile generates from the optimized SPIR-V
+    struct EmbeddedShader
     {
-        static std::string shaderDir;
-
-        if (shaderDir.empty()) {
-            // Custom shader directory path
-            const char* tmpShaderEnv = std::getenv("VKBASALT_SHADER_PATH");
-            std::string customShaderDir = tmpShaderEnv ? std::string(tmpShaderEnv) : "";
+        const char* name;
+        const uint32_t* pCode;
+        size_t size;//in bytes
+    };
+}
 
-            // User shader directory path
-            const char* tmpHomeEnv = std::getenv("XDG_DATA_HOME");
-            std::string userShaderDir = tmpHomeEnv
-                ? std::string(tmpHomeEnv) + "/vkBasalt/shader"
-                : std::string(std::getenv("HOME")) + "/.local/share/vkBasalt/shader";
+//embeddedShaders, generated into build/shader_include by the shader makefile
+#include "embedded_shaders.h"
 
-            // Allowed config paths
-            const std::array<std::string, 4> shaderPath = {
-                customShaderDir,                    // custom shaders (VKBASALT_SHADER_PATH=/path/to/vkBasalt/shader)
-                userShaderDir,                      // default shaders
-                "/usr/share/vkBasalt/shader",       // system-wide shaders
-                "/usr/local/share/vkBasalt/shader", // system-wide shaders (alternative)
-            };
+namespace vkBasalt{
+    namespace
+    {
+        //the files from VKBASALT_SHADER_PATH, kept for the lifetime of the layer since ShaderCode points into them
+        std::map<std::string, std::vector<uint32_t>> shaderFiles;
+        std::mutex shaderFilesLock;
 
-            for(const auto& sDir: shaderPath){
-                if (!std::filesystem::is_directory(sDir)) continue;
+        //64 bit FNV-1a over the SPIR-V words, only the key of the object cache, which compares the code on a hit
+        uint64_t hashCode(const ShaderCode& code)
+        {
+            uint64_t hash = 0xcbf29ce484222325ull;
+            for(size_t i=0;i<code.size/4;i++)
+            {
+                hash ^= code.pCode[i];
+                hash *= 0x100000001b3ull;
+            }
+            return hash;
+        }
 
-                std::cout << sDir << std::endl;
-                shaderDir = sDir + "/";
-                break;
+        //false if there is no such file, the embedded shader is used then
+        bool readShaderFile(const std::string& path, ShaderCode& code)
+        {
+            std::lock_guard<std::mutex> l(shaderFilesLock);
+            auto shaderFile = shaderFiles.find(path);
+            if(shaderFile == shaderFiles.end())
+            {
+                std::ifstream file(path, std::ios::binary | std::ios::ate);
+                if(!file)
+                {
+                    return false;
+                }
+                size_t fileSize = (size_t) file.tellg();
+                std::vector<uint32_t> fileBuffer((fileSize + 3) / 4);
+                file.seekg(0);
+                file.read(reinterpret_cast<char*>(fileBuffer.data()), fileSize);
+                shaderFile = shaderFiles.emplace(path, std::move(fileBuffer)).first;
+                Logger::debug("read shader ", path);
             }
+            code.pCode = shaderFile->second.data();
+            code.size = shaderFile->second.size() * 4;
+            return true;
         }
+    }
 
-        std::ifstream file(shaderDir + filename, std::ios::binary | std::ios::ate);
+    ShaderCode getShaderCode(const std::string& name)
+    {
+        //only for working on the shaders, a normal install never reads a shader from disk
+        static const char* shaderPath = std::getenv("VKBASALT_SHADER_PATH");
 
-        if(file)
+        ShaderCode code;
+        if(shaderPath != nullptr && readShaderFile(std::string(shaderPath) + "/" + name, code))
         {
-            size_t fileSize = (size_t) file.tellg();
-            std::vector<char> fileBuffer(fileSize);
-            file.seekg(0);
-            file.read(fileBuffer.data(),fileSize);
-            file.close();
-            return fileBuffer;
+            return code;
         }
-        else
+        for(const EmbeddedShader& embeddedShader : embeddedShaders)
         {
-            throw std::runtime_error("read file " + filename + " failed");
+            if(name == embeddedShader.name)
+            {
+                code.pCode = embeddedShader.pCode;
+                code.size = embeddedShader.size;
+                return code;
+            }
         }
+        throw std::runtime_error("shader " + name + " is not compiled into the layer");
     }
 
 
-    void createShaderModule(VkDevice device, VkLayerDispatchTable dispatchTable, const std::vector<char> &code, VkShaderModule *shaderModule)
+    void createShaderModule(LogicalDevice* pLogicalDevice, const ShaderCode& code, VkShaderModule *shaderModule)
     {
         VkShaderModuleCreateInfo shaderCreateInfo;
 
         shaderCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
         shaderCreateInfo.pNext = nullptr;
         shaderCreateInfo.flags = 0;
-        shaderCreateInfo.codeSize = code.size();
-        shaderCreateInfo.pCode = (uint32_t*) code.data();
+        shaderCreateInfo.codeSize = code.size;
+        shaderCreateInfo.pCode = code.pCode;
 
-        VkResult result = dispatchTable.CreateShaderModule(device,&shaderCreateInfo,nullptr,shaderModule);
-        ASSERT_VULKAN(result);
+        //the effects share their modules by the SPIR-V, e.g. every effect uses the same full screen triangle
+        //the code lives as long as the layer, so the cache can compare it instead of keeping a copy in the key
+        std::string key;
+        appendKey(key, hashCode(code));
+        appendKey(key, code.size);
+        *shaderModule = pLogicalDevice->objectCache.acquire<VkShaderModule>(CachedType::ShaderModule, key, [&]()
+        {
+            VkShaderModule module;
+            VkResult result = pLogicalDevice->dispatchTable.CreateShaderModule(pLogicalDevice->device,&shaderCreateInfo,nullptr,&module);
+            ASSERT_VULKAN(result);
+            return module;
+        }, code.pCode, code.size);
     }
 }
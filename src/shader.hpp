@@ -6,15 +6,27 @@
 #include <iostream>
 #include <vector>
 #include <cstdlib>
+#include <cstdint>
 
 #include "vulkan/vulkan.h"
 #include "vulkan/vk_layer.h"
 #include "vulkan/vk_layer_dispatch_table.h"
 
+#include "logical_device.hpp"
+
 
 namespace vkBasalt{
-    std::vector<char> readFile(const std::string &filename);
-    void createShaderModule(VkDevice device, VkLayerDispatchTable dispatchTable, const std::vector<char> &code, VkShaderModule *shaderModule);
+    //the SPIR-V of one shader, points into the layer binary or into a file that was read once and is kept
+    struct ShaderCode
+    {
+        const uint32_t* pCode;
+        size_t size;//in bytes
+    };
+
+    //the shader compiled into the layer, or the file of the same name in VKBASALT_SHADER_PATH if that is set
+    ShaderCode getShaderCode(const std::string& name);
+    //shared through the object cache of the device, release it there instead of destroying it
+    void createShaderModule(LogicalDevice* pLogicalDevice, const ShaderCode& code, VkShaderModule *shaderModule);
 }
 
 
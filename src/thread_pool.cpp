@@ -0,0 +1,85 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <exception>
+
+namespace vkBasalt
+{
+    ThreadPool::ThreadPool(uint32_t threadCount)
+        : stop(false)
+    {
+        for(uint32_t i=0;i<threadCount;i++)
+        {
+            threads.emplace_back(&ThreadPool::workLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> l(lock);
+            stop = true;
+        }
+        wakeUp.notify_all();
+        for(std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    std::future<void> ThreadPool::submit(std::function<void()> task)
+    {
+        Task poolTask = {std::move(task), std::promise<void>()};
+        std::future<void> future = poolTask.promise.get_future();
+        {
+            std::lock_guard<std::mutex> l(lock);
+            tasks.push_back(std::move(poolTask));
+        }
+        wakeUp.notify_one();
+        return future;
+    }
+
+    void ThreadPool::workLoop()
+    {
+        for(;;)
+        {
+            //the task is only constructed from the queue, a default constructed promise would allocate in an idle worker
+            std::unique_lock<std::mutex> l(lock);
+            wakeUp.wait(l, [this]{return stop || !tasks.empty();});
+            if(tasks.empty())
+            {
+                return;
+            }
+            Task task = std::move(tasks.front());
+            tasks.pop_front();
+            l.unlock();
+            std::exception_ptr exception;
+            try
+            {
+                task.function();
+            }
+            catch(...)
+            {
+                exception = std::current_exception();
+            }
+            //a packaged_task only drops the captures after its future is ready, the waiter could then
+            //destroy its swapchain while the last reference to an old effect state is still held here
+            task.function = nullptr;
+            if(exception)
+            {
+                task.promise.set_exception(exception);
+            }
+            else
+            {
+                task.promise.set_value();
+            }
+        }
+    }
+
+    ThreadPool& getThreadPool()
+    {
+        //building effects is mostly waiting for the driver to compile, a few threads are enough
+        static ThreadPool threadPool(std::clamp<uint32_t>(std::thread::hardware_concurrency(), 1, 4));
+        return threadPool;
+    }
+}
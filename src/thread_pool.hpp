@@ -0,0 +1,52 @@
+#ifndef THREAD_POOL_HPP_INCLUDED
+#define THREAD_POOL_HPP_INCLUDED
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <cstdint>
+
+namespace vkBasalt
+{
+    /*
+       a few worker threads for work the layer can spread out, like building the effects of a swapchain
+
+       a task must not wait for another task of the pool, every worker could be busy waiting
+       the futures rethrow whatever their task threw
+       the task and what it captured are destroyed before its future is ready, so a caller that waited
+       holds the last reference to everything it passed in
+    */
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(uint32_t threadCount);
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        //runs the tasks that are still queued, then joins the workers
+        ~ThreadPool();
+
+        std::future<void> submit(std::function<void()> task);
+
+    private:
+        std::vector<std::thread> threads;
+        struct Task
+        {
+            std::function<void()> function;
+            std::promise<void> promise;
+        };
+        std::deque<Task> tasks;
+        bool stop;
+        std::mutex lock;//guards tasks and stop
+        std::condition_variable wakeUp;
+
+        void workLoop();
+    };
+
+    //the pool of the layer, started with the first call so a layer that never builds effects never starts the threads
+    ThreadPool& getThreadPool();
+}
+
+#endif // THREAD_POOL_HPP_INCLUDED
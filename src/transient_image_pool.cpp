@@ -0,0 +1,163 @@
+#include "transient_image_pool.hpp"
+#include "logical_device.hpp"
+#include "logger.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+#ifndef ASSERT_VULKAN
+#define ASSERT_VULKAN(val)\
+        if(val!=VK_SUCCESS)\
+        {\
+            throw std::runtime_error("ASSERT_VULKAN failed " + std::to_string(val));\
+        }
+#endif
+
+namespace vkBasalt
+{
+    namespace
+    {
+        thread_local uint64_t currentGroup = 0;
+    }
+
+    TransientImagePool::TransientImagePool()
+        : pLogicalDevice(nullptr), resourceOwner(ResourceTracker::deviceOwner)
+    {
+    }
+
+    void TransientImagePool::init(LogicalDevice* pLogicalDevice)
+    {
+        this->pLogicalDevice = pLogicalDevice;
+        resourceOwner = pLogicalDevice->resourceTracker.createOwner("transient pool");
+    }
+
+    void TransientImagePool::destroy()
+    {
+        std::lock_guard<std::mutex> l(lock);
+        for(auto& region : regions)
+        {
+            Logger::warn("transient region of ", region->size, " bytes still used by ", region->userCount, " effects");
+            pLogicalDevice->memoryAllocator.free(region->memory);
+            pLogicalDevice->resourceTracker.remove(ResourceType::Memory, region.get());
+        }
+        regions.clear();
+        pLogicalDevice->resourceTracker.destroyOwner(resourceOwner);
+    }
+
+    uint32_t TransientImagePool::getSlotCount(uint32_t imageCount)
+    {
+        //with timeline semaphores every frame of the layer waits for the one before, no matter on which queue,
+        //so the frames in flight never run their effects at the same time and one set of scratch images is enough
+        //without them frames of one swapchain still run in order on their queue, but may overlap between images,
+        //so every swapchain image keeps its own slot and every swapchain its own group
+        return pLogicalDevice->timelineSemaphores ? 1 : imageCount;
+    }
+
+    TransientRegion* TransientImagePool::bindImages(uint32_t slot, const std::vector<VkImage>& images)
+    {
+        std::vector<VkDeviceSize> offsets(images.size());
+        VkMemoryRequirements regionRequirements;
+        regionRequirements.size = 0;
+        regionRequirements.alignment = 1;
+        regionRequirements.memoryTypeBits = ~0u;
+        for(uint32_t i=0;i<images.size();i++)
+        {
+            VkMemoryRequirements memoryRequirements;
+            pLogicalDevice->dispatchTable.GetImageMemoryRequirements(pLogicalDevice->device, images[i], &memoryRequirements);
+            offsets[i] = (regionRequirements.size + memoryRequirements.alignment - 1) / memoryRequirements.alignment * memoryRequirements.alignment;
+            regionRequirements.size = offsets[i] + memoryRequirements.size;
+            regionRequirements.alignment = std::max(regionRequirements.alignment, memoryRequirements.alignment);
+            regionRequirements.memoryTypeBits &= memoryRequirements.memoryTypeBits;
+        }
+
+        uint64_t group = pLogicalDevice->timelineSemaphores ? 0 : TransientGroupScope::getCurrentGroup();
+        std::lock_guard<std::mutex> l(lock);
+        TransientRegion* pRegion = nullptr;
+        for(auto& region : regions)
+        {
+            //the memory type the region got is one of its memoryTypeBits, so a superset of them fits as well
+            if(region->group == group && region->slot == slot && region->size >= regionRequirements.size
+               && (region->memoryTypeBits & regionRequirements.memoryTypeBits) == region->memoryTypeBits
+               && region->memory.offset % regionRequirements.alignment == 0)
+            {
+                pRegion = region.get();
+                break;
+            }
+        }
+        if(pRegion == nullptr)
+        {
+            regions.emplace_back(new TransientRegion);
+            pRegion = regions.back().get();
+            pRegion->group = group;
+            pRegion->slot = slot;
+            pRegion->memoryTypeBits = regionRequirements.memoryTypeBits;
+            pRegion->size = regionRequirements.size;
+            pRegion->userCount = 0;
+            pRegion->memory = pLogicalDevice->memoryAllocator.allocate(regionRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+            ResourceScope resourceScope(resourceOwner);
+            pLogicalDevice->resourceTracker.add(ResourceType::Memory, pRegion, pRegion->size);
+            Logger::debug("new transient region of ", pRegion->size, " bytes for slot ", slot);
+        }
+        else
+        {
+            Logger::debug("aliasing ", regionRequirements.size, " bytes of scratch images in the transient region of slot ", slot);
+        }
+
+        for(uint32_t i=0;i<images.size();i++)
+        {
+            VkResult result = pLogicalDevice->dispatchTable.BindImageMemory(pLogicalDevice->device, images[i], pRegion->memory.memory, pRegion->memory.offset + offsets[i]);
+            ASSERT_VULKAN(result);
+        }
+        pRegion->userCount++;
+        return pRegion;
+    }
+
+    void TransientImagePool::release(TransientRegion* pRegion)
+    {
+        std::lock_guard<std::mutex> l(lock);
+        if(--pRegion->userCount != 0)
+        {
+            return;
+        }
+        pLogicalDevice->memoryAllocator.free(pRegion->memory);
+        pLogicalDevice->resourceTracker.remove(ResourceType::Memory, pRegion);
+        regions.erase(std::find_if(regions.begin(), regions.end(), [pRegion](const std::unique_ptr<TransientRegion>& region) {
+            return region.get() == pRegion;
+        }));
+    }
+
+    TransientGroupScope::TransientGroupScope(uint64_t group)
+        : previousGroup(currentGroup)
+    {
+        currentGroup = group;
+    }
+
+    TransientGroupScope::~TransientGroupScope()
+    {
+        currentGroup = previousGroup;
+    }
+
+    uint64_t TransientGroupScope::getCurrentGroup()
+    {
+        return currentGroup;
+    }
+
+    void recordTransientBarrier(LogicalDevice* pLogicalDevice, VkCommandBuffer commandBuffer)
+    {
+        //the previous user sampled its scratch images in a fragment shader or was still writing them,
+        //the contents do not matter since the render passes start from an undefined layout
+        VkMemoryBarrier memoryBarrier;
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.pNext = nullptr;
+        memoryBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+        pLogicalDevice->dispatchTable.CmdPipelineBarrier(commandBuffer,
+                                                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                                         0,
+                                                         1, &memoryBarrier,
+                                                         0, nullptr,
+                                                         0, nullptr);
+    }
+}
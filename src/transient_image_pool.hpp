@@ -0,0 +1,86 @@
+#ifndef TRANSIENT_IMAGE_POOL_HPP_INCLUDED
+#define TRANSIENT_IMAGE_POOL_HPP_INCLUDED
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+
+#include "vulkan/vulkan.h"
+#include "vulkan/vk_layer.h"
+#include "vulkan/vk_layer_dispatch_table.h"
+
+#include "memory_allocator.hpp"
+
+namespace vkBasalt
+{
+    struct LogicalDevice;
+
+    //memory that the scratch images of every effect with the same slot share
+    struct TransientRegion
+    {
+        uint64_t group;
+        uint32_t slot;
+        uint32_t memoryTypeBits;
+        VkDeviceSize size;
+        uint32_t userCount;
+        MemoryAllocation memory;
+    };
+
+    /*
+       scratch images that are written and read inside one effect pass, like the smaa edge and blend targets,
+       do not need their own memory per swapchain image and effect
+
+       the pool hands out one region per slot, the images of one effect are placed one after another in it
+       and every other effect (of any swapchain) with the same slot starts at the beginning of the same region again,
+       so the scratch memory is the biggest single effect instead of the sum over the chain
+
+       because the memory is aliased, the effects have to record recordTransientBarrier before their first pass
+       that renders into scratch images, and the render passes have to start from VK_IMAGE_LAYOUT_UNDEFINED
+
+       the barrier only orders frames on one queue, without timeline semaphores the frames of swapchains
+       on different queues may run at the same time, so then every swapchain gets its own regions,
+       told apart by the group of the current TransientGroupScope
+    */
+    class TransientImagePool
+    {
+    public:
+        TransientImagePool();
+        TransientImagePool(const TransientImagePool&) = delete;
+        TransientImagePool& operator=(const TransientImagePool&) = delete;
+
+        void init(LogicalDevice* pLogicalDevice);
+        void destroy();
+
+        //how many sets of scratch images an effect needs for imageCount swapchain images, use imageIndex % slotCount
+        uint32_t getSlotCount(uint32_t imageCount);
+        //binds the images to the region of slot, they stay valid until release
+        TransientRegion* bindImages(uint32_t slot, const std::vector<VkImage>& images);
+        void release(TransientRegion* pRegion);
+
+    private:
+        LogicalDevice* pLogicalDevice;
+        uint64_t resourceOwner;//the regions are shared, so they are counted for the pool instead of an effect
+        std::vector<std::unique_ptr<TransientRegion>> regions;
+        std::mutex lock;
+    };
+
+    //the scratch images created on this thread while the scope lives belong to group, usually one group per swapchain
+    class TransientGroupScope
+    {
+    public:
+        explicit TransientGroupScope(uint64_t group);
+        TransientGroupScope(const TransientGroupScope&) = delete;
+        TransientGroupScope& operator=(const TransientGroupScope&) = delete;
+        ~TransientGroupScope();
+
+        static uint64_t getCurrentGroup();
+
+    private:
+        uint64_t previousGroup;
+    };
+
+    //orders the passes of the previous users of the aliased memory before the next color attachment write
+    void recordTransientBarrier(LogicalDevice* pLogicalDevice, VkCommandBuffer commandBuffer);
+}
+
+#endif // TRANSIENT_IMAGE_POOL_HPP_INCLUDED
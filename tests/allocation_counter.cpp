@@ -0,0 +1,103 @@
+#include "allocation_counter.hpp"
+
+#include <atomic>
+#include <new>
+#include <cstdlib>
+
+namespace
+{
+    std::atomic<bool> counting{false};
+    std::atomic<uint64_t> allocationCount{0};
+
+    void* allocate(std::size_t size)
+    {
+        if(counting.load(std::memory_order_relaxed))
+        {
+            allocationCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        void* p = std::malloc(size == 0 ? 1 : size);
+        if(p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+}
+
+//the aligned overloads are not replaced, the layer has no over-aligned heap objects on the paths that are counted
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+//the standard library takes temporary buffers with the nothrow versions and gives them back with the plain delete
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocate(size);
+    }
+    catch(const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocate(size);
+    }
+    catch(const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace vkBasalt
+{
+    namespace test
+    {
+        AllocationCounter::AllocationCounter()
+        {
+            allocationCount = 0;
+            counting = true;
+        }
+
+        AllocationCounter::~AllocationCounter()
+        {
+            counting = false;
+        }
+
+        uint64_t AllocationCounter::getCount()
+        {
+            return allocationCount;
+        }
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef ALLOCATION_COUNTER_HPP_INCLUDED
+#define ALLOCATION_COUNTER_HPP_INCLUDED
+#include <cstdint>
+
+namespace vkBasalt
+{
+    namespace test
+    {
+        /*
+           counts the calls of the global operator new on every thread while it is alive,
+           the test binary replaces operator new for it, so only one may exist at a time
+        */
+        class AllocationCounter
+        {
+        public:
+            AllocationCounter();
+            ~AllocationCounter();
+            AllocationCounter(const AllocationCounter&) = delete;
+            AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+            uint64_t getCount();
+        };
+    }
+}
+
+#endif // ALLOCATION_COUNTER_HPP_INCLUDED
@@ -0,0 +1,121 @@
+#include "test.hpp"
+
+#include <thread>
+#include <atomic>
+
+#include "handle_map.hpp"
+
+namespace
+{
+    //looks like a heap pointer, aligned and never 0
+    uint64_t makeHandle(uint64_t i)
+    {
+        return 0x10000 + i * 64;
+    }
+}
+
+TEST(handleMapInsertFindErase)
+{
+    vkBasalt::HandleMap<uint64_t> map;
+    for(uint64_t i=0;i<1000;i++)
+    {
+        map.insert(makeHandle(i)) = i;
+    }
+    for(uint64_t i=0;i<1000;i++)
+    {
+        CHECK(map.find(makeHandle(i)) != nullptr && *map.find(makeHandle(i)) == i);
+    }
+    CHECK(map.find(makeHandle(1000)) == nullptr);
+
+    for(uint64_t i=0;i<1000;i+=2)
+    {
+        map.erase(makeHandle(i));
+    }
+    for(uint64_t i=0;i<1000;i++)
+    {
+        //erased handles leave tombstones, the handles behind them are still found
+        CHECK((map.find(makeHandle(i)) == nullptr) == (i % 2 == 0));
+    }
+
+    //inserting an existing handle replaces its record
+    map.insert(makeHandle(1)) = 42;
+    CHECK(*map.find(makeHandle(1)) == 42);
+}
+
+TEST(handleMapReusesTombstones)
+{
+    //drivers hand out the same handle again after it was destroyed,
+    //a create and destroy per frame must keep working on the tombstones and not pile up replaced tables
+    vkBasalt::HandleMap<uint64_t> map;
+    for(uint64_t i=0;i<16;i++)
+    {
+        map.insert(makeHandle(i)) = i;
+    }
+    for(uint64_t frame=0;frame<100000;frame++)
+    {
+        uint64_t handle = makeHandle(16 + frame % 64);
+        map.insert(handle) = frame;
+        CHECK(*map.find(handle) == frame);
+        map.erase(handle);
+        CHECK(map.find(handle) == nullptr);
+    }
+    for(uint64_t i=0;i<16;i++)
+    {
+        CHECK(*map.find(makeHandle(i)) == i);
+    }
+    //no find runs, so every replaced table was freed by the write that replaced it
+    CHECK(map.retiredTableCount() == 0);
+}
+
+TEST(handleMapConcurrentFindDuringGrow)
+{
+    //finds run without a lock while another thread grows the table several times
+    vkBasalt::HandleMap<uint64_t> map;
+    const uint64_t stableCount = 32;
+    for(uint64_t i=0;i<stableCount;i++)
+    {
+        map.insert(makeHandle(i)) = i;
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> readers;
+    for(uint32_t t=0;t<3;t++)
+    {
+        readers.emplace_back([&]()
+        {
+            while(!stop)
+            {
+                for(uint64_t i=0;i<stableCount;i++)
+                {
+                    uint64_t* pRecord = map.find(makeHandle(i));
+                    if(pRecord == nullptr || *pRecord != i)
+                    {
+                        failed = true;
+                    }
+                }
+            }
+        });
+    }
+    for(uint64_t i=stableCount;i<20000;i++)
+    {
+        map.insert(makeHandle(i)) = i;
+        if(i % 3 == 0)
+        {
+            map.erase(makeHandle(i));
+        }
+    }
+    stop = true;
+    for(std::thread& reader : readers)
+    {
+        reader.join();
+    }
+    CHECK(!failed);
+    for(uint64_t i=stableCount;i<20000;i++)
+    {
+        CHECK((map.find(makeHandle(i)) == nullptr) == (i % 3 == 0));
+    }
+    //the tables a running find held on to are freed by the next write
+    map.erase(makeHandle(0));
+    CHECK(map.retiredTableCount() == 0);
+}
@@ -0,0 +1,170 @@
+#include "layer_device.hpp"
+
+#include <memory>
+#include <stdexcept>
+
+#include "handle_map.hpp"
+#include "config.hpp"
+
+extern "C" PFN_vkVoidFunction VKAPI_CALL vkBasalt_GetInstanceProcAddr(VkInstance instance, const char* pName);
+extern "C" PFN_vkVoidFunction VKAPI_CALL vkBasalt_GetDeviceProcAddr(VkDevice device, const char* pName);
+
+//the globals of basalt.cpp
+extern vkBasalt::HandleMap<std::shared_ptr<vkBasalt::LogicalDevice>> deviceMap;
+extern std::shared_ptr<vkBasalt::Config> pConfig;
+
+namespace vkBasalt
+{
+    namespace test
+    {
+        LayerDevice::LayerDevice(const mock::DriverConfig& driverConfig)
+        {
+            mock::reset(driverConfig);
+            //the instance reads the config file again, so the options an earlier test set are gone
+            pConfig = nullptr;
+
+            VkApplicationInfo applicationInfo = {};
+            applicationInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+            applicationInfo.apiVersion = driverConfig.apiVersion;
+
+            //the loader links the layer to the next one in the chain, here that is the driver
+            VkLayerInstanceLink instanceLink = {};
+            instanceLink.pNext = nullptr;
+            instanceLink.pfnNextGetInstanceProcAddr = mock::getInstanceProcAddr;
+
+            VkLayerInstanceCreateInfo layerInstanceCreateInfo = {};
+            layerInstanceCreateInfo.sType = VK_STRUCTURE_TYPE_LOADER_INSTANCE_CREATE_INFO;
+            layerInstanceCreateInfo.pNext = nullptr;
+            layerInstanceCreateInfo.function = VK_LAYER_LINK_INFO;
+            layerInstanceCreateInfo.u.pLayerInfo = &instanceLink;
+
+            VkInstanceCreateInfo instanceCreateInfo = {};
+            instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+            instanceCreateInfo.pNext = &layerInstanceCreateInfo;
+            instanceCreateInfo.pApplicationInfo = &applicationInfo;
+
+            PFN_vkCreateInstance createInstance = (PFN_vkCreateInstance) vkBasalt_GetInstanceProcAddr(VK_NULL_HANDLE, "vkCreateInstance");
+            if(createInstance(&instanceCreateInfo, nullptr, &instance) != VK_SUCCESS)
+            {
+                throw std::runtime_error("vkCreateInstance failed");
+            }
+
+            uint32_t physicalDeviceCount = 1;
+            PFN_vkEnumeratePhysicalDevices enumeratePhysicalDevices = (PFN_vkEnumeratePhysicalDevices) vkBasalt_GetInstanceProcAddr(instance, "vkEnumeratePhysicalDevices");
+            enumeratePhysicalDevices(instance, &physicalDeviceCount, &physicalDevice);
+
+            VkLayerDeviceLink deviceLink = {};
+            deviceLink.pNext = nullptr;
+            deviceLink.pfnNextGetInstanceProcAddr = mock::getInstanceProcAddr;
+            deviceLink.pfnNextGetDeviceProcAddr = mock::getDeviceProcAddr;
+
+            VkLayerDeviceCreateInfo layerDeviceCreateInfo = {};
+            layerDeviceCreateInfo.sType = VK_STRUCTURE_TYPE_LOADER_DEVICE_CREATE_INFO;
+            layerDeviceCreateInfo.pNext = nullptr;
+            layerDeviceCreateInfo.function = VK_LAYER_LINK_INFO;
+            layerDeviceCreateInfo.u.pLayerInfo = &deviceLink;
+
+            VkDeviceCreateInfo deviceCreateInfo = {};
+            deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+            deviceCreateInfo.pNext = &layerDeviceCreateInfo;
+
+            PFN_vkCreateDevice createDevice = (PFN_vkCreateDevice) vkBasalt_GetInstanceProcAddr(instance, "vkCreateDevice");
+            if(createDevice(physicalDevice, &deviceCreateInfo, nullptr, &device) != VK_SUCCESS)
+            {
+                throw std::runtime_error("vkCreateDevice failed");
+            }
+
+            getDeviceProcAddr = (PFN_vkGetDeviceProcAddr) vkBasalt_GetDeviceProcAddr(device, "vkGetDeviceProcAddr");
+            getDeviceQueue = (PFN_vkGetDeviceQueue) getProcAddr("vkGetDeviceQueue");
+            createSwapchainKHR = (PFN_vkCreateSwapchainKHR) getProcAddr("vkCreateSwapchainKHR");
+            getSwapchainImagesKHR = (PFN_vkGetSwapchainImagesKHR) getProcAddr("vkGetSwapchainImagesKHR");
+            queuePresentKHR = (PFN_vkQueuePresentKHR) getProcAddr("vkQueuePresentKHR");
+            destroySwapchainKHR = (PFN_vkDestroySwapchainKHR) getProcAddr("vkDestroySwapchainKHR");
+        }
+
+        LayerDevice::~LayerDevice()
+        {
+            PFN_vkDestroyDevice destroyDevice = (PFN_vkDestroyDevice) getProcAddr("vkDestroyDevice");
+            destroyDevice(device, nullptr);
+            PFN_vkDestroyInstance destroyInstance = (PFN_vkDestroyInstance) vkBasalt_GetInstanceProcAddr(instance, "vkDestroyInstance");
+            destroyInstance(instance, nullptr);
+        }
+
+        LogicalDevice* LayerDevice::getLogicalDevice()
+        {
+            return deviceMap.find(device)->get();
+        }
+
+        PFN_vkVoidFunction LayerDevice::getProcAddr(const char* pName)
+        {
+            return getDeviceProcAddr(device, pName);
+        }
+
+        VkQueue LayerDevice::getQueue(uint32_t queueFamilyIndex, uint32_t queueIndex)
+        {
+            VkQueue queue;
+            getDeviceQueue(device, queueFamilyIndex, queueIndex, &queue);
+            return queue;
+        }
+
+        VkSwapchainKHR LayerDevice::createSwapchain(VkExtent2D extent, VkSwapchainKHR oldSwapchain, bool getImages)
+        {
+            VkSwapchainCreateInfoKHR swapchainCreateInfo = {};
+            swapchainCreateInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+            swapchainCreateInfo.minImageCount = 3;
+            swapchainCreateInfo.imageFormat = VK_FORMAT_B8G8R8A8_UNORM;
+            swapchainCreateInfo.imageColorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+            swapchainCreateInfo.imageExtent = extent;
+            swapchainCreateInfo.imageArrayLayers = 1;
+            swapchainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+            swapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            swapchainCreateInfo.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+            swapchainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+            swapchainCreateInfo.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+            swapchainCreateInfo.clipped = VK_TRUE;
+            swapchainCreateInfo.oldSwapchain = oldSwapchain;
+
+            VkSwapchainKHR swapchain;
+            if(createSwapchainKHR(device, &swapchainCreateInfo, nullptr, &swapchain) != VK_SUCCESS)
+            {
+                throw std::runtime_error("vkCreateSwapchainKHR failed");
+            }
+            if(getImages)
+            {
+                uint32_t imageCount = 0;
+                getSwapchainImagesKHR(device, swapchain, &imageCount, nullptr);
+                std::vector<VkImage> images(imageCount);
+                if(getSwapchainImagesKHR(device, swapchain, &imageCount, images.data()) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("vkGetSwapchainImagesKHR failed");
+                }
+            }
+            return swapchain;
+        }
+
+        void LayerDevice::destroySwapchain(VkSwapchainKHR swapchain)
+        {
+            destroySwapchainKHR(device, swapchain, nullptr);
+        }
+
+        VkResult LayerDevice::present(VkQueue queue, VkSwapchainKHR swapchain, uint32_t imageIndex)
+        {
+            VkPresentInfoKHR presentInfo = {};
+            presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+            presentInfo.swapchainCount = 1;
+            presentInfo.pSwapchains = &swapchain;
+            presentInfo.pImageIndices = &imageIndex;
+            return queuePresentKHR(queue, &presentInfo);
+        }
+
+        void setOption(const std::string& option, const std::string& value)
+        {
+            //the layer creates its config with the instance
+            if(pConfig == nullptr)
+            {
+                throw std::runtime_error("setOption before the instance");
+            }
+            pConfig->setOption(option, value);
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef LAYER_DEVICE_HPP_INCLUDED
+#define LAYER_DEVICE_HPP_INCLUDED
+#include <string>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+#include "vulkan/vk_layer.h"
+#include "vulkan/vk_layer_dispatch_table.h"
+
+#include "logical_device.hpp"
+#include "mock_driver.hpp"
+
+namespace vkBasalt
+{
+    namespace test
+    {
+        /*
+           an instance and a device created through the layer on top of the mock driver,
+           every call goes through the entry points the loader would use
+
+           the constructor resets the mock driver with the given config and the layer config to the file, the destructor
+           destroys the device and the instance, after that nothing of the driver may be alive
+        */
+        class LayerDevice
+        {
+        public:
+            LayerDevice(const mock::DriverConfig& driverConfig = mock::DriverConfig());
+            ~LayerDevice();
+            LayerDevice(const LayerDevice&) = delete;
+            LayerDevice& operator=(const LayerDevice&) = delete;
+
+            //the device context the layer created for the device
+            LogicalDevice* getLogicalDevice();
+            PFN_vkVoidFunction getProcAddr(const char* pName);
+
+            VkQueue getQueue(uint32_t queueFamilyIndex = 0, uint32_t queueIndex = 0);
+            //also gets the images, so the effects are built when it returns
+            VkSwapchainKHR createSwapchain(VkExtent2D extent, VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE, bool getImages = true);
+            void destroySwapchain(VkSwapchainKHR swapchain);
+            VkResult present(VkQueue queue, VkSwapchainKHR swapchain, uint32_t imageIndex);
+
+            VkInstance instance;
+            VkPhysicalDevice physicalDevice;
+            VkDevice device;
+
+        private:
+            PFN_vkGetDeviceProcAddr getDeviceProcAddr;
+            PFN_vkGetDeviceQueue getDeviceQueue;
+            PFN_vkCreateSwapchainKHR createSwapchainKHR;
+            PFN_vkGetSwapchainImagesKHR getSwapchainImagesKHR;
+            PFN_vkQueuePresentKHR queuePresentKHR;
+            PFN_vkDestroySwapchainKHR destroySwapchainKHR;
+        };
+
+        //changes the config of the layer until the next LayerDevice, it is only read when a swapchain is created
+        void setOption(const std::string& option, const std::string& value);
+    }
+}
+
+#endif // LAYER_DEVICE_HPP_INCLUDED
@@ -0,0 +1,99 @@
+#include "test.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+
+#if __GNUC__ == 7
+#include <experimental/filesystem>
+#define filesystem experimental::filesystem
+#else
+#include <filesystem>
+#endif
+
+namespace vkBasalt
+{
+    namespace test
+    {
+        std::vector<TestCase>& getTestCases()
+        {
+            static std::vector<TestCase> testCases;
+            return testCases;
+        }
+    }
+}
+
+/*
+   runs every test, or the tests and benchmarks named on the command line, --benchmark runs all benchmarks
+
+   the layer reads its config and writes its pipeline cache while the tests run,
+   so both are pointed into a temporary directory that is removed at the end
+*/
+int main(int argc, char** argv)
+{
+    std::vector<std::string> names;
+    bool benchmarks = false;
+    for(int i=1;i<argc;i++)
+    {
+        if(!std::strcmp(argv[i], "--benchmark"))
+        {
+            benchmarks = true;
+        }
+        else
+        {
+            names.push_back(argv[i]);
+        }
+    }
+
+    char directoryTemplate[] = "/tmp/vkbasalt_tests_XXXXXX";
+    if(mkdtemp(directoryTemplate) == nullptr)
+    {
+        std::cerr << "could not create a temporary directory" << std::endl;
+        return 1;
+    }
+    std::string directory = directoryTemplate;
+    {
+        std::ofstream configFile(directory + "/vkBasalt.conf");
+        configFile << "effects = cas:smaa" << std::endl;
+    }
+    setenv("VKBASALT_CONFIG_FILE", (directory + "/vkBasalt.conf").c_str(), 1);
+    setenv("XDG_CACHE_HOME", directory.c_str(), 1);
+    setenv("VKBASALT_LOG_LEVEL", "error", 0);
+    //a key pressed on the desktop while the tests run must not toggle the effects
+    unsetenv("DISPLAY");
+    //the tests check the shaders compiled into the layer
+    unsetenv("VKBASALT_SHADER_PATH");
+
+    uint32_t runCount = 0;
+    uint32_t failCount = 0;
+    for(const vkBasalt::test::TestCase& testCase : vkBasalt::test::getTestCases())
+    {
+        bool named = false;
+        for(const std::string& name : names)
+        {
+            named |= name == testCase.name;
+        }
+        if(!named && (!names.empty() || testCase.benchmark != benchmarks))
+        {
+            continue;
+        }
+        std::cout << "[ RUN  ] " << testCase.name << std::endl;
+        runCount++;
+        try
+        {
+            testCase.function();
+            std::cout << "[   OK ] " << testCase.name << std::endl;
+        }
+        catch(const std::exception& e)
+        {
+            std::cout << "[ FAIL ] " << testCase.name << ": " << e.what() << std::endl;
+            failCount++;
+        }
+    }
+
+    std::filesystem::remove_all(directory);
+    std::cout << runCount - failCount << " of " << runCount << " passed" << std::endl;
+    return failCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+#include "test.hpp"
+#include "layer_device.hpp"
+
+#include <iostream>
+#include <algorithm>
+
+#include "memory_allocator.hpp"
+
+namespace
+{
+    using vkBasalt::test::LayerDevice;
+    using vkBasalt::mock::ObjectType;
+    using vkBasalt::MemoryAllocation;
+    using vkBasalt::MemoryAllocator;
+
+    constexpr VkDeviceSize MiB = 1024 * 1024;
+
+    VkMemoryRequirements makeRequirements(VkDeviceSize size, VkDeviceSize alignment)
+    {
+        VkMemoryRequirements requirements;
+        requirements.size = size;
+        requirements.alignment = alignment;
+        requirements.memoryTypeBits = 0x3;
+        return requirements;
+    }
+
+    bool overlap(const MemoryAllocation& a, const MemoryAllocation& b)
+    {
+        return a.memory == b.memory && a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+    }
+}
+
+TEST(memoryAllocatorPlacesAlignedRangesWithoutOverlap)
+{
+    LayerDevice layerDevice;
+    MemoryAllocator allocator;
+    allocator.init(layerDevice.getLogicalDevice());
+
+    std::vector<MemoryAllocation> allocations;
+    VkDeviceSize alignments[] = {1, 256, 4096, 65536};
+    for(uint32_t i=0;i<200;i++)
+    {
+        VkDeviceSize alignment = alignments[i % 4];
+        allocations.push_back(allocator.allocate(makeRequirements(1000 + i * 3001, alignment), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, i % 2 == 0));
+        CHECK(allocations.back().offset % alignment == 0);
+    }
+    for(uint32_t i=0;i<allocations.size();i++)
+    {
+        for(uint32_t j=i+1;j<allocations.size();j++)
+        {
+            CHECK(!overlap(allocations[i], allocations[j]));
+        }
+    }
+    //200 resources in a few blocks instead of 200 vkAllocateMemory calls
+    CHECK(allocator.getBlockCount() < 4);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::Memory) == allocator.getBlockCount());
+
+    for(MemoryAllocation& allocation : allocations)
+    {
+        allocator.free(allocation);
+    }
+    CHECK(allocator.getUsedSize() == 0);
+    //the free ranges merged again, a resource of the size of the first block fits into it
+    uint32_t blockCount = allocator.getBlockCount();
+    MemoryAllocation whole = allocator.allocate(makeRequirements(32 * MiB, 4096), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+    CHECK(allocator.getBlockCount() == blockCount);
+    allocator.free(whole);
+    allocator.destroy();
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::Memory) == 0);
+}
+
+TEST(memoryAllocatorSeparatesLinearResources)
+{
+    //with a bufferImageGranularity above 1 buffers and optimal images never share a block
+    vkBasalt::mock::DriverConfig driverConfig;
+    driverConfig.bufferImageGranularity = 1024;
+    LayerDevice layerDevice(driverConfig);
+    MemoryAllocator allocator;
+    allocator.init(layerDevice.getLogicalDevice());
+
+    MemoryAllocation buffer = allocator.allocate(makeRequirements(4096, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+    MemoryAllocation image = allocator.allocate(makeRequirements(4096, 4096), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+    CHECK(buffer.memory != image.memory);
+    MemoryAllocation secondBuffer = allocator.allocate(makeRequirements(4096, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+    CHECK(secondBuffer.memory == buffer.memory);
+
+    allocator.free(buffer);
+    allocator.free(image);
+    allocator.free(secondBuffer);
+    allocator.destroy();
+}
+
+TEST(memoryAllocatorMapsHostVisibleBlocks)
+{
+    LayerDevice layerDevice;
+    MemoryAllocator allocator;
+    allocator.init(layerDevice.getLogicalDevice());
+
+    MemoryAllocation first = allocator.allocate(makeRequirements(1000, 1), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+    MemoryAllocation second = allocator.allocate(makeRequirements(1000, 1), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+    CHECK(first.pMappedData != nullptr && second.pMappedData != nullptr);
+    CHECK(first.memory == second.memory);
+    CHECK((char*) second.pMappedData - (char*) first.pMappedData == (std::ptrdiff_t) second.offset - (std::ptrdiff_t) first.offset);
+    //the device local heap is not touched
+    CHECK(vkBasalt::mock::stats.deviceMemory == 0);
+
+    allocator.free(first);
+    allocator.free(second);
+    allocator.destroy();
+}
+
+TEST(memoryAllocatorFreesDedicatedBlocks)
+{
+    LayerDevice layerDevice;
+    MemoryAllocator allocator;
+    allocator.init(layerDevice.getLogicalDevice());
+
+    MemoryAllocation shared = allocator.allocate(makeRequirements(4096, 4096), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+    uint32_t blockCount = allocator.getBlockCount();
+    VkImage image = (VkImage) (uintptr_t) 0x1000;//only passed on to the driver in the dedicated allocate info
+    MemoryAllocation dedicated = allocator.allocateDedicated(makeRequirements(8 * MiB, 4096), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image);
+    CHECK(dedicated.memory != shared.memory && dedicated.offset == 0);
+    CHECK(allocator.getBlockCount() == blockCount + 1);
+    allocator.free(dedicated);
+    //unlike the other blocks it is not kept for later
+    CHECK(allocator.getBlockCount() == blockCount);
+
+    allocator.free(shared);
+    allocator.destroy();
+}
+
+TEST(memoryAllocatorFreesEmptyBlocksWhenTheHeapIsFull)
+{
+    //a 256 MiB heap gets 32 MiB blocks, the empty ones are given back before an allocation fails
+    vkBasalt::mock::DriverConfig driverConfig;
+    driverConfig.deviceHeapSize = 256 * MiB;
+    LayerDevice layerDevice(driverConfig);
+    MemoryAllocator allocator;
+    allocator.init(layerDevice.getLogicalDevice());
+
+    std::vector<MemoryAllocation> allocations;
+    for(uint32_t i=0;i<6;i++)
+    {
+        allocations.push_back(allocator.allocate(makeRequirements(30 * MiB, 4096), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false));
+    }
+    for(MemoryAllocation& allocation : allocations)
+    {
+        allocator.free(allocation);
+    }
+    MemoryAllocation big = allocator.allocate(makeRequirements(200 * MiB, 4096), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+    CHECK(big.memory != VK_NULL_HANDLE);
+    CHECK(allocator.getBlockCount() == 1);
+    allocator.free(big);
+    allocator.destroy();
+}
+
+TEST(swapchainResizesRecycleMemoryBlocks)
+{
+    //a window dragged through a few sizes, each resize creates the new swapchain from the old one and then destroys the old one
+    LayerDevice layerDevice;
+    vkBasalt::LogicalDevice* pLogicalDevice = layerDevice.getLogicalDevice();
+    VkQueue queue = layerDevice.getQueue();
+    VkExtent2D extents[] = {{1280, 720}, {1920, 1080}, {2560, 1440}, {1600, 900}, {3840, 2160}, {800, 600}};
+    const uint32_t extentCount = sizeof(extents) / sizeof(extents[0]);
+    const uint32_t resizeCount = 60;
+
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+    uint32_t allocationsAfterFirstRound = 0;
+    for(uint32_t i=0;i<resizeCount;i++)
+    {
+        VkSwapchainKHR newSwapchain = layerDevice.createSwapchain(extents[i % extentCount], swapchain);
+        if(swapchain != VK_NULL_HANDLE)
+        {
+            layerDevice.destroySwapchain(swapchain);
+        }
+        swapchain = newSwapchain;
+        for(uint32_t frame=0;frame<3;frame++)
+        {
+            CHECK(layerDevice.present(queue, swapchain, frame) == VK_SUCCESS);
+        }
+        if(i == extentCount - 1)
+        {
+            allocationsAfterFirstRound = vkBasalt::mock::getCreatedCount(ObjectType::Memory);
+        }
+    }
+    uint32_t allocationCount = vkBasalt::mock::getCreatedCount(ObjectType::Memory);
+    std::cout << "    " << resizeCount << " resizes: " << allocationCount << " vkAllocateMemory calls, "
+              << allocationsAfterFirstRound << " of them in the first " << extentCount << ", peak "
+              << vkBasalt::mock::stats.peakDeviceMemory / MiB << " MiB of device memory, "
+              << pLogicalDevice->memoryAllocator.getBlockCount() << " blocks" << std::endl;
+
+    //once every size was seen, the blocks of the old swapchains hold the new ones
+    CHECK(allocationCount == allocationsAfterFirstRound);
+    //during a resize the old and the new swapchain are both alive, at 4k their images take about 400 MiB
+    CHECK(vkBasalt::mock::stats.peakDeviceMemory <= 512 * MiB);
+    CHECK(pLogicalDevice->memoryAllocator.getBlockCount() < 16);
+    layerDevice.destroySwapchain(swapchain);
+}
@@ -0,0 +1,109 @@
+#include "test.hpp"
+#include "layer_device.hpp"
+
+#include "memory_budget.hpp"
+
+namespace
+{
+    using vkBasalt::test::LayerDevice;
+    using vkBasalt::mock::ObjectType;
+    using vkBasalt::SwapchainMemoryPlan;
+
+    /*
+       the estimates for cas:smaa at 4k with three swapchain images, in units of one 4k image:
+       3 application images + 3 intermediates + 2 for the smaa edges and blend weights = 8,
+       shared intermediates save 2, compact edges save another half, dropping smaa leaves the 3 application images
+    */
+    const VkExtent2D extent = {3840, 2160};
+    const VkDeviceSize imageSize = 3840ull * 2160 * 4;
+    const std::vector<std::string> effects = {"cas", "smaa"};
+
+    //the budget leaves exactly this much for the layer
+    void setAvailable(VkDeviceSize available)
+    {
+        vkBasalt::mock::config.deviceHeapUsage = 1024ull * 1024 * 1024;
+        vkBasalt::mock::config.deviceHeapBudget = vkBasalt::mock::config.deviceHeapUsage + vkBasalt::mock::stats.deviceMemory + available;
+    }
+
+    SwapchainMemoryPlan plan(LayerDevice& layerDevice, VkDeviceSize oldSwapchainSize = 0)
+    {
+        return vkBasalt::planSwapchainMemory(layerDevice.getLogicalDevice(), effects, extent, VK_FORMAT_B8G8R8A8_UNORM, 3, oldSwapchainSize);
+    }
+
+    bool isUnchanged(const SwapchainMemoryPlan& plan)
+    {
+        return plan.effectStrings == effects && !plan.sharedIntermediates && !plan.compactSmaaEdges;
+    }
+}
+
+TEST(memoryBudgetKeepsTheChainIfItFits)
+{
+    LayerDevice layerDevice;
+    setAvailable(imageSize * 9);
+    CHECK(isUnchanged(plan(layerDevice)));
+}
+
+TEST(memoryBudgetStepsDown)
+{
+    LayerDevice layerDevice;
+
+    setAvailable(imageSize * 7);
+    SwapchainMemoryPlan shared = plan(layerDevice);
+    CHECK(shared.effectStrings == effects && shared.sharedIntermediates && !shared.compactSmaaEdges);
+
+    setAvailable(imageSize * 23 / 4);
+    SwapchainMemoryPlan compact = plan(layerDevice);
+    CHECK(compact.effectStrings == effects && compact.sharedIntermediates && compact.compactSmaaEdges);
+
+    //smaa is the effect with the biggest images
+    setAvailable(imageSize * 4);
+    SwapchainMemoryPlan dropped = plan(layerDevice);
+    CHECK(dropped.effectStrings == std::vector<std::string>{"cas"});
+
+    //the last effect is kept even if it does not fit
+    setAvailable(imageSize);
+    CHECK(plan(layerDevice).effectStrings == std::vector<std::string>{"cas"});
+}
+
+TEST(memoryBudgetDoesNotShareWithoutTimelineSemaphores)
+{
+    //without timeline semaphores the frames of different swapchain images may overlap
+    vkBasalt::mock::DriverConfig driverConfig;
+    driverConfig.timelineSemaphores = false;
+    LayerDevice layerDevice(driverConfig);
+    setAvailable(imageSize * 100);
+    CHECK(isUnchanged(plan(layerDevice)));
+    setAvailable(imageSize * 8);
+    SwapchainMemoryPlan steppedDown = plan(layerDevice);
+    CHECK(!steppedDown.sharedIntermediates && steppedDown.effectStrings == std::vector<std::string>{"cas"});
+}
+
+TEST(memoryBudgetCountsTheOldSwapchain)
+{
+    //the images of the swapchain that gets replaced are freed with it
+    LayerDevice layerDevice;
+    setAvailable(imageSize * 2);
+    CHECK(isUnchanged(plan(layerDevice, imageSize * 7)));
+    CHECK(!isUnchanged(plan(layerDevice, imageSize * 5)));
+}
+
+TEST(memoryBudgetWithoutTheExtension)
+{
+    vkBasalt::mock::DriverConfig driverConfig;
+    driverConfig.memoryBudget = false;
+    driverConfig.deviceHeapBudget = imageSize;
+    LayerDevice layerDevice(driverConfig);
+    CHECK(isUnchanged(plan(layerDevice)));
+}
+
+TEST(memoryBudgetDropsEffectsOfTheSwapchain)
+{
+    //cas has one pipeline, smaa three, so the driver sees whether smaa was built
+    LayerDevice layerDevice;
+    VkQueue queue = layerDevice.getQueue();
+    setAvailable(imageSize * 4);
+    VkSwapchainKHR swapchain = layerDevice.createSwapchain(extent);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::Pipeline) == 1);
+    CHECK(layerDevice.present(queue, swapchain, 0) == VK_SUCCESS);
+    layerDevice.destroySwapchain(swapchain);
+}
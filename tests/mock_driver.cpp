@@ -0,0 +1,1100 @@
+#include "mock_driver.hpp"
+
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+namespace vkBasalt
+{
+    namespace mock
+    {
+        DriverConfig config;
+        DriverStats stats;
+
+        namespace
+        {
+            constexpr uint32_t vendorID = 0xba5a;
+            constexpr uint32_t deviceID = 0x0001;
+            constexpr VkDeviceSize hostHeapSize = 1024ull * 1024 * 1024;
+            constexpr VkDeviceSize imageAlignment = 4096;
+            constexpr size_t pipelineCacheDataSize = 16 + VK_UUID_SIZE + 64;
+
+            //the first member of a dispatchable object belongs to the loader, the layers key their tables with it
+            struct DispatchableObject
+            {
+                void* loaderData;
+            };
+
+            struct Object
+            {
+                ObjectType type;
+            };
+
+            struct Instance : DispatchableObject
+            {
+                DispatchableObject physicalDevice;
+            };
+
+            struct Device : DispatchableObject
+            {
+                std::vector<DispatchableObject*> queues;//by family, then index
+            };
+
+            struct Memory : Object
+            {
+                VkDeviceSize size;
+                uint32_t memoryTypeIndex;
+                void* pHostData;//allocated on the first map
+            };
+
+            struct Buffer : Object
+            {
+                VkDeviceSize size;
+            };
+
+            struct Image : Object
+            {
+                VkExtent3D extent;
+                VkFormat format;
+                uint32_t arrayLayers;
+            };
+
+            struct Swapchain
+            {
+                std::vector<Image*> images;
+            };
+
+            struct CommandBuffer : DispatchableObject, Object
+            {
+                uint32_t drawCount;
+                uint32_t imageCopyCount;
+                uint32_t uploadCount;
+            };
+
+            struct CommandPool : Object
+            {
+                std::vector<CommandBuffer*> commandBuffers;//the application synchronizes the pool
+            };
+
+            struct Semaphore : Object
+            {
+                bool timeline;
+                std::atomic<uint64_t> value;
+            };
+
+            struct Fence : Object
+            {
+                std::atomic<bool> signaled;
+            };
+
+            struct PipelineCache : Object
+            {
+                std::vector<char> data;
+            };
+
+            template<typename Handle>
+            Handle toHandle(void* pObject)
+            {
+                //non dispatchable handles are uint64_t on 32 bit, everything else is a pointer
+                return (Handle) (uintptr_t) pObject;
+            }
+
+            template<typename Record, typename Handle>
+            Record* fromHandle(Handle handle)
+            {
+                return (Record*) (uintptr_t) handle;
+            }
+
+            template<typename Record>
+            Record* createObject(ObjectType type)
+            {
+                Record* pRecord = new Record();
+                pRecord->type = type;
+                stats.created[(uint32_t) type]++;
+                stats.alive[(uint32_t) type]++;
+                return pRecord;
+            }
+
+            template<typename Record>
+            void destroyObject(Record* pRecord)
+            {
+                if(pRecord == nullptr)
+                {
+                    return;
+                }
+                stats.alive[(uint32_t) pRecord->type]--;
+                delete pRecord;
+            }
+
+            //for the objects that have nothing but a type
+            template<typename Handle>
+            VkResult createHandle(ObjectType type, Handle* pHandle)
+            {
+                *pHandle = toHandle<Handle>(createObject<Object>(type));
+                return VK_SUCCESS;
+            }
+
+            template<typename Handle>
+            void destroyHandle(Handle handle)
+            {
+                destroyObject(fromHandle<Object>(handle));
+            }
+
+            //finds a struct in a pNext chain
+            template<typename Struct, typename Chain>
+            Struct* findInChain(Chain* pChain, VkStructureType sType)
+            {
+                for(VkBaseOutStructure* pNext = (VkBaseOutStructure*) pChain; pNext; pNext = pNext->pNext)
+                {
+                    if(pNext->sType == sType)
+                    {
+                        return (Struct*) pNext;
+                    }
+                }
+                return nullptr;
+            }
+
+            void fillPipelineCacheHeader(char* pData)
+            {
+                uint32_t header[4] = {16 + VK_UUID_SIZE, VK_PIPELINE_CACHE_HEADER_VERSION_ONE, vendorID, deviceID};
+                std::memcpy(pData, header, sizeof(header));
+                for(uint32_t i=0;i<VK_UUID_SIZE;i++)
+                {
+                    pData[16 + i] = (char) i;
+                }
+            }
+
+            VkDeviceSize getBytesPerPixel(VkFormat format)
+            {
+                switch(format)
+                {
+                    case VK_FORMAT_R16G16B16A16_SFLOAT:
+                        return 8;
+                    case VK_FORMAT_R8G8_UNORM:
+                        return 2;
+                    case VK_FORMAT_R8_UNORM:
+                        return 1;
+                    default:
+                        return 4;
+                }
+            }
+
+            VkDeviceSize getImageSize(const Image* pImage)
+            {
+                VkDeviceSize size = (VkDeviceSize) pImage->extent.width * pImage->extent.height * pImage->extent.depth
+                                    * pImage->arrayLayers * getBytesPerPixel(pImage->format);
+                return (size + imageAlignment - 1) / imageAlignment * imageAlignment;
+            }
+
+            // instance
+
+            VkResult VKAPI_CALL CreateInstance(const VkInstanceCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkInstance* pInstance)
+            {
+                Instance* pRecord = new Instance();
+                pRecord->loaderData = pRecord;
+                pRecord->physicalDevice.loaderData = pRecord;
+                *pInstance = (VkInstance) pRecord;
+                return VK_SUCCESS;
+            }
+
+            void VKAPI_CALL DestroyInstance(VkInstance instance, const VkAllocationCallbacks* pAllocator)
+            {
+                delete (Instance*) instance;
+            }
+
+            VkResult VKAPI_CALL EnumeratePhysicalDevices(VkInstance instance, uint32_t* pPhysicalDeviceCount, VkPhysicalDevice* pPhysicalDevices)
+            {
+                if(pPhysicalDevices != nullptr && *pPhysicalDeviceCount >= 1)
+                {
+                    pPhysicalDevices[0] = (VkPhysicalDevice) &((Instance*) instance)->physicalDevice;
+                }
+                *pPhysicalDeviceCount = 1;
+                return VK_SUCCESS;
+            }
+
+            VkResult VKAPI_CALL EnumerateDeviceExtensionProperties(VkPhysicalDevice physicalDevice, const char* pLayerName, uint32_t* pPropertyCount, VkExtensionProperties* pProperties)
+            {
+                std::vector<const char*> names = {VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME, VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME};
+                if(config.timelineSemaphores)
+                {
+                    names.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+                }
+                if(config.memoryBudget)
+                {
+                    names.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+                }
+                if(pProperties == nullptr)
+                {
+                    *pPropertyCount = names.size();
+                    return VK_SUCCESS;
+                }
+                uint32_t count = std::min<uint32_t>(*pPropertyCount, names.size());
+                for(uint32_t i=0;i<count;i++)
+                {
+                    std::memset(&pProperties[i], 0, sizeof(VkExtensionProperties));
+                    std::strcpy(pProperties[i].extensionName, names[i]);
+                    pProperties[i].specVersion = 1;
+                }
+                *pPropertyCount = count;
+                return count < names.size() ? VK_INCOMPLETE : VK_SUCCESS;
+            }
+
+            void VKAPI_CALL GetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice physicalDevice, uint32_t* pQueueFamilyPropertyCount, VkQueueFamilyProperties* pQueueFamilyProperties)
+            {
+                if(pQueueFamilyProperties == nullptr)
+                {
+                    *pQueueFamilyPropertyCount = config.queueFamilyCount;
+                    return;
+                }
+                *pQueueFamilyPropertyCount = std::min(*pQueueFamilyPropertyCount, config.queueFamilyCount);
+                for(uint32_t i=0;i<*pQueueFamilyPropertyCount;i++)
+                {
+                    std::memset(&pQueueFamilyProperties[i], 0, sizeof(VkQueueFamilyProperties));
+                    pQueueFamilyProperties[i].queueFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+                    pQueueFamilyProperties[i].queueCount = config.queueCount;
+                    pQueueFamilyProperties[i].minImageTransferGranularity = {1, 1, 1};
+                }
+            }
+
+            void VKAPI_CALL GetPhysicalDeviceMemoryProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties* pMemoryProperties)
+            {
+                std::memset(pMemoryProperties, 0, sizeof(VkPhysicalDeviceMemoryProperties));
+                pMemoryProperties->memoryTypeCount = 2;
+                pMemoryProperties->memoryTypes[0].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+                pMemoryProperties->memoryTypes[0].heapIndex = 0;
+                pMemoryProperties->memoryTypes[1].propertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+                pMemoryProperties->memoryTypes[1].heapIndex = 1;
+                pMemoryProperties->memoryHeapCount = 2;
+                pMemoryProperties->memoryHeaps[0].size = config.deviceHeapSize;
+                pMemoryProperties->memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+                pMemoryProperties->memoryHeaps[1].size = hostHeapSize;
+                pMemoryProperties->memoryHeaps[1].flags = 0;
+            }
+
+            void VKAPI_CALL GetPhysicalDeviceMemoryProperties2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties2* pMemoryProperties)
+            {
+                GetPhysicalDeviceMemoryProperties(physicalDevice, &pMemoryProperties->memoryProperties);
+                VkPhysicalDeviceMemoryBudgetPropertiesEXT* pBudget = findInChain<VkPhysicalDeviceMemoryBudgetPropertiesEXT>(pMemoryProperties->pNext, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT);
+                if(pBudget == nullptr || !config.memoryBudget)
+                {
+                    return;
+                }
+                std::memset(pBudget->heapBudget, 0, sizeof(pBudget->heapBudget));
+                std::memset(pBudget->heapUsage, 0, sizeof(pBudget->heapUsage));
+                pBudget->heapBudget[0] = config.deviceHeapBudget;
+                pBudget->heapUsage[0] = config.deviceHeapUsage + stats.deviceMemory;
+                pBudget->heapBudget[1] = hostHeapSize;
+            }
+
+            void VKAPI_CALL GetPhysicalDeviceProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties* pProperties)
+            {
+                std::memset(pProperties, 0, sizeof(VkPhysicalDeviceProperties));
+                pProperties->apiVersion = config.apiVersion;
+                pProperties->driverVersion = 1;
+                pProperties->vendorID = vendorID;
+                pProperties->deviceID = deviceID;
+                pProperties->deviceType = VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU;
+                std::strcpy(pProperties->deviceName, "vkBasalt mock driver");
+                for(uint32_t i=0;i<VK_UUID_SIZE;i++)
+                {
+                    pProperties->pipelineCacheUUID[i] = i;
+                }
+                pProperties->limits.maxImageDimension2D = 16384;
+                pProperties->limits.maxMemoryAllocationCount = 4096;
+                pProperties->limits.bufferImageGranularity = config.bufferImageGranularity;
+                pProperties->limits.nonCoherentAtomSize = 64;
+            }
+
+            void VKAPI_CALL GetPhysicalDeviceFeatures2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures2* pFeatures)
+            {
+                std::memset(&pFeatures->features, 0, sizeof(VkPhysicalDeviceFeatures));
+                VkPhysicalDeviceTimelineSemaphoreFeatures* pTimeline = findInChain<VkPhysicalDeviceTimelineSemaphoreFeatures>(pFeatures->pNext, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES);
+                if(pTimeline != nullptr)
+                {
+                    pTimeline->timelineSemaphore = config.timelineSemaphores ? VK_TRUE : VK_FALSE;
+                }
+            }
+
+            void VKAPI_CALL GetPhysicalDeviceFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format, VkFormatProperties* pFormatProperties)
+            {
+                pFormatProperties->linearTilingFeatures = ~0u;
+                pFormatProperties->optimalTilingFeatures = ~0u;
+                pFormatProperties->bufferFeatures = ~0u;
+            }
+
+            VkResult VKAPI_CALL GetPhysicalDeviceSurfaceCapabilitiesKHR(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, VkSurfaceCapabilitiesKHR* pSurfaceCapabilities)
+            {
+                std::memset(pSurfaceCapabilities, 0, sizeof(VkSurfaceCapabilitiesKHR));
+                pSurfaceCapabilities->minImageCount = config.minSwapchainImageCount;
+                pSurfaceCapabilities->maxImageCount = 8;
+                pSurfaceCapabilities->currentExtent = {0xffffffff, 0xffffffff};
+                pSurfaceCapabilities->minImageExtent = {1, 1};
+                pSurfaceCapabilities->maxImageExtent = {16384, 16384};
+                pSurfaceCapabilities->maxImageArrayLayers = 1;
+                pSurfaceCapabilities->supportedUsageFlags = config.surfaceUsage;
+                return VK_SUCCESS;
+            }
+
+            VkResult VKAPI_CALL CreateDevice(VkPhysicalDevice physicalDevice, const VkDeviceCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDevice* pDevice)
+            {
+                Device* pRecord = new Device();
+                pRecord->loaderData = pRecord;
+                for(uint32_t i=0;i<config.queueFamilyCount*config.queueCount;i++)
+                {
+                    pRecord->queues.push_back(new DispatchableObject{pRecord});
+                }
+                *pDevice = (VkDevice) pRecord;
+                return VK_SUCCESS;
+            }
+
+            // device
+
+            void VKAPI_CALL DestroyDevice(VkDevice device, const VkAllocationCallbacks* pAllocator)
+            {
+                Device* pRecord = (Device*) device;
+                for(DispatchableObject* pQueue : pRecord->queues)
+                {
+                    delete pQueue;
+                }
+                delete pRecord;
+            }
+
+            void VKAPI_CALL GetDeviceQueue(VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex, VkQueue* pQueue)
+            {
+                *pQueue = (VkQueue) ((Device*) device)->queues[queueFamilyIndex * config.queueCount + queueIndex];
+            }
+
+            void VKAPI_CALL GetDeviceQueue2(VkDevice device, const VkDeviceQueueInfo2* pQueueInfo, VkQueue* pQueue)
+            {
+                GetDeviceQueue(device, pQueueInfo->queueFamilyIndex, pQueueInfo->queueIndex, pQueue);
+            }
+
+            VkResult VKAPI_CALL QueueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence)
+            {
+                for(uint32_t i=0;i<submitCount;i++)
+                {
+                    const VkSubmitInfo& submit = pSubmits[i];
+                    for(uint32_t j=0;j<submit.commandBufferCount;j++)
+                    {
+                        const CommandBuffer* pCommandBuffer = (const CommandBuffer*) submit.pCommandBuffers[j];
+                        if(pCommandBuffer->drawCount > 0)
+                        {
+                            stats.effectCommandBuffers++;
+                        }
+                        else if(pCommandBuffer->uploadCount > 0)
+                        {
+                            stats.uploadCommandBuffers++;
+                        }
+                        else if(pCommandBuffer->imageCopyCount > 0)
+                        {
+                            stats.copyCommandBuffers++;
+                        }
+                    }
+                    const VkTimelineSemaphoreSubmitInfo* pTimelineInfo = findInChain<const VkTimelineSemaphoreSubmitInfo>(submit.pNext, VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO);
+                    for(uint32_t j=0;j<submit.signalSemaphoreCount;j++)
+                    {
+                        Semaphore* pSemaphore = fromHandle<Semaphore>(submit.pSignalSemaphores[j]);
+                        if(pSemaphore->timeline && pTimelineInfo != nullptr && j < pTimelineInfo->signalSemaphoreValueCount)
+                        {
+                            pSemaphore->value = pTimelineInfo->pSignalSemaphoreValues[j];
+                        }
+                    }
+                }
+                if(fence != VK_NULL_HANDLE)
+                {
+                    fromHandle<Fence>(fence)->signaled = true;
+                }
+                stats.submits++;
+                stats.lastSubmitQueue = queue;
+                return VK_SUCCESS;
+            }
+
+            VkResult VKAPI_CALL QueueWaitIdle(VkQueue queue)
+            {
+                return VK_SUCCESS;
+            }
+
+            VkResult VKAPI_CALL DeviceWaitIdle(VkDevice device)
+            {
+                return VK_SUCCESS;
+            }
+
+            VkResult VKAPI_CALL CreateFence(VkDevice device, const VkFenceCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkFence* pFence)
+            {
+                Fence* pRecord = createObject<Fence>(ObjectType::Fence);
+                pRecord->signaled = (pCreateInfo->flags & VK_FENCE_CREATE_SIGNALED_BIT) != 0;
+                *pFence = toHandle<VkFence>(pRecord);
+                return VK_SUCCESS;
+            }
+
+            void VKAPI_CALL DestroyFence(VkDevice device, VkFence fence, const VkAllocationCallbacks* pAllocator)
+            {
+                destroyObject(fromHandle<Fence>(fence));
+            }
+
+            VkResult VKAPI_CALL GetFenceStatus(VkDevice device, VkFence fence)
+            {
+                return fromHandle<Fence>(fence)->signaled ? VK_SUCCESS : VK_NOT_READY;
+            }
+
+            VkResult VKAPI_CALL WaitForFences(VkDevice device, uint32_t fenceCount, const VkFence* pFences, VkBool32 waitAll, uint64_t timeout)
+            {
+                //work is done when it is submitted, a fence that is not signaled yet never will be
+                for(uint32_t i=0;i<fenceCount;i++)
+                {
+                    if(!fromHandle<Fence>(pFences[i])->signaled)
+                    {
+                        return VK_TIMEOUT;
+                    }
+                }
+                return VK_SUCCESS;
+            }
+
+            VkResult VKAPI_CALL ResetFences(VkDevice device, uint32_t fenceCount, const VkFence* pFences)
+            {
+                for(uint32_t i=0;i<fenceCount;i++)
+                {
+                    fromHandle<Fence>(pFences[i])->signaled = false;
+                }
+                return VK_SUCCESS;
+            }
+
+            VkResult VKAPI_CALL AllocateMemory(VkDevice device, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks* pAllocator, VkDeviceMemory* pMemory)
+            {
+                if(pAllocateInfo->memoryTypeIndex == 0)
+                {
+                    //allocations from several threads may both fit, the heap size is only a limit for the tests
+                    if(stats.deviceMemory + pAllocateInfo->allocationSize > config.deviceHeapSize)
+                    {
+                        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+                    }
+                    VkDeviceSize deviceMemory = stats.deviceMemory += pAllocateInfo->allocationSize;
+                    VkDeviceSize peak = stats.peakDeviceMemory;
+                    while(deviceMemory > peak && !stats.peakDeviceMemory.compare_exchange_weak(peak, deviceMemory))
+                    {
+                    }
+                }
+                Memory* pRecord = createObject<Memory>(ObjectType::Memory);
+                pRecord->size = pAllocateInfo->allocationSize;
+                pRecord->memoryTypeIndex = pAllocateInfo->memoryTypeIndex;
+                pRecord->pHostData = nullptr;
+                *pMemory = toHandle<VkDeviceMemory>(pRecord);
+                return VK_SUCCESS;
+            }
+
+            void VKAPI_CALL FreeMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks* pAllocator)
+            {
+                Memory* pRecord = fromHandle<Memory>(memory);
+                if(pRecord == nullptr)
+                {
+                    return;
+                }
+                if(pRecord->memoryTypeIndex == 0)
+                {
+                    stats.deviceMemory -= pRecord->size;
+                }
+                std::free(pRecord->pHostData);
+                destroyObject(pRecord);
+            }
+
+            VkResult VKAPI_CALL MapMemory(VkDevice device, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, VkFlags flags, void** ppData)
+            {
+                Memory* pRecord = fromHandle<Memory>(memory);
+                if(pRecord->memoryTypeIndex != 1)
+                {
+                    return VK_ERROR_MEMORY_MAP_FAILED;
+                }
+                if(pRecord->pHostData == nullptr)
+                {
+                    pRecord->pHostData = std::calloc(pRecord->size, 1);
+                }
+                *ppData = (char*) pRecord->pHostData + offset;
+                return VK_SUCCESS;
+            }
+
+            void VKAPI_CALL UnmapMemory(VkDevice device, VkDeviceMemory memory)
+            {
+            }
+
+            VkResult VKAPI_CALL BindBufferMemory(VkDevice device, VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+            {
+                return memoryOffset + fromHandle<Buffer>(buffer)->size <= fromHandle<Memory>(memory)->size ? VK_SUCCESS : VK_ERROR_OUT_OF_DEVICE_MEMORY;
+            }
+
+            VkResult VKAPI_CALL BindImageMemory(VkDevice device, VkImage image, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+            {
+                const Image* pImage = fromHandle<Image>(image);
+                if(memoryOffset % imageAlignment != 0)
+                {
+                    return VK_ERROR_VALIDATION_FAILED_EXT;
+                }
+                return memoryOffset + getImageSize(pImage) <= fromHandle<Memory>(memory)->size ? VK_SUCCESS : VK_ERROR_OUT_OF_DEVICE_MEMORY;
+            }
+
+            void VKAPI_CALL GetBufferMemoryRequirements(VkDevice device, VkBuffer buffer, VkMemoryRequirements* pMemoryRequirements)
+            {
+                pMemoryRequirements->size = fromHandle<Buffer>(buffer)->size;
+                pMemoryRequirements->alignment = 256;
+                pMemoryRequirements->memoryTypeBits = 0x3;
+            }
+
+            void VKAPI_CALL GetImageMemoryRequirements(VkDevice device, VkImage image, VkMemoryRequirements* pMemoryRequirements)
+            {
+                pMemoryRequirements->size = getImageSize(fromHandle<Image>(image));
+                pMemoryRequirements->alignment = imageAlignment;
+                pMemoryRequirements->memoryTypeBits = 0x3;
+            }
+
+            void VKAPI_CALL GetImageMemoryRequirements2(VkDevice device, const VkImageMemoryRequirementsInfo2* pInfo, VkMemoryRequirements2* pMemoryRequirements)
+            {
+                GetImageMemoryRequirements(device, pInfo->image, &pMemoryRequirements->memoryRequirements);
+                VkMemoryDedicatedRequirements* pDedicated = findInChain<VkMemoryDedicatedRequirements>(pMemoryRequirements->pNext, VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS);
+                if(pDedicated != nullptr)
+                {
+                    pDedicated->prefersDedicatedAllocation = config.prefersDedicated ? VK_TRUE : VK_FALSE;
+                    pDedicated->requiresDedicatedAllocation = VK_FALSE;
+                }
+            }
+
+            void VKAPI_CALL GetBufferMemoryRequirements2(VkDevice device, const VkBufferMemoryRequirementsInfo2* pInfo, VkMemoryRequirements2* pMemoryRequirements)
+            {
+                GetBufferMemoryRequirements(device, pInfo->buffer, &pMemoryRequirements->memoryRequirements);
+            }
+
+            VkResult VKAPI_CALL CreateSemaphore(VkDevice device, const VkSemaphoreCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSemaphore* pSemaphore)
+            {
+                Semaphore* pRecord = createObject<Semaphore>(ObjectType::Semaphore);
+                const VkSemaphoreTypeCreateInfo* pTypeInfo = findInChain<const VkSemaphoreTypeCreateInfo>(pCreateInfo->pNext, VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO);
+                pRecord->timeline = pTypeInfo != nullptr && pTypeInfo->semaphoreType == VK_SEMAPHORE_TYPE_TIMELINE;
+                pRecord->value = pRecord->timeline ? pTypeInfo->initialValue : 0;
+                *pSemaphore = toHandle<VkSemaphore>(pRecord);
+                return VK_SUCCESS;
+            }
+
+            void VKAPI_CALL DestroySemaphore(VkDevice device, VkSemaphore semaphore, const VkAllocationCallbacks* pAllocator)
+            {
+                destroyObject(fromHandle<Semaphore>(semaphore));
+            }
+
+            VkResult VKAPI_CALL GetSemaphoreCounterValue(VkDevice device, VkSemaphore semaphore, uint64_t* pValue)
+            {
+                *pValue = fromHandle<Semaphore>(semaphore)->value;
+                return VK_SUCCESS;
+            }
+
+            VkResult VKAPI_CALL WaitSemaphores(VkDevice device, const VkSemaphoreWaitInfo* pWaitInfo, uint64_t timeout)
+            {
+                for(uint32_t i=0;i<pWaitInfo->semaphoreCount;i++)
+                {
+                    if(fromHandle<Semaphore>(pWaitInfo->pSemaphores[i])->value < pWaitInfo->pValues[i])
+                    {
+                        return VK_TIMEOUT;
+                    }
+                }
+                return VK_SUCCESS;
+            }
+
+            VkResult VKAPI_CALL CreateBuffer(VkDevice device, const VkBufferCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkBuffer* pBuffer)
+            {
+                Buffer* pRecord = createObject<Buffer>(ObjectType::Buffer);
+                pRecord->size = pCreateInfo->size;
+                *pBuffer = toHandle<VkBuffer>(pRecord);
+                return VK_SUCCESS;
+            }
+
+            void VKAPI_CALL DestroyBuffer(VkDevice device, VkBuffer buffer, const VkAllocationCallbacks* pAllocator)
+            {
+                destroyObject(fromHandle<Buffer>(buffer));
+            }
+
+            VkResult VKAPI_CALL CreateImage(VkDevice device, const VkImageCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkImage* pImage)
+            {
+                Image* pRecord = createObject<Image>(ObjectType::Image);
+                pRecord->extent = pCreateInfo->extent;
+                pRecord->format = pCreateInfo->format;
+                pRecord->arrayLayers = pCreateInfo->arrayLayers;
+                *pImage = toHandle<VkImage>(pRecord);
+                return VK_SUCCESS;
+            }
+
+            void VKAPI_CALL DestroyImage(VkDevice device, VkImage image, const VkAllocationCallbacks* pAllocator)
+            {
+                destroyObject(fromHandle<Image>(image));
+            }
+
+            VkResult VKAPI_CALL CreateImageView(VkDevice device, const VkImageViewCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkImageView* pView)
+            {
+                return createHandle(ObjectType::ImageView, pView);
+            }
+
+            void VKAPI_CALL DestroyImageView(VkDevice device, VkImageView imageView, const VkAllocationCallbacks* pAllocator)
+            {
+                destroyHandle(imageView);
+            }
+
+            VkResult VKAPI_CALL CreateShaderModule(VkDevice device, const VkShaderModuleCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkShaderModule* pShaderModule)
+            {
+                return createHandle(ObjectType::ShaderModule, pShaderModule);
+            }
+
+            void VKAPI_CALL DestroyShaderModule(VkDevice device, VkShaderModule shaderModule, const VkAllocationCallbacks* pAllocator)
+            {
+                destroyHandle(shaderModule);
+            }
+
+            VkResult VKAPI_CALL CreatePipelineCache(VkDevice device, const VkPipelineCacheCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkPipelineCache* pPipelineCache)
+            {
+                PipelineCache* pRecord = createObject<PipelineCache>(ObjectType::PipelineCache);
+                const char* pInitialData = (const char*) pCreateInfo->pInitialData;
+                pRecord->data.assign(pInitialData, pInitialData + pCreateInfo->initialDataSize);
+                stats.pipelineCacheInitialDataSize = pCreateInfo->initialDataSize;
+                *pPipelineCache = toHandle<VkPipelineCache>(pRecord);
+                return VK_SUCCESS;
+            }
+
+            void VKAPI_CALL DestroyPipelineCache(VkDevice device, VkPipelineCache pipelineCache, const VkAllocationCallbacks* pAllocator)
+            {
+                destroyObject(fromHandle<PipelineCache>(pipelineCache));
+            }
+
+            VkResult VKAPI_CALL GetPipelineCacheData(VkDevice device, VkPipelineCache pipelineCache, size_t* pDataSize, void* pData)
+            {
+                if(pData == nullptr)
+                {
+                    *pDataSize = pipelineCacheDataSize;
+                    return VK_SUCCESS;
+                }
+                if(*pDataSize < pipelineCacheDataSize)
+                {
+                    *pDataSize = 0;
+                    return VK_INCOMPLETE;
+                }
+                std::memset(pData, 0x5a, pipelineCacheDataSize);
+                fillPipelineCacheHeader((char*) pData);
+                *pDataSize = pipelineCacheDataSize;
+                return VK_SUCCESS;
+            }
+
+            VkResult VKAPI_CALL CreateGraphicsPipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines)
+            {
+                for(uint32_t i=0;i<createInfoCount;i++)
+                {
+                    std::this_thread::sleep_for(config.pipelineCompileTime);
+                    createHandle(ObjectType::Pipeline, &pPipelines[i]);
+                }
+                return VK_SUCCESS;
+            }
+
+            void VKAPI_CALL DestroyPipeline(VkDevice device, VkPipeline pipeline, const VkAllocationCallbacks* pAllocator)
+            {
+                destroyHandle(pipeline);
+            }
+
+            VkResult VKAPI_CALL CreatePipelineLayout(VkDevice device, const VkPipelineLayoutCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkPipelineLayout* pPipelineLayout)
+            {
+                return createHandle(ObjectType::PipelineLayout, pPipelineLayout);
+            }
+
+            void VKAPI_CALL DestroyPipelineLayout(VkDevice device, VkPipelineLayout pipelineLayout, const VkAllocationCallbacks* pAllocator)
+            {
+                destroyHandle(pipelineLayout);
+            }
+
+            VkResult VKAPI_CALL CreateSampler(VkDevice device, const VkSamplerCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSampler* pSampler)
+            {
+                return createHandle(ObjectType::Sampler, pSampler);
+            }
+
+            void VKAPI_CALL DestroySampler(VkDevice device, VkSampler sampler, const VkAllocationCallbacks* pAllocator)
+            {
+                destroyHandle(sampler);
+            }
+
+            VkResult VKAPI_CALL CreateDescriptorSetLayout(VkDevice device, const VkDescriptorSetLayoutCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDescriptorSetLayout* pSetLayout)
+            {
+                return createHandle(ObjectType::DescriptorSetLayout, pSetLayout);
+            }
+
+            void VKAPI_CALL DestroyDescriptorSetLayout(VkDevice device, VkDescriptorSetLayout descriptorSetLayout, const VkAllocationCallbacks* pAllocator)
+            {
+                destroyHandle(descriptorSetLayout);
+            }
+
+            VkResult VKAPI_CALL CreateDescriptorPool(VkDevice device, const VkDescriptorPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDescriptorPool* pDescriptorPool)
+            {
+                return createHandle(ObjectType::DescriptorPool, pDescriptorPool);
+            }
+
+            void VKAPI_CALL DestroyDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool, const VkAllocationCallbacks* pAllocator)
+            {
+                destroyHandle(descriptorPool);
+            }
+
+            VkResult VKAPI_CALL AllocateDescriptorSets(VkDevice device, const VkDescriptorSetAllocateInfo* pAllocateInfo, VkDescriptorSet* pDescriptorSets)
+            {
+                //the sets are never looked at, they only have to be distinct and not null
+                static std::atomic<uintptr_t> nextSet{1};
+                for(uint32_t i=0;i<pAllocateInfo->descriptorSetCount;i++)
+                {
+                    pDescriptorSets[i] = toHandle<VkDescriptorSet>((void*) (nextSet++ * 16));
+                }
+                return VK_SUCCESS;
+            }
+
+            void VKAPI_CALL UpdateDescriptorSets(VkDevice device, uint32_t descriptorWriteCount, const VkWriteDescriptorSet* pDescriptorWrites, uint32_t descriptorCopyCount, const VkCopyDescriptorSet* pDescriptorCopies)
+            {
+            }
+
+            VkResult VKAPI_CALL CreateFramebuffer(VkDevice device, const VkFramebufferCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkFramebuffer* pFramebuffer)
+            {
+                return createHandle(ObjectType::Framebuffer, pFramebuffer);
+            }
+
+            void VKAPI_CALL DestroyFramebuffer(VkDevice device, VkFramebuffer framebuffer, const VkAllocationCallbacks* pAllocator)
+            {
+                destroyHandle(framebuffer);
+            }
+
+            VkResult VKAPI_CALL CreateRenderPass(VkDevice device, const VkRenderPassCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkRenderPass* pRenderPass)
+            {
+                return createHandle(ObjectType::RenderPass, pRenderPass);
+            }
+
+            void VKAPI_CALL DestroyRenderPass(VkDevice device, VkRenderPass renderPass, const VkAllocationCallbacks* pAllocator)
+            {
+                destroyHandle(renderPass);
+            }
+
+            VkResult VKAPI_CALL CreateCommandPool(VkDevice device, const VkCommandPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkCommandPool* pCommandPool)
+            {
+                *pCommandPool = toHandle<VkCommandPool>(createObject<CommandPool>(ObjectType::CommandPool));
+                return VK_SUCCESS;
+            }
+
+            void VKAPI_CALL DestroyCommandPool(VkDevice device, VkCommandPool commandPool, const VkAllocationCallbacks* pAllocator)
+            {
+                CommandPool* pRecord = fromHandle<CommandPool>(commandPool);
+                if(pRecord == nullptr)
+                {
+                    return;
+                }
+                for(CommandBuffer* pCommandBuffer : pRecord->commandBuffers)
+                {
+                    destroyObject(pCommandBuffer);
+                }
+                destroyObject(pRecord);
+            }
+
+            VkResult VKAPI_CALL AllocateCommandBuffers(VkDevice device, const VkCommandBufferAllocateInfo* pAllocateInfo, VkCommandBuffer* pCommandBuffers)
+            {
+                CommandPool* pPool = fromHandle<CommandPool>(pAllocateInfo->commandPool);
+                for(uint32_t i=0;i<pAllocateInfo->commandBufferCount;i++)
+                {
+                    CommandBuffer* pRecord = createObject<CommandBuffer>(ObjectType::CommandBuffer);
+                    pRecord->loaderData = ((Device*) device)->loaderData;
+                    pPool->commandBuffers.push_back(pRecord);
+                    pCommandBuffers[i] = (VkCommandBuffer) pRecord;
+                }
+                return VK_SUCCESS;
+            }
+
+            void VKAPI_CALL FreeCommandBuffers(VkDevice device, VkCommandPool commandPool, uint32_t commandBufferCount, const VkCommandBuffer* pCommandBuffers)
+            {
+                CommandPool* pPool = fromHandle<CommandPool>(commandPool);
+                for(uint32_t i=0;i<commandBufferCount;i++)
+                {
+                    CommandBuffer* pRecord = (CommandBuffer*) pCommandBuffers[i];
+                    auto found = std::find(pPool->commandBuffers.begin(), pPool->commandBuffers.end(), pRecord);
+                    if(found != pPool->commandBuffers.end())
+                    {
+                        pPool->commandBuffers.erase(found);
+                        destroyObject(pRecord);
+                    }
+                }
+            }
+
+            VkResult VKAPI_CALL BeginCommandBuffer(VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo* pBeginInfo)
+            {
+                CommandBuffer* pRecord = (CommandBuffer*) commandBuffer;
+                pRecord->drawCount = 0;
+                pRecord->imageCopyCount = 0;
+                pRecord->uploadCount = 0;
+                return VK_SUCCESS;
+            }
+
+            VkResult VKAPI_CALL EndCommandBuffer(VkCommandBuffer commandBuffer)
+            {
+                return VK_SUCCESS;
+            }
+
+            void VKAPI_CALL CmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline)
+            {
+            }
+
+            void VKAPI_CALL CmdSetViewport(VkCommandBuffer commandBuffer, uint32_t firstViewport, uint32_t viewportCount, const VkViewport* pViewports)
+            {
+            }
+
+            void VKAPI_CALL CmdSetScissor(VkCommandBuffer commandBuffer, uint32_t firstScissor, uint32_t scissorCount, const VkRect2D* pScissors)
+            {
+            }
+
+            void VKAPI_CALL CmdBindDescriptorSets(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t descriptorSetCount, const VkDescriptorSet* pDescriptorSets, uint32_t dynamicOffsetCount, const uint32_t* pDynamicOffsets)
+            {
+            }
+
+            void VKAPI_CALL CmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+            {
+                ((CommandBuffer*) commandBuffer)->drawCount++;
+            }
+
+            void VKAPI_CALL CmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* pValues)
+            {
+            }
+
+            void VKAPI_CALL CmdCopyImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkImageCopy* pRegions)
+            {
+                ((CommandBuffer*) commandBuffer)->imageCopyCount++;
+            }
+
+            void VKAPI_CALL CmdCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkBufferImageCopy* pRegions)
+            {
+                ((CommandBuffer*) commandBuffer)->uploadCount++;
+            }
+
+            void VKAPI_CALL CmdPipelineBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags, uint32_t memoryBarrierCount, const VkMemoryBarrier* pMemoryBarriers, uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier* pBufferMemoryBarriers, uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier* pImageMemoryBarriers)
+            {
+            }
+
+            void VKAPI_CALL CmdBeginRenderPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo* pRenderPassBegin, VkSubpassContents contents)
+            {
+            }
+
+            void VKAPI_CALL CmdEndRenderPass(VkCommandBuffer commandBuffer)
+            {
+            }
+
+            VkResult VKAPI_CALL CreateSwapchainKHR(VkDevice device, const VkSwapchainCreateInfoKHR* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSwapchainKHR* pSwapchain)
+            {
+                Swapchain* pRecord = new Swapchain();
+                uint32_t imageCount = std::max(pCreateInfo->minImageCount, config.minSwapchainImageCount);
+                for(uint32_t i=0;i<imageCount;i++)
+                {
+                    Image* pImage = new Image();
+                    pImage->type = ObjectType::Image;
+                    pImage->extent = {pCreateInfo->imageExtent.width, pCreateInfo->imageExtent.height, 1};
+                    pImage->format = pCreateInfo->imageFormat;
+                    pImage->arrayLayers = 1;
+                    pRecord->images.push_back(pImage);
+                }
+                stats.swapchainUsage = pCreateInfo->imageUsage;
+                *pSwapchain = toHandle<VkSwapchainKHR>(pRecord);
+                return VK_SUCCESS;
+            }
+
+            void VKAPI_CALL DestroySwapchainKHR(VkDevice device, VkSwapchainKHR swapchain, const VkAllocationCallbacks* pAllocator)
+            {
+                Swapchain* pRecord = fromHandle<Swapchain>(swapchain);
+                if(pRecord == nullptr)
+                {
+                    return;
+                }
+                for(Image* pImage : pRecord->images)
+                {
+                    delete pImage;
+                }
+                delete pRecord;
+            }
+
+            VkResult VKAPI_CALL GetSwapchainImagesKHR(VkDevice device, VkSwapchainKHR swapchain, uint32_t* pSwapchainImageCount, VkImage* pSwapchainImages)
+            {
+                const std::vector<Image*>& images = fromHandle<Swapchain>(swapchain)->images;
+                if(pSwapchainImages == nullptr)
+                {
+                    *pSwapchainImageCount = images.size();
+                    return VK_SUCCESS;
+                }
+                uint32_t count = std::min<uint32_t>(*pSwapchainImageCount, images.size());
+                for(uint32_t i=0;i<count;i++)
+                {
+                    pSwapchainImages[i] = toHandle<VkImage>(images[i]);
+                }
+                *pSwapchainImageCount = count;
+                return count < images.size() ? VK_INCOMPLETE : VK_SUCCESS;
+            }
+
+            VkResult VKAPI_CALL QueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* pPresentInfo)
+            {
+                for(uint32_t i=0;i<pPresentInfo->swapchainCount && pPresentInfo->pResults;i++)
+                {
+                    pPresentInfo->pResults[i] = VK_SUCCESS;
+                }
+                stats.presents++;
+                return VK_SUCCESS;
+            }
+        }
+
+        void reset(const DriverConfig& newConfig)
+        {
+            config = newConfig;
+            for(uint32_t i=0;i<(uint32_t) ObjectType::Count;i++)
+            {
+                stats.created[i] = 0;
+                stats.alive[i] = 0;
+            }
+            stats.deviceMemory = 0;
+            stats.peakDeviceMemory = 0;
+            stats.submits = 0;
+            stats.presents = 0;
+            stats.lastSubmitQueue = VK_NULL_HANDLE;
+            stats.effectCommandBuffers = 0;
+            stats.copyCommandBuffers = 0;
+            stats.uploadCommandBuffers = 0;
+            stats.swapchainUsage = 0;
+            stats.pipelineCacheInitialDataSize = 0;
+        }
+
+        uint32_t getCreatedCount(ObjectType type)
+        {
+            return stats.created[(uint32_t) type];
+        }
+
+        uint32_t getAliveCount(ObjectType type)
+        {
+            return stats.alive[(uint32_t) type];
+        }
+
+        uint32_t getAliveCount()
+        {
+            uint32_t count = 0;
+            for(uint32_t i=0;i<(uint32_t) ObjectType::Count;i++)
+            {
+                count += stats.alive[i];
+            }
+            return count;
+        }
+
+        size_t getPipelineCacheDataSize()
+        {
+            return pipelineCacheDataSize;
+        }
+
+#define MOCK_PROC(func) if(!std::strcmp(pName, "vk" #func)) return (PFN_vkVoidFunction) &func;
+#define MOCK_PROC_ALIAS(func, alias) if(!std::strcmp(pName, "vk" #alias)) return (PFN_vkVoidFunction) &func;
+
+        PFN_vkVoidFunction VKAPI_CALL getDeviceProcAddr(VkDevice device, const char* pName)
+        {
+            if(!std::strcmp(pName, "vkGetDeviceProcAddr"))
+            {
+                return (PFN_vkVoidFunction) &getDeviceProcAddr;
+            }
+            MOCK_PROC(DestroyDevice);
+            MOCK_PROC(GetDeviceQueue);
+            MOCK_PROC(GetDeviceQueue2);
+            MOCK_PROC(QueueSubmit);
+            MOCK_PROC(QueueWaitIdle);
+            MOCK_PROC(DeviceWaitIdle);
+            MOCK_PROC(CreateFence);
+            MOCK_PROC(DestroyFence);
+            MOCK_PROC(GetFenceStatus);
+            MOCK_PROC(WaitForFences);
+            MOCK_PROC(ResetFences);
+            MOCK_PROC(AllocateMemory);
+            MOCK_PROC(FreeMemory);
+            MOCK_PROC(MapMemory);
+            MOCK_PROC(UnmapMemory);
+            MOCK_PROC(BindBufferMemory);
+            MOCK_PROC(BindImageMemory);
+            MOCK_PROC(GetBufferMemoryRequirements);
+            MOCK_PROC(GetImageMemoryRequirements);
+            MOCK_PROC(GetImageMemoryRequirements2);
+            MOCK_PROC_ALIAS(GetImageMemoryRequirements2, GetImageMemoryRequirements2KHR);
+            MOCK_PROC(GetBufferMemoryRequirements2);
+            MOCK_PROC_ALIAS(GetBufferMemoryRequirements2, GetBufferMemoryRequirements2KHR);
+            MOCK_PROC(CreateSemaphore);
+            MOCK_PROC(DestroySemaphore);
+            if(config.timelineSemaphores)
+            {
+                MOCK_PROC(GetSemaphoreCounterValue);
+                MOCK_PROC_ALIAS(GetSemaphoreCounterValue, GetSemaphoreCounterValueKHR);
+                MOCK_PROC(WaitSemaphores);
+                MOCK_PROC_ALIAS(WaitSemaphores, WaitSemaphoresKHR);
+            }
+            MOCK_PROC(CreateBuffer);
+            MOCK_PROC(DestroyBuffer);
+            MOCK_PROC(CreateImage);
+            MOCK_PROC(DestroyImage);
+            MOCK_PROC(CreateImageView);
+            MOCK_PROC(DestroyImageView);
+            MOCK_PROC(CreateShaderModule);
+            MOCK_PROC(DestroyShaderModule);
+            MOCK_PROC(CreatePipelineCache);
+            MOCK_PROC(DestroyPipelineCache);
+            MOCK_PROC(GetPipelineCacheData);
+            MOCK_PROC(CreateGraphicsPipelines);
+            MOCK_PROC(DestroyPipeline);
+            MOCK_PROC(CreatePipelineLayout);
+            MOCK_PROC(DestroyPipelineLayout);
+            MOCK_PROC(CreateSampler);
+            MOCK_PROC(DestroySampler);
+            MOCK_PROC(CreateDescriptorSetLayout);
+            MOCK_PROC(DestroyDescriptorSetLayout);
+            MOCK_PROC(CreateDescriptorPool);
+            MOCK_PROC(DestroyDescriptorPool);
+            MOCK_PROC(AllocateDescriptorSets);
+            MOCK_PROC(UpdateDescriptorSets);
+            MOCK_PROC(CreateFramebuffer);
+            MOCK_PROC(DestroyFramebuffer);
+            MOCK_PROC(CreateRenderPass);
+            MOCK_PROC(DestroyRenderPass);
+            MOCK_PROC(CreateCommandPool);
+            MOCK_PROC(DestroyCommandPool);
+            MOCK_PROC(AllocateCommandBuffers);
+            MOCK_PROC(FreeCommandBuffers);
+            MOCK_PROC(BeginCommandBuffer);
+            MOCK_PROC(EndCommandBuffer);
+            MOCK_PROC(CmdBindPipeline);
+            MOCK_PROC(CmdSetViewport);
+            MOCK_PROC(CmdSetScissor);
+            MOCK_PROC(CmdBindDescriptorSets);
+            MOCK_PROC(CmdDraw);
+            MOCK_PROC(CmdPushConstants);
+            MOCK_PROC(CmdCopyImage);
+            MOCK_PROC(CmdCopyBufferToImage);
+            MOCK_PROC(CmdPipelineBarrier);
+            MOCK_PROC(CmdBeginRenderPass);
+            MOCK_PROC(CmdEndRenderPass);
+            MOCK_PROC(CreateSwapchainKHR);
+            MOCK_PROC(DestroySwapchainKHR);
+            MOCK_PROC(GetSwapchainImagesKHR);
+            MOCK_PROC(QueuePresentKHR);
+            return nullptr;
+        }
+
+        PFN_vkVoidFunction VKAPI_CALL getInstanceProcAddr(VkInstance instance, const char* pName)
+        {
+            if(!std::strcmp(pName, "vkGetInstanceProcAddr"))
+            {
+                return (PFN_vkVoidFunction) &getInstanceProcAddr;
+            }
+            MOCK_PROC(CreateInstance);
+            MOCK_PROC(DestroyInstance);
+            MOCK_PROC(EnumeratePhysicalDevices);
+            MOCK_PROC(EnumerateDeviceExtensionProperties);
+            MOCK_PROC(GetPhysicalDeviceQueueFamilyProperties);
+            MOCK_PROC(GetPhysicalDeviceMemoryProperties);
+            MOCK_PROC(GetPhysicalDeviceMemoryProperties2);
+            MOCK_PROC_ALIAS(GetPhysicalDeviceMemoryProperties2, GetPhysicalDeviceMemoryProperties2KHR);
+            MOCK_PROC(GetPhysicalDeviceProperties);
+            MOCK_PROC(GetPhysicalDeviceFeatures2);
+            MOCK_PROC_ALIAS(GetPhysicalDeviceFeatures2, GetPhysicalDeviceFeatures2KHR);
+            MOCK_PROC(GetPhysicalDeviceFormatProperties);
+            MOCK_PROC(GetPhysicalDeviceSurfaceCapabilitiesKHR);
+            MOCK_PROC(CreateDevice);
+            return getDeviceProcAddr((VkDevice) instance, pName);
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef MOCK_DRIVER_HPP_INCLUDED
+#define MOCK_DRIVER_HPP_INCLUDED
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "vulkan/vulkan.h"
+#include "vulkan/vk_layer.h"
+#include "vulkan/vk_layer_dispatch_table.h"
+
+namespace vkBasalt
+{
+    namespace mock
+    {
+        /*
+           a vulkan driver without a gpu, the layer is put on top of it the way the loader would do it
+
+           every object is a small heap record and the handle is its address, so the driver needs no tables
+           and calls on different objects never share any state but the counters
+           work completes when it is submitted: fences get signaled and timeline semaphores take the signaled value
+
+           memory type 0 is device local in heap 0, memory type 1 is host visible and coherent in heap 1
+        */
+        struct DriverConfig
+        {
+            uint32_t apiVersion = VK_API_VERSION_1_2;
+            bool timelineSemaphores = true;
+            bool memoryBudget = true;
+            bool prefersDedicated = false;//vkGetImageMemoryRequirements2 asks for a dedicated allocation for every image
+            VkDeviceSize bufferImageGranularity = 1;
+            VkDeviceSize deviceHeapSize = 4096ull * 1024 * 1024;//vkAllocateMemory fails above it
+            VkDeviceSize deviceHeapBudget = 4096ull * 1024 * 1024;
+            VkDeviceSize deviceHeapUsage = 0;//what the rest of the system uses, the memory the driver handed out is added to it
+            uint32_t queueFamilyCount = 1;//every family can do graphics
+            uint32_t queueCount = 8;//per family
+            uint32_t minSwapchainImageCount = 3;
+            VkImageUsageFlags surfaceUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            std::chrono::milliseconds pipelineCompileTime = std::chrono::milliseconds(0);//vkCreateGraphicsPipelines sleeps this long per pipeline
+        };
+
+        enum class ObjectType : uint32_t
+        {
+            Memory = 0,
+            Buffer,
+            Image,//without the images of the swapchains
+            ImageView,
+            ShaderModule,
+            Sampler,
+            RenderPass,
+            DescriptorSetLayout,
+            DescriptorPool,
+            PipelineLayout,
+            Pipeline,
+            PipelineCache,
+            Framebuffer,
+            CommandPool,
+            CommandBuffer,
+            Semaphore,
+            Fence,
+            Count
+        };
+
+        struct DriverStats
+        {
+            std::atomic<uint32_t> created[(uint32_t) ObjectType::Count];
+            std::atomic<uint32_t> alive[(uint32_t) ObjectType::Count];
+            std::atomic<VkDeviceSize> deviceMemory;//allocated in heap 0
+            std::atomic<VkDeviceSize> peakDeviceMemory;
+            std::atomic<uint64_t> submits;
+            std::atomic<uint64_t> presents;
+            std::atomic<VkQueue> lastSubmitQueue;
+            //the submitted command buffers by what was recorded into them
+            std::atomic<uint64_t> effectCommandBuffers;//draws
+            std::atomic<uint64_t> copyCommandBuffers;//an image copy and no draws
+            std::atomic<uint64_t> uploadCommandBuffers;//a buffer to image copy
+            std::atomic<VkImageUsageFlags> swapchainUsage;//of the last swapchain the driver created
+            std::atomic<size_t> pipelineCacheInitialDataSize;//of the last pipeline cache the driver created
+        };
+
+        extern DriverConfig config;
+        extern DriverStats stats;
+
+        //sets the config and clears the stats, nothing of the driver may be alive
+        void reset(const DriverConfig& newConfig = DriverConfig());
+        uint32_t getCreatedCount(ObjectType type);
+        uint32_t getAliveCount(ObjectType type);
+        //of all types together
+        uint32_t getAliveCount();
+
+        //the pipeline cache data the driver returns and accepts, the header matches the physical device
+        size_t getPipelineCacheDataSize();
+
+        PFN_vkVoidFunction VKAPI_CALL getInstanceProcAddr(VkInstance instance, const char* pName);
+        PFN_vkVoidFunction VKAPI_CALL getDeviceProcAddr(VkDevice device, const char* pName);
+    }
+}
+
+#endif // MOCK_DRIVER_HPP_INCLUDED
@@ -0,0 +1,131 @@
+#include "test.hpp"
+#include "layer_device.hpp"
+
+#include <vector>
+
+#include "object_cache.hpp"
+#include "sampler.hpp"
+#include "renderpass.hpp"
+#include "descriptor_set.hpp"
+#include "shader.hpp"
+
+namespace
+{
+    using vkBasalt::test::LayerDevice;
+    using vkBasalt::mock::ObjectType;
+    using vkBasalt::CachedType;
+
+    VkShaderModule createModule(vkBasalt::LogicalDevice* pLogicalDevice, const std::vector<uint32_t>& code)
+    {
+        VkShaderModuleCreateInfo shaderCreateInfo = {};
+        shaderCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        shaderCreateInfo.codeSize = code.size() * sizeof(uint32_t);
+        shaderCreateInfo.pCode = code.data();
+        VkShaderModule module;
+        pLogicalDevice->dispatchTable.CreateShaderModule(pLogicalDevice->device, &shaderCreateInfo, nullptr, &module);
+        return module;
+    }
+}
+
+TEST(objectCacheSharesObjectsWithTheSameCreateInfo)
+{
+    LayerDevice layerDevice;
+    vkBasalt::LogicalDevice* pLogicalDevice = layerDevice.getLogicalDevice();
+    vkBasalt::ObjectCache& objectCache = pLogicalDevice->objectCache;
+
+    VkSampler sampler = vkBasalt::createSampler(pLogicalDevice);
+    CHECK(vkBasalt::createSampler(pLogicalDevice) == sampler);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::Sampler) == 1);
+
+    //every field of the key counts, the defaults of createRenderPass are part of it
+    VkRenderPass renderPass = vkBasalt::createRenderPass(pLogicalDevice, VK_FORMAT_B8G8R8A8_UNORM);
+    CHECK(vkBasalt::createRenderPass(pLogicalDevice, VK_FORMAT_B8G8R8A8_UNORM, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE) == renderPass);
+    VkRenderPass otherFormat = vkBasalt::createRenderPass(pLogicalDevice, VK_FORMAT_B8G8R8A8_SRGB);
+    VkRenderPass otherLoadOp = vkBasalt::createRenderPass(pLogicalDevice, VK_FORMAT_B8G8R8A8_UNORM, VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+    CHECK(otherFormat != renderPass && otherLoadOp != renderPass && otherFormat != otherLoadOp);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::RenderPass) == 3);
+
+    VkDescriptorSetLayout oneImage = vkBasalt::createImageSamplerDescriptorSetLayout(pLogicalDevice, 1);
+    VkDescriptorSetLayout twoImages = vkBasalt::createImageSamplerDescriptorSetLayout(pLogicalDevice, 2);
+    CHECK(oneImage != twoImages);
+    CHECK(vkBasalt::createImageSamplerDescriptorSetLayout(pLogicalDevice, 2) == twoImages);
+
+    //the object lives until the last reference is released
+    objectCache.release(CachedType::Sampler, sampler);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::Sampler) == 1);
+    objectCache.release(CachedType::Sampler, sampler);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::Sampler) == 0);
+    //a new acquire after that creates the object again
+    sampler = vkBasalt::createSampler(pLogicalDevice);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::Sampler) == 2);
+    objectCache.release(CachedType::Sampler, sampler);
+    objectCache.release(CachedType::Sampler, VK_NULL_HANDLE);
+
+    for(uint32_t i=0;i<2;i++)
+    {
+        objectCache.release(CachedType::RenderPass, renderPass);
+        objectCache.release(CachedType::DescriptorSetLayout, twoImages);
+    }
+    objectCache.release(CachedType::RenderPass, otherFormat);
+    objectCache.release(CachedType::RenderPass, otherLoadOp);
+    objectCache.release(CachedType::DescriptorSetLayout, oneImage);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::RenderPass) == 0);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::DescriptorSetLayout) == 0);
+}
+
+TEST(objectCacheComparesTheContentOfHashedKeys)
+{
+    LayerDevice layerDevice;
+    vkBasalt::LogicalDevice* pLogicalDevice = layerDevice.getLogicalDevice();
+    vkBasalt::ObjectCache& objectCache = pLogicalDevice->objectCache;
+
+    //three contents behind the same hash, the second one equals the first in a different place
+    std::vector<uint32_t> first = {0x07230203, 0x00010000, 1, 2};
+    std::vector<uint32_t> equal = first;
+    std::vector<uint32_t> different = {0x07230203, 0x00010000, 3, 4};
+    const std::string key = "same hash";
+    auto acquire = [&](const std::vector<uint32_t>& code)
+    {
+        return objectCache.acquire<VkShaderModule>(CachedType::ShaderModule, key, [&]()
+        {
+            return createModule(pLogicalDevice, code);
+        }, code.data(), code.size() * sizeof(uint32_t));
+    };
+
+    VkShaderModule firstModule = acquire(first);
+    CHECK(acquire(equal) == firstModule);
+    VkShaderModule differentModule = acquire(different);
+    CHECK(differentModule != firstModule);
+    //the entry behind the collision is found again, and so is the first one
+    CHECK(acquire(different) == differentModule);
+    CHECK(acquire(first) == firstModule);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::ShaderModule) == 2);
+
+    for(uint32_t i=0;i<3;i++)
+    {
+        objectCache.release(CachedType::ShaderModule, firstModule);
+    }
+    //releasing the first entry leaves the one behind the collision alone
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::ShaderModule) == 1);
+    CHECK(acquire(different) == differentModule);
+    for(uint32_t i=0;i<3;i++)
+    {
+        objectCache.release(CachedType::ShaderModule, differentModule);
+    }
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::ShaderModule) == 0);
+}
+
+TEST(objectCacheSharesShaderModulesBetweenEffects)
+{
+    //both cas effects use the full screen triangle and the cas fragment shader
+    LayerDevice layerDevice;
+    vkBasalt::test::setOption("effects", "cas:cas");
+    VkQueue queue = layerDevice.getQueue();
+    VkSwapchainKHR swapchain = layerDevice.createSwapchain({1280, 720});
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::ShaderModule) == 2);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::Sampler) == 1);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::RenderPass) == 1);
+    CHECK(layerDevice.present(queue, swapchain, 0) == VK_SUCCESS);
+    layerDevice.destroySwapchain(swapchain);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::ShaderModule) == 0);
+}
@@ -0,0 +1,154 @@
+#include "test.hpp"
+#include "layer_device.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <cstdlib>
+
+#if __GNUC__ == 7
+#include <experimental/filesystem>
+#define filesystem experimental::filesystem
+#else
+#include <filesystem>
+#endif
+
+namespace
+{
+    using vkBasalt::test::LayerDevice;
+
+    //vendor, device, driver version and pipelineCacheUUID of the mock driver
+    const std::string cacheFileName = "pipeline_cache_ba5a_0001_00000001_000102030405060708090a0b0c0d0e0f.bin";
+
+    //main points XDG_CACHE_HOME into the temporary directory of the run
+    std::string getCacheDirectory()
+    {
+        return std::string(std::getenv("XDG_CACHE_HOME")) + "/vkBasalt";
+    }
+
+    std::string readFile(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void writeFile(const std::string& path, const std::string& data)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << data;
+    }
+
+    //a device that creates the pipelines of the configured effects and saves them when it is destroyed
+    void runDevice()
+    {
+        LayerDevice layerDevice;
+        layerDevice.destroySwapchain(layerDevice.createSwapchain({1280, 720}));
+    }
+
+    size_t getLoadedSize()
+    {
+        LayerDevice layerDevice;
+        return vkBasalt::mock::stats.pipelineCacheInitialDataSize;
+    }
+
+    //sets an environment variable until the end of the scope
+    class ScopedEnvironment
+    {
+    public:
+        ScopedEnvironment(const char* name, const std::string& value)
+            : name(name)
+        {
+            const char* oldValue = std::getenv(name);
+            wasSet = oldValue != nullptr;
+            if(wasSet)
+            {
+                this->oldValue = oldValue;
+            }
+            setenv(name, value.c_str(), 1);
+        }
+        ~ScopedEnvironment()
+        {
+            if(wasSet)
+            {
+                setenv(name, oldValue.c_str(), 1);
+            }
+            else
+            {
+                unsetenv(name);
+            }
+        }
+
+    private:
+        const char* name;
+        std::string oldValue;
+        bool wasSet;
+    };
+}
+
+TEST(pipelineCacheIsSavedAndLoaded)
+{
+    std::string cachePath = getCacheDirectory() + "/" + cacheFileName;
+    std::filesystem::remove_all(getCacheDirectory());
+
+    //a device without pipelines has nothing to save
+    CHECK(getLoadedSize() == 0);
+    CHECK(!std::filesystem::exists(getCacheDirectory()));
+
+    runDevice();
+    CHECK(vkBasalt::mock::stats.pipelineCacheInitialDataSize == 0);
+    CHECK(readFile(cachePath).size() == vkBasalt::mock::getPipelineCacheDataSize());
+    //the temporary file was renamed
+    uint32_t fileCount = 0;
+    for(auto& entry : std::filesystem::directory_iterator(getCacheDirectory()))
+    {
+        (void) entry;
+        fileCount++;
+    }
+    CHECK(fileCount == 1);
+
+    CHECK(getLoadedSize() == vkBasalt::mock::getPipelineCacheDataSize());
+}
+
+TEST(pipelineCacheIgnoresForeignHeaders)
+{
+    std::string cachePath = getCacheDirectory() + "/" + cacheFileName;
+    std::filesystem::remove_all(getCacheDirectory());
+    runDevice();
+    std::string valid = readFile(cachePath);
+    CHECK(valid.size() == vkBasalt::mock::getPipelineCacheDataSize());
+
+    //header version, vendor, device and the first byte of the UUID
+    for(size_t offset : {4, 8, 12, 16})
+    {
+        std::string foreign = valid;
+        foreign[offset] ^= 0x40;
+        writeFile(cachePath, foreign);
+        CHECK(getLoadedSize() == 0);
+    }
+    //a header size smaller than the header or bigger than the file
+    for(char headerSize : {16, 100})
+    {
+        std::string foreign = valid;
+        foreign[0] = headerSize;
+        writeFile(cachePath, foreign);
+        CHECK(getLoadedSize() == 0);
+    }
+    //shorter than a header
+    writeFile(cachePath, valid.substr(0, 20));
+    CHECK(getLoadedSize() == 0);
+
+    //a foreign file is replaced by the next save
+    runDevice();
+    CHECK(readFile(cachePath) == valid);
+}
+
+TEST(pipelineCacheIgnoresARelativeCacheHome)
+{
+    //the base directory spec says a relative XDG_CACHE_HOME is invalid, ~/.cache is used instead
+    std::string home = std::string(std::getenv("XDG_CACHE_HOME")) + "/home";
+    std::filesystem::create_directories(home);
+    ScopedEnvironment homeEnvironment("HOME", home);
+    ScopedEnvironment cacheEnvironment("XDG_CACHE_HOME", "relative");
+    runDevice();
+    CHECK(std::filesystem::exists(home + "/.cache/vkBasalt/" + cacheFileName));
+    CHECK(!std::filesystem::exists("relative"));
+}
@@ -0,0 +1,287 @@
+#include "test.hpp"
+#include "layer_device.hpp"
+#include "allocation_counter.hpp"
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+    using vkBasalt::test::LayerDevice;
+    using vkBasalt::mock::ObjectType;
+
+    //the device level names an application resolves, most of them pass straight through the layer
+    const char* procNames[] = {"vkQueuePresentKHR", "vkCreateImage", "vkCmdDraw", "vkQueueSubmit", "vkGetSwapchainImagesKHR", "vkDestroyBuffer"};
+
+    struct ThreadResult
+    {
+        uint64_t operations = 0;
+        std::chrono::steady_clock::duration lockWait = std::chrono::steady_clock::duration::zero();
+    };
+
+    /*
+       presentThreadCount threads present their own swapchain on their own queue, procThreadCount threads resolve
+       device functions, all of them for the given duration
+
+       with globalLock every call first takes that one mutex, the way every intercepted call of the layer did
+       before the device and swapchain records got their own locks, so the two runs compare the old model to the current one
+    */
+    std::vector<ThreadResult> runConcurrentPresents(LayerDevice& layerDevice,
+                                                    uint32_t presentThreadCount,
+                                                    uint32_t procThreadCount,
+                                                    std::chrono::milliseconds duration,
+                                                    std::mutex* pGlobalLock)
+    {
+        std::vector<VkQueue> queues;
+        std::vector<VkSwapchainKHR> swapchains;
+        for(uint32_t i=0;i<presentThreadCount;i++)
+        {
+            queues.push_back(layerDevice.getQueue(0, i));
+            swapchains.push_back(layerDevice.createSwapchain({1280, 720}));
+        }
+
+        std::vector<ThreadResult> results(presentThreadCount + procThreadCount);
+        std::atomic<bool> start{false};
+        std::atomic<bool> stop{false};
+        auto lockGlobal = [pGlobalLock](ThreadResult& result)
+        {
+            std::unique_lock<std::mutex> lock;
+            if(pGlobalLock != nullptr)
+            {
+                lock = std::unique_lock<std::mutex>(*pGlobalLock, std::try_to_lock);
+                if(!lock.owns_lock())
+                {
+                    std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+                    lock.lock();
+                    result.lockWait += std::chrono::steady_clock::now() - waitStart;
+                }
+            }
+            return lock;
+        };
+
+        std::vector<std::thread> threads;
+        for(uint32_t i=0;i<presentThreadCount;i++)
+        {
+            threads.emplace_back([&, i]()
+            {
+                ThreadResult& result = results[i];
+                while(!start)
+                {
+                }
+                for(uint32_t imageIndex=0;!stop;imageIndex=(imageIndex+1)%3)
+                {
+                    std::unique_lock<std::mutex> lock = lockGlobal(result);
+                    if(layerDevice.present(queues[i], swapchains[i], imageIndex) != VK_SUCCESS)
+                    {
+                        return;
+                    }
+                    result.operations++;
+                }
+            });
+        }
+        for(uint32_t i=0;i<procThreadCount;i++)
+        {
+            threads.emplace_back([&, i]()
+            {
+                ThreadResult& result = results[presentThreadCount + i];
+                while(!start)
+                {
+                }
+                for(uint32_t nameIndex=0;!stop;nameIndex=(nameIndex+1)%(sizeof(procNames)/sizeof(procNames[0])))
+                {
+                    std::unique_lock<std::mutex> lock = lockGlobal(result);
+                    if(layerDevice.getProcAddr(procNames[nameIndex]) == nullptr)
+                    {
+                        return;
+                    }
+                    result.operations++;
+                }
+            });
+        }
+        start = true;
+        std::this_thread::sleep_for(duration);
+        stop = true;
+        for(std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        for(VkSwapchainKHR swapchain : swapchains)
+        {
+            layerDevice.destroySwapchain(swapchain);
+        }
+        return results;
+    }
+
+    void report(const char* name, const std::vector<ThreadResult>& results, uint32_t presentThreadCount, std::chrono::milliseconds duration)
+    {
+        uint64_t presents = 0;
+        uint64_t procs = 0;
+        std::chrono::steady_clock::duration lockWait = std::chrono::steady_clock::duration::zero();
+        for(uint32_t i=0;i<results.size();i++)
+        {
+            (i < presentThreadCount ? presents : procs) += results[i].operations;
+            lockWait += results[i].lockWait;
+        }
+        double seconds = duration.count() / 1000.0;
+        double waitShare = std::chrono::duration<double>(lockWait).count() / (seconds * results.size());
+        std::cout << "    " << name << ": "
+                  << (uint64_t) (presents / seconds) << " presents/s, "
+                  << (uint64_t) (procs / seconds) << " vkGetDeviceProcAddr/s, "
+                  << (uint32_t) (waitShare * 100) << "% of the thread time waiting for the lock" << std::endl;
+    }
+}
+
+TEST(deviceLifecycleLeavesNothingAlive)
+{
+    {
+        LayerDevice layerDevice;
+        VkQueue queue = layerDevice.getQueue();
+        VkSwapchainKHR swapchain = layerDevice.createSwapchain({1280, 720});
+        for(uint32_t i=0;i<10;i++)
+        {
+            CHECK(layerDevice.present(queue, swapchain, i % 3) == VK_SUCCESS);
+        }
+        CHECK(vkBasalt::mock::stats.presents == 10);
+        CHECK(vkBasalt::mock::stats.effectCommandBuffers == 10);
+        layerDevice.destroySwapchain(swapchain);
+    }
+    CHECK(vkBasalt::mock::getAliveCount() == 0);
+}
+
+TEST(presentWithImagesFetchedBeforeTheQueue)
+{
+    //the effects are built when the images are fetched, before the layer saw any queue of the device
+    LayerDevice layerDevice;
+    VkSwapchainKHR swapchain = layerDevice.createSwapchain({1280, 720});
+    VkQueue queue = layerDevice.getQueue();
+    for(uint32_t i=0;i<3;i++)
+    {
+        CHECK(layerDevice.present(queue, swapchain, i) == VK_SUCCESS);
+    }
+    CHECK(vkBasalt::mock::stats.effectCommandBuffers == 3);
+    layerDevice.destroySwapchain(swapchain);
+}
+
+TEST(presentOnAQueueFromGetDeviceQueue2)
+{
+    //the family of a queue from vkGetDeviceQueue2 is known as well, so the effects run on that queue
+    //cas uploads nothing, so the frame is the only submit
+    vkBasalt::mock::DriverConfig driverConfig;
+    driverConfig.queueFamilyCount = 2;
+    LayerDevice layerDevice(driverConfig);
+    vkBasalt::test::setOption("effects", "cas");
+    layerDevice.getQueue();
+    PFN_vkGetDeviceQueue2 getDeviceQueue2 = (PFN_vkGetDeviceQueue2) layerDevice.getProcAddr("vkGetDeviceQueue2");
+    VkDeviceQueueInfo2 queueInfo = {};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_INFO_2;
+    queueInfo.queueFamilyIndex = 1;
+    VkQueue queue;
+    getDeviceQueue2(layerDevice.device, &queueInfo, &queue);
+    VkSwapchainKHR swapchain = layerDevice.createSwapchain({1280, 720});
+    CHECK(layerDevice.present(queue, swapchain, 0) == VK_SUCCESS);
+    CHECK(vkBasalt::mock::stats.effectCommandBuffers == 1);
+    CHECK(vkBasalt::mock::stats.lastSubmitQueue == queue);
+    layerDevice.destroySwapchain(swapchain);
+}
+
+TEST(uploadsRunOnThePresentingQueue)
+{
+    //the smaa textures go in front of the first frame on the presenting queue, even if the graphics queue
+    //the device got first is of another family and the presenting queue was fetched after the swapchain
+    vkBasalt::mock::DriverConfig driverConfig;
+    driverConfig.queueFamilyCount = 2;
+    LayerDevice layerDevice(driverConfig);
+    vkBasalt::test::setOption("effects", "smaa");
+    layerDevice.getQueue();
+    VkSwapchainKHR swapchain = layerDevice.createSwapchain({1280, 720});
+    VkQueue queue = layerDevice.getQueue(1);
+    uint32_t bufferCount = vkBasalt::mock::getAliveCount(ObjectType::Buffer);
+    CHECK(layerDevice.present(queue, swapchain, 0) == VK_SUCCESS);
+    CHECK(vkBasalt::mock::stats.uploadCommandBuffers == 2);
+    CHECK(vkBasalt::mock::stats.effectCommandBuffers == 1);
+    CHECK(vkBasalt::mock::stats.submits == 1);
+    CHECK(vkBasalt::mock::stats.lastSubmitQueue == queue);
+    //the next present sees the frame finished on the timeline and frees the staging buffers, no fence is involved
+    CHECK(layerDevice.present(queue, swapchain, 1) == VK_SUCCESS);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::Buffer) == bufferCount - 2);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::Fence) == 0);
+    layerDevice.destroySwapchain(swapchain);
+}
+
+TEST(concurrentPresentsAndProcLookups)
+{
+    LayerDevice layerDevice;
+    std::vector<ThreadResult> results = runConcurrentPresents(layerDevice, 4, 2, std::chrono::milliseconds(200), nullptr);
+    uint64_t presents = 0;
+    for(uint32_t i=0;i<4;i++)
+    {
+        //a thread that stops early got an error
+        CHECK(results[i].operations > 0);
+        presents += results[i].operations;
+    }
+    CHECK(results[4].operations > 0 && results[5].operations > 0);
+    CHECK(vkBasalt::mock::stats.presents == presents);
+    CHECK(vkBasalt::mock::stats.effectCommandBuffers == presents);
+}
+
+namespace
+{
+    //the first presents submit the uploads of the effects, free their staging buffers and size the scratch storage of the queue
+    uint64_t countSteadyStatePresentAllocations(const vkBasalt::mock::DriverConfig& driverConfig)
+    {
+        LayerDevice layerDevice(driverConfig);
+        VkQueue queue = layerDevice.getQueue();
+        VkSwapchainKHR swapchain;
+        {
+            //the counter has to see the allocations of the layer for a count of 0 to mean anything
+            vkBasalt::test::AllocationCounter allocationCounter;
+            swapchain = layerDevice.createSwapchain({1920, 1080});
+            CHECK(allocationCounter.getCount() > 0);
+        }
+        for(uint32_t i=0;i<100;i++)
+        {
+            CHECK(layerDevice.present(queue, swapchain, i % 3) == VK_SUCCESS);
+        }
+        uint64_t count;
+        {
+            vkBasalt::test::AllocationCounter allocationCounter;
+            for(uint32_t i=0;i<10000;i++)
+            {
+                layerDevice.present(queue, swapchain, i % 3);
+            }
+            count = allocationCounter.getCount();
+        }
+        CHECK(vkBasalt::mock::stats.effectCommandBuffers == 10100);
+        layerDevice.destroySwapchain(swapchain);
+        return count;
+    }
+}
+
+TEST(presentDoesNotAllocate)
+{
+    CHECK(countSteadyStatePresentAllocations(vkBasalt::mock::DriverConfig()) == 0);
+}
+
+TEST(presentWithoutTimelineSemaphoresDoesNotAllocate)
+{
+    vkBasalt::mock::DriverConfig driverConfig;
+    driverConfig.timelineSemaphores = false;
+    CHECK(countSteadyStatePresentAllocations(driverConfig) == 0);
+}
+
+BENCHMARK(presentContention)
+{
+    const uint32_t presentThreadCount = 4;
+    const uint32_t procThreadCount = 2;
+    const std::chrono::milliseconds duration(1000);
+    LayerDevice layerDevice;
+    std::cout << "    " << presentThreadCount << " present threads, " << procThreadCount << " vkGetDeviceProcAddr threads, "
+              << std::thread::hardware_concurrency() << " cores" << std::endl;
+    std::mutex globalLock;
+    report("one global lock", runConcurrentPresents(layerDevice, presentThreadCount, procThreadCount, duration, &globalLock), presentThreadCount, duration);
+    report("per device and swapchain locks", runConcurrentPresents(layerDevice, presentThreadCount, procThreadCount, duration, nullptr), presentThreadCount, duration);
+}
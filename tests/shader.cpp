@@ -0,0 +1,41 @@
+#include "test.hpp"
+
+#include <string>
+#include <stdexcept>
+
+#include "shader.hpp"
+
+namespace
+{
+    //every shader the effects load
+    const char* shaderNames[] = {"full_screen_triangle.vert.spv", "cas.frag.spv", "deband.frag.spv", "fxaa.frag.spv", "lut.frag.spv",
+                                 "smaa_edge.vert.spv", "smaa_edge_color.frag.spv", "smaa_edge_luma.frag.spv", "smaa_blend.vert.spv",
+                                 "smaa_blend.frag.spv", "smaa_neighbor.vert.spv", "smaa_neighbor.frag.spv"};
+}
+
+TEST(shaderCodeIsEmbedded)
+{
+    for(const char* name : shaderNames)
+    {
+        vkBasalt::ShaderCode code = vkBasalt::getShaderCode(name);
+        CHECK(code.pCode != nullptr && code.size != 0 && code.size % 4 == 0);
+        //the SPIR-V magic number, the arrays hold the words in host byte order
+        CHECK(code.pCode[0] == 0x07230203);
+        //the code is not copied, every lookup points to the same array
+        CHECK(vkBasalt::getShaderCode(name).pCode == code.pCode);
+    }
+}
+
+TEST(shaderCodeOfAnUnknownShaderThrows)
+{
+    bool thrown = false;
+    try
+    {
+        vkBasalt::getShaderCode("missing.frag.spv");
+    }
+    catch(const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
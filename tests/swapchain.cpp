@@ -0,0 +1,272 @@
+#include "test.hpp"
+#include "layer_device.hpp"
+
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <iostream>
+
+#include "effect_cas.hpp"
+#include "effect_smaa.hpp"
+
+namespace
+{
+    using vkBasalt::test::LayerDevice;
+    using vkBasalt::mock::ObjectType;
+}
+
+TEST(swapchainRecreationKeepsTheEffectStates)
+{
+    //cas:smaa, a resize only rebuilds what depends on the extent
+    LayerDevice layerDevice;
+    VkQueue queue = layerDevice.getQueue();
+    VkSwapchainKHR swapchain = layerDevice.createSwapchain({1280, 720});
+    CHECK(layerDevice.present(queue, swapchain, 0) == VK_SUCCESS);
+    uint32_t pipelineCount = vkBasalt::mock::getCreatedCount(ObjectType::Pipeline);
+    uint32_t pipelineLayoutCount = vkBasalt::mock::getCreatedCount(ObjectType::PipelineLayout);
+    uint32_t shaderModuleCount = vkBasalt::mock::getCreatedCount(ObjectType::ShaderModule);
+    uint32_t imageCount = vkBasalt::mock::getCreatedCount(ObjectType::Image);
+    uint64_t uploadCount = vkBasalt::mock::stats.uploadCommandBuffers;
+    //the area and search textures of smaa
+    CHECK(uploadCount > 0);
+
+    VkSwapchainKHR newSwapchain = layerDevice.createSwapchain({1920, 1080}, swapchain);
+    layerDevice.destroySwapchain(swapchain);
+    CHECK(layerDevice.present(queue, newSwapchain, 0) == VK_SUCCESS);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::Pipeline) == pipelineCount);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::PipelineLayout) == pipelineLayoutCount);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::ShaderModule) == shaderModuleCount);
+    //the textures are neither created nor uploaded again, the intermediate images are
+    CHECK(vkBasalt::mock::stats.uploadCommandBuffers == uploadCount);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::Image) > imageCount);
+
+    //without the old swapchain there is nothing to take over
+    layerDevice.destroySwapchain(newSwapchain);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::Pipeline) == 0);
+    swapchain = layerDevice.createSwapchain({1920, 1080});
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::Pipeline) == 2 * pipelineCount);
+    layerDevice.destroySwapchain(swapchain);
+}
+
+TEST(swapchainRecreationRebuildsChangedEffects)
+{
+    //the effects are matched by their position in the chain
+    LayerDevice layerDevice;
+    vkBasalt::test::setOption("effects", "cas:smaa");
+    //smaa uploads its textures with the queue
+    layerDevice.getQueue();
+    VkSwapchainKHR swapchain = layerDevice.createSwapchain({1280, 720});
+    //cas has one pipeline, smaa three
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::Pipeline) == 4);
+
+    vkBasalt::test::setOption("effects", "cas:fxaa");
+    VkSwapchainKHR newSwapchain = layerDevice.createSwapchain({1280, 720}, swapchain);
+    layerDevice.destroySwapchain(swapchain);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::Pipeline) == 5);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::Pipeline) == 2);
+    layerDevice.destroySwapchain(newSwapchain);
+}
+
+namespace
+{
+    std::vector<VkImage> getImages(LayerDevice& layerDevice, VkSwapchainKHR swapchain, uint32_t count, VkResult expectedResult)
+    {
+        PFN_vkGetSwapchainImagesKHR getSwapchainImagesKHR = (PFN_vkGetSwapchainImagesKHR) layerDevice.getProcAddr("vkGetSwapchainImagesKHR");
+        std::vector<VkImage> images(count);
+        CHECK(getSwapchainImagesKHR(layerDevice.device, swapchain, &count, images.data()) == expectedResult);
+        CHECK(count == images.size());
+        return images;
+    }
+
+    uint32_t getImageCount(LayerDevice& layerDevice, VkSwapchainKHR swapchain)
+    {
+        PFN_vkGetSwapchainImagesKHR getSwapchainImagesKHR = (PFN_vkGetSwapchainImagesKHR) layerDevice.getProcAddr("vkGetSwapchainImagesKHR");
+        uint32_t count = 0;
+        CHECK(getSwapchainImagesKHR(layerDevice.device, swapchain, &count, nullptr) == VK_SUCCESS);
+        return count;
+    }
+
+    //the created counts of every object type, a query that builds nothing leaves them alone
+    std::vector<uint32_t> getCreatedCounts()
+    {
+        std::vector<uint32_t> counts;
+        for(uint32_t i=0;i<(uint32_t) ObjectType::Count;i++)
+        {
+            counts.push_back(vkBasalt::mock::getCreatedCount((ObjectType) i));
+        }
+        return counts;
+    }
+}
+
+TEST(swapchainImagesAreBuiltOnce)
+{
+    LayerDevice layerDevice;
+    VkQueue queue = layerDevice.getQueue();
+    VkSwapchainKHR swapchain = layerDevice.createSwapchain({1280, 720}, VK_NULL_HANDLE, false);
+
+    //the count comes from the driver and builds nothing
+    CHECK(getImageCount(layerDevice, swapchain) == 3);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::Pipeline) == 0);
+
+    std::vector<VkImage> partial = getImages(layerDevice, swapchain, 2, VK_INCOMPLETE);
+    std::vector<uint32_t> counts = getCreatedCounts();
+    CHECK(counts[(uint32_t) ObjectType::Pipeline] != 0);
+
+    std::vector<VkImage> images = getImages(layerDevice, swapchain, 3, VK_SUCCESS);
+    CHECK(images[0] == partial[0] && images[1] == partial[1]);
+    //an array bigger than the swapchain gets the real count
+    PFN_vkGetSwapchainImagesKHR getSwapchainImagesKHR = (PFN_vkGetSwapchainImagesKHR) layerDevice.getProcAddr("vkGetSwapchainImagesKHR");
+    uint32_t count = 4;
+    VkImage bigger[4];
+    CHECK(getSwapchainImagesKHR(layerDevice.device, swapchain, &count, bigger) == VK_SUCCESS);
+    CHECK(count == 3 && std::vector<VkImage>(bigger, bigger + 3) == images);
+    CHECK(getImages(layerDevice, swapchain, 3, VK_SUCCESS) == images);
+    CHECK(getCreatedCounts() == counts);
+
+    CHECK(layerDevice.present(queue, swapchain, 2) == VK_SUCCESS);
+    layerDevice.destroySwapchain(swapchain);
+}
+
+TEST(swapchainEffectsAreBuiltBeforeTheFirstPresent)
+{
+    //an application that never asks for the images still gets its effects
+    LayerDevice layerDevice;
+    VkQueue queue = layerDevice.getQueue();
+    VkSwapchainKHR swapchain = layerDevice.createSwapchain({1280, 720}, VK_NULL_HANDLE, false);
+    CHECK(layerDevice.present(queue, swapchain, 0) == VK_SUCCESS);
+    CHECK(vkBasalt::mock::stats.effectCommandBuffers == 1);
+    std::vector<uint32_t> counts = getCreatedCounts();
+    getImages(layerDevice, swapchain, 3, VK_SUCCESS);
+    CHECK(getCreatedCounts() == counts);
+    layerDevice.destroySwapchain(swapchain);
+}
+
+namespace
+{
+    //cas:smaa has four pipelines, so the background build takes at least 200 ms
+    vkBasalt::mock::DriverConfig slowCompileConfig()
+    {
+        vkBasalt::mock::DriverConfig driverConfig;
+        driverConfig.pipelineCompileTime = std::chrono::milliseconds(50);
+        return driverConfig;
+    }
+}
+
+TEST(swapchainCopiesUntilTheAsyncBuildIsReady)
+{
+    LayerDevice layerDevice(slowCompileConfig());
+    vkBasalt::test::setOption("asyncEffectBuild", "true");
+    VkQueue queue = layerDevice.getQueue();
+    VkSwapchainKHR swapchain = layerDevice.createSwapchain({1280, 720});
+    CHECK(layerDevice.present(queue, swapchain, 0) == VK_SUCCESS);
+    CHECK(vkBasalt::mock::stats.copyCommandBuffers == 1 && vkBasalt::mock::stats.effectCommandBuffers == 0);
+
+    uint32_t presentCount = 1;
+    while(vkBasalt::mock::stats.effectCommandBuffers == 0 && presentCount < 5000)
+    {
+        CHECK(layerDevice.present(queue, swapchain, presentCount % 3) == VK_SUCCESS);
+        presentCount++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    //every frame was either copied or processed, the switch happened once
+    CHECK(vkBasalt::mock::stats.effectCommandBuffers == 1);
+    CHECK(vkBasalt::mock::stats.copyCommandBuffers + vkBasalt::mock::stats.effectCommandBuffers == presentCount);
+    //the textures of smaa went to the driver with the first processed frame at the latest
+    CHECK(vkBasalt::mock::stats.uploadCommandBuffers > 0);
+
+    uint64_t copyCount = vkBasalt::mock::stats.copyCommandBuffers;
+    for(uint32_t i=0;i<10;i++)
+    {
+        CHECK(layerDevice.present(queue, swapchain, i % 3) == VK_SUCCESS);
+    }
+    CHECK(vkBasalt::mock::stats.copyCommandBuffers == copyCount);
+    CHECK(vkBasalt::mock::stats.effectCommandBuffers == 11);
+    layerDevice.destroySwapchain(swapchain);
+}
+
+TEST(swapchainIsDestroyedDuringTheAsyncBuild)
+{
+    LayerDevice layerDevice(slowCompileConfig());
+    vkBasalt::test::setOption("asyncEffectBuild", "true");
+    VkQueue queue = layerDevice.getQueue();
+
+    //a resize while the build of the old swapchain still runs takes its effects over once they are done
+    VkSwapchainKHR swapchain = layerDevice.createSwapchain({1280, 720});
+    VkSwapchainKHR newSwapchain = layerDevice.createSwapchain({1920, 1080}, swapchain);
+    layerDevice.destroySwapchain(swapchain);
+    CHECK(layerDevice.present(queue, newSwapchain, 0) == VK_SUCCESS);
+    layerDevice.destroySwapchain(newSwapchain);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::Pipeline) == 4);
+
+    //a swapchain that is gone before its build finished
+    swapchain = layerDevice.createSwapchain({1280, 720});
+    CHECK(layerDevice.present(queue, swapchain, 0) == VK_SUCCESS);
+    layerDevice.destroySwapchain(swapchain);
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::Pipeline) == 8);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::Pipeline) == 0);
+}
+
+TEST(swapchainWithoutTransferDstCanNotCopy)
+{
+    //the copy needs TRANSFER_DST on the swapchain images, without it the effects are always built right away
+    vkBasalt::mock::DriverConfig driverConfig = slowCompileConfig();
+    driverConfig.surfaceUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    LayerDevice layerDevice(driverConfig);
+    vkBasalt::test::setOption("asyncEffectBuild", "true");
+    VkQueue queue = layerDevice.getQueue();
+    VkSwapchainKHR swapchain = layerDevice.createSwapchain({1280, 720});
+    CHECK((vkBasalt::mock::stats.swapchainUsage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) == 0);
+    CHECK(layerDevice.present(queue, swapchain, 0) == VK_SUCCESS);
+    CHECK(vkBasalt::mock::stats.copyCommandBuffers == 0 && vkBasalt::mock::stats.effectCommandBuffers == 1);
+    layerDevice.destroySwapchain(swapchain);
+
+    vkBasalt::mock::config.surfaceUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    swapchain = layerDevice.createSwapchain({1280, 720}, VK_NULL_HANDLE, false);
+    CHECK((vkBasalt::mock::stats.swapchainUsage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0);
+    layerDevice.destroySwapchain(swapchain);
+}
+
+TEST(swapchainWithoutTimelineSemaphoresIsFreedOnceTheQueuesAreIdle)
+{
+    //nothing tells the layer when the last frame finished, so the effects and fake images stay until the application idles the queues
+    vkBasalt::mock::DriverConfig driverConfig;
+    driverConfig.timelineSemaphores = false;
+    LayerDevice layerDevice(driverConfig);
+    VkQueue queue = layerDevice.getQueue();
+    VkQueue otherQueue = layerDevice.getQueue(0, 1);
+    VkSwapchainKHR swapchain = layerDevice.createSwapchain({1280, 720});
+    CHECK(layerDevice.present(queue, swapchain, 0) == VK_SUCCESS);
+    layerDevice.destroySwapchain(swapchain);
+    uint32_t imageCount = vkBasalt::mock::getAliveCount(ObjectType::Image);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::Pipeline) > 0);
+    PFN_vkQueueWaitIdle queueWaitIdle = (PFN_vkQueueWaitIdle) layerDevice.getProcAddr("vkQueueWaitIdle");
+    CHECK(queueWaitIdle(queue) == VK_SUCCESS);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::Image) == imageCount);
+    CHECK(queueWaitIdle(otherQueue) == VK_SUCCESS);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::Image) < imageCount);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::Pipeline) == 0);
+
+    //vkDeviceWaitIdle covers every queue at once
+    swapchain = layerDevice.createSwapchain({1280, 720});
+    CHECK(layerDevice.present(queue, swapchain, 0) == VK_SUCCESS);
+    layerDevice.destroySwapchain(swapchain);
+    PFN_vkDeviceWaitIdle deviceWaitIdle = (PFN_vkDeviceWaitIdle) layerDevice.getProcAddr("vkDeviceWaitIdle");
+    CHECK(deviceWaitIdle(layerDevice.device) == VK_SUCCESS);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::Pipeline) == 0);
+}
+
+BENCHMARK(swapchainCreation)
+{
+    //cas:smaa, every swapchain builds its effects when the images are fetched and uploads the smaa textures with the queue
+    const uint32_t swapchainCount = 1000;
+    LayerDevice layerDevice;
+    layerDevice.getQueue();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(uint32_t i=0;i<swapchainCount;i++)
+    {
+        layerDevice.destroySwapchain(layerDevice.createSwapchain({1920, 1080}));
+    }
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "    " << milliseconds / swapchainCount << " ms to create and destroy a swapchain" << std::endl;
+    std::cout << "    sizeof(CasEffect) " << sizeof(vkBasalt::CasEffect) << ", sizeof(SmaaEffect) " << sizeof(vkBasalt::SmaaEffect) << std::endl;
+}
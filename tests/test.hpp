@@ -0,0 +1,58 @@
+#ifndef TEST_HPP_INCLUDED
+#define TEST_HPP_INCLUDED
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+
+namespace vkBasalt
+{
+    namespace test
+    {
+        //thrown by CHECK, the runner reports it and goes on with the next test
+        class Failure : public std::runtime_error
+        {
+        public:
+            Failure(const char* file, int line, const char* condition)
+                : std::runtime_error(std::string(file) + ":" + std::to_string(line) + ": CHECK(" + condition + ") failed")
+            {
+            }
+        };
+
+        struct TestCase
+        {
+            const char* name;
+            void (*function)();
+            bool benchmark;//only runs with --benchmark or by name, the numbers are reported and not checked
+        };
+
+        std::vector<TestCase>& getTestCases();
+
+        //the static registrations of TEST and BENCHMARK add the cases before main runs
+        struct Registration
+        {
+            Registration(const char* name, void (*function)(), bool benchmark)
+            {
+                getTestCases().push_back({name, function, benchmark});
+            }
+        };
+    }
+}
+
+#define TEST(name)\
+        static void name();\
+        static vkBasalt::test::Registration name##Registration(#name, name, false);\
+        static void name()
+
+#define BENCHMARK(name)\
+        static void name();\
+        static vkBasalt::test::Registration name##Registration(#name, name, true);\
+        static void name()
+
+#define CHECK(condition)\
+        if(!(condition))\
+        {\
+            throw vkBasalt::test::Failure(__FILE__, __LINE__, #condition);\
+        }
+
+#endif // TEST_HPP_INCLUDED
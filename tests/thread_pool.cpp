@@ -0,0 +1,79 @@
+#include "test.hpp"
+#include "layer_device.hpp"
+
+#include <memory>
+#include <atomic>
+#include <stdexcept>
+
+#include "thread_pool.hpp"
+
+namespace
+{
+    using vkBasalt::test::LayerDevice;
+    using vkBasalt::mock::ObjectType;
+}
+
+TEST(threadPoolDropsTheTaskBeforeTheFutureIsReady)
+{
+    //the effect builds capture the old effect states, the swapchain has to hold the last reference once it waited
+    vkBasalt::ThreadPool threadPool(4);
+    for(uint32_t i=0;i<1000;i++)
+    {
+        std::shared_ptr<uint32_t> pCaptured = std::make_shared<uint32_t>(i);
+        std::future<void> future = threadPool.submit([pCaptured]()
+        {
+        });
+        future.wait();
+        CHECK(pCaptured.use_count() == 1);
+    }
+}
+
+TEST(threadPoolRethrowsAndRunsEveryTask)
+{
+    std::atomic<uint32_t> runCount{0};
+    std::vector<std::future<void>> futures;
+    {
+        vkBasalt::ThreadPool threadPool(4);
+        for(uint32_t i=0;i<100;i++)
+        {
+            futures.push_back(threadPool.submit([i, &runCount]()
+            {
+                runCount++;
+                if(i % 10 == 0)
+                {
+                    throw std::runtime_error("task failed");
+                }
+            }));
+        }
+        //the destructor runs what is still queued
+    }
+    CHECK(runCount == 100);
+    uint32_t throwCount = 0;
+    for(std::future<void>& future : futures)
+    {
+        try
+        {
+            future.get();
+        }
+        catch(const std::runtime_error&)
+        {
+            throwCount++;
+        }
+    }
+    CHECK(throwCount == 10);
+}
+
+TEST(threadPoolBuildsTheEffectsOfAChain)
+{
+    //every effect of the chain is built by its own task, cas twice to have two builds share cached objects
+    LayerDevice layerDevice;
+    vkBasalt::test::setOption("effects", "cas:smaa:fxaa:deband:cas");
+    VkQueue queue = layerDevice.getQueue();
+    VkSwapchainKHR swapchain = layerDevice.createSwapchain({1920, 1080});
+    CHECK(vkBasalt::mock::getCreatedCount(ObjectType::Pipeline) == 7);
+    CHECK(layerDevice.present(queue, swapchain, 0) == VK_SUCCESS);
+    CHECK(vkBasalt::mock::stats.effectCommandBuffers == 1);
+    layerDevice.destroySwapchain(swapchain);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::Pipeline) == 0);
+    CHECK(vkBasalt::mock::getAliveCount(ObjectType::ShaderModule) == 0);
+}